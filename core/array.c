@@ -78,11 +78,14 @@ void de_array_free_(void** data, size_t* size, size_t* capacity)
 
 void de_array_reverse_(void** data, size_t* size, size_t item_size)
 {
+	if (*size < 2) {
+		return;
+	}
 	char* swapBuffer = de_malloc(item_size);
 	size_t i = *size - 1, j = 0;
 	while (i > j) {
-		void* right = (char*)*data + i;
-		void* left = (char*)*data + j;
+		void* right = (char*)*data + i * item_size;
+		void* left = (char*)*data + j * item_size;
 		memcpy(swapBuffer, right, item_size);
 		memcpy(right, left, item_size);
 		memcpy(left, swapBuffer, item_size);
@@ -70,8 +70,13 @@
 
 #define DE_ARRAY_RESERVE(a, new_capacity) de_array_reserve_((void**)&(a).data, &(a).size, &(a)._capacity, sizeof(*(a).data), new_capacity);
 
-/* Sorts array using quick sort */
-#define DE_ARRAY_QSORT(a, cmp) qsort((a).data, (a).size, sizeof(*(a).data), cmp)
+/* Sorts array using quick sort. Empty array may have NULL data, which must not be passed to qsort */
+#define DE_ARRAY_QSORT(a, cmp) \
+	do { \
+		if ((a).size) { \
+			qsort((a).data, (a).size, sizeof(*(a).data), cmp); \
+		} \
+	} while(0)
 
 #define DE_ARRAY_BSEARCH(a, key, cmp) bsearch(key, (a).data, (a).size, sizeof(*(a).data), cmp)
 
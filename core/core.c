@@ -24,6 +24,7 @@ struct de_core_t {
 	de_renderer_t* renderer;
 	de_sound_context_t* sound_context;
 	de_gui_t* gui;
+	de_thread_pool_t* thread_pool;
 	DE_LINKED_LIST_DECLARE(de_scene_t, scenes);
 	DE_LINKED_LIST_DECLARE(de_font_t, fonts);
 	de_core_config_t params;
@@ -149,6 +150,11 @@ de_core_t* de_core_init(const de_core_config_t* params)
 	core->gui = de_gui_init(core);
 	de_log("gui initialized in %f seconds", de_time_get_seconds() - last_time);
 
+	last_time = de_time_get_seconds();
+	core->thread_pool = de_thread_pool_create(0);
+	de_log("thread pool with %d threads initialized in %f seconds",
+		(int)de_thread_pool_get_thread_count(core->thread_pool), de_time_get_seconds() - last_time);
+
 	return core;
 }
 
@@ -160,6 +166,7 @@ void de_core_shutdown(de_core_t* core)
 	de_sound_context_free(core->sound_context);
 	de_gui_shutdown(core->gui);
 	de_renderer_free(core->renderer);
+	de_thread_pool_free(core->thread_pool);
 	/* Notify about unreleased resources */
 	for (size_t i = 0; i < core->resources.size; ++i) {
 		de_resource_t* res = core->resources.data[i];
@@ -223,6 +230,11 @@ de_sound_context_t* de_core_get_sound_context(de_core_t* core)
 	return core->sound_context;
 }
 
+de_thread_pool_t* de_core_get_thread_pool(de_core_t* core)
+{
+	return core->thread_pool;
+}
+
 void de_core_push_event(de_core_t* core, const de_event_t* evt)
 {
 	DE_ARRAY_APPEND(core->events_queue, *evt);
@@ -86,6 +86,12 @@ de_gui_t* de_core_get_gui(de_core_t* core);
  */
 de_sound_context_t* de_core_get_sound_context(de_core_t* core);
 
+/**
+ * @brief Returns thread pool of the core. Jobs can be submitted to it from any thread at once, including
+ * from inside of other jobs (scene update, physics and ray casts do so), see core/thread_pool.h.
+ */
+de_thread_pool_t* de_core_get_thread_pool(de_core_t* core);
+
 /**
  * @brief Pushes new event into event queue. Can be used to inject custom input
  * into message queue.
@@ -19,7 +19,8 @@
 * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
 * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
 
-static int de_alloc_count;
+/* Updated atomically, memory can be allocated from worker threads. */
+static volatile long de_alloc_count;
 
 void* de_malloc(size_t size)
 {
@@ -31,7 +32,7 @@ void* de_malloc(size_t size)
 		de_fatal_error("Failed to allocate %d bytes of memory!", size);
 	}
 
-	++de_alloc_count;
+	de_atomic_add(&de_alloc_count, 1);
 
 	return mem;
 }
@@ -46,7 +47,7 @@ void* de_calloc(size_t count, size_t size)
 		de_fatal_error("Failed to allocate %d bytes of clean memory!", count * size);
 	}
 
-	++de_alloc_count;
+	de_atomic_add(&de_alloc_count, 1);
 
 	return mem;
 }
@@ -56,7 +57,7 @@ void* de_realloc(void* ptr, size_t size)
 	void* mem;
 
 	if (ptr == NULL && size > 0) {
-		++de_alloc_count;
+		de_atomic_add(&de_alloc_count, 1);
 	}
 
 	mem = realloc(ptr, size);
@@ -66,7 +67,7 @@ void* de_realloc(void* ptr, size_t size)
 			de_fatal_error("Failed to reallocate %d bytes of memory!", size);
 		}
 	} else {
-		--de_alloc_count;
+		de_atomic_add(&de_alloc_count, -1);
 	}
 
 	return mem;
@@ -75,14 +76,14 @@ void* de_realloc(void* ptr, size_t size)
 void de_free(void* ptr)
 {
 	if (ptr) {
-		--de_alloc_count;
+		de_atomic_add(&de_alloc_count, -1);
 	}
 	free(ptr);
 }
 
 size_t de_get_alloc_count()
 {
-	return de_alloc_count;
+	return (size_t)de_alloc_count;
 }
 
 void de_zero(void* data, size_t size)
@@ -19,14 +19,30 @@
 * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
 * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
 
-static float de_pathfinder_heuristic(de_graph_vertex_t* a, de_graph_vertex_t* b)
+static float de_pathfinder_heuristic(const de_graph_vertex_t* a, const de_graph_vertex_t* b)
 {
 	return de_vec3_sqr_distance(&a->position, &b->position);
 }
 
+void de_graph_search_context_init(de_graph_search_context_t* context)
+{
+	DE_ARRAY_INIT(context->states);
+	DE_ARRAY_INIT(context->open_set);
+	context->generation = 0;
+}
+
+void de_graph_search_context_free(de_graph_search_context_t* context)
+{
+	DE_ARRAY_FREE(context->states);
+	DE_ARRAY_FREE(context->open_set);
+}
+
 void de_graph_init(de_graph_t* graph)
 {
 	DE_ARRAY_INIT(graph->vertices);
+	de_graph_search_context_init(&graph->context);
+	graph->is_baked = false;
+	de_zero(&graph->baked, sizeof(graph->baked));
 }
 
 void de_graph_free(de_graph_t* graph)
@@ -35,132 +51,438 @@ void de_graph_free(de_graph_t* graph)
 		DE_ARRAY_FREE(graph->vertices.data[i].neighbours);
 	}
 	DE_ARRAY_FREE(graph->vertices);
+	de_graph_search_context_free(&graph->context);
+	de_free(graph->baked.position_x);
+	de_free(graph->baked.position_y);
+	de_free(graph->baked.position_z);
+	de_free(graph->baked.edge_offsets);
+	de_free(graph->baked.edge_targets);
+	de_free(graph->baked.edge_costs);
 }
 
-static void de_graph_reconstruct_path(de_graph_vertex_t* from, de_graph_path_t* out_path)
+void de_graph_bake(de_graph_t* graph)
 {
-	DE_ARRAY_APPEND(*out_path, from);
-	while (from->parent) {
-		from = from->parent;
-		DE_ARRAY_APPEND(*out_path, from);
+	DE_ASSERT(graph);
+	DE_ASSERT(!graph->is_baked);
+	DE_ASSERT(graph->vertices.size < UINT32_MAX);
+
+	de_graph_baked_t* baked = &graph->baked;
+	const size_t vertex_count = graph->vertices.size;
+
+	size_t edge_count = 0;
+	for (size_t i = 0; i < vertex_count; ++i) {
+		edge_count += graph->vertices.data[i].neighbours.size;
+	}
+	DE_ASSERT(edge_count < UINT32_MAX);
+
+	baked->vertex_count = vertex_count;
+	baked->edge_count = edge_count;
+	baked->position_x = de_malloc(vertex_count * sizeof(float));
+	baked->position_y = de_malloc(vertex_count * sizeof(float));
+	baked->position_z = de_malloc(vertex_count * sizeof(float));
+	baked->edge_offsets = de_malloc((vertex_count + 1) * sizeof(uint32_t));
+	baked->edge_targets = de_malloc((edge_count ? edge_count : 1) * sizeof(uint32_t));
+	baked->edge_costs = de_malloc((edge_count ? edge_count : 1) * sizeof(float));
+
+	uint32_t edge = 0;
+	for (size_t i = 0; i < vertex_count; ++i) {
+		de_graph_vertex_t* vertex = graph->vertices.data + i;
+		baked->position_x[i] = vertex->position.x;
+		baked->position_y[i] = vertex->position.y;
+		baked->position_z[i] = vertex->position.z;
+		baked->edge_offsets[i] = edge;
+		for (size_t k = 0; k < vertex->neighbours.size; ++k) {
+			const de_graph_vertex_t* neighbour = vertex->neighbours.data[k];
+			baked->edge_targets[edge] = (uint32_t)(neighbour - graph->vertices.data);
+			baked->edge_costs[edge] = de_pathfinder_heuristic(vertex, neighbour);
+			++edge;
+		}
+		/* Builder data is not needed anymore */
+		DE_ARRAY_FREE(vertex->neighbours);
+		vertex->is_baked = true;
 	}
+	baked->edge_offsets[vertex_count] = edge;
+
+	graph->is_baked = true;
 }
 
-de_graph_path_type_t de_graph_find_path(de_graph_t* graph, de_graph_vertex_t* start, de_graph_vertex_t* goal, de_graph_path_t* out_path)
+static void de_graph_reconstruct_path(const de_graph_t* graph, const de_graph_search_context_t* context, uint32_t from, de_graph_path_t* out_path)
 {
-	if (!start || !goal || graph->vertices.size == 0) {
-		return DE_GRAPH_PATH_TYPE_EMPTY;
+	DE_ARRAY_APPEND(*out_path, &graph->vertices.data[from]);
+	while (context->states.data[from].parent != UINT32_MAX) {
+		from = context->states.data[from].parent;
+		DE_ARRAY_APPEND(*out_path, &graph->vertices.data[from]);
 	}
+}
+
+/**
+ * Open set is an indexed binary min-heap: each vertex state knows its position in heap, so
+ * f_score of a vertex can be decreased in O(log n) without searching it in the heap.
+ */
+static void de_graph_open_set_swap(de_graph_search_context_t* context, uint32_t a, uint32_t b)
+{
+	const uint32_t vertex_a = context->open_set.data[a];
+	const uint32_t vertex_b = context->open_set.data[b];
+	context->open_set.data[a] = vertex_b;
+	context->open_set.data[b] = vertex_a;
+	context->states.data[vertex_b].heap_index = a;
+	context->states.data[vertex_a].heap_index = b;
+}
 
-	DE_ARRAY_CLEAR(*out_path);
+static float de_graph_open_set_f_score(const de_graph_search_context_t* context, uint32_t i)
+{
+	return context->states.data[context->open_set.data[i]].f_score;
+}
 
-	/* reset vertices */
-	for (size_t i = 0; i < graph->vertices.size; ++i) {
-		de_graph_vertex_t* vertex = graph->vertices.data + i;
-		vertex->g_score = FLT_MAX;
-		vertex->f_score = FLT_MAX;
-		vertex->flags = DE_GRAPH_VERTEX_FLAGS_NON_VISITED;
-		vertex->parent = NULL;
-	}
-
-	int open_set_size = 1;
-	start->flags |= DE_GRAPH_VERTEX_FLAGS_IS_OPEN;
-	start->g_score = 0;
-	start->f_score = de_pathfinder_heuristic(start, goal);
-
-	while (open_set_size > 0) {
-		de_graph_vertex_t* current = NULL;
-		for (size_t i = 0; i < graph->vertices.size; ++i) {
-			de_graph_vertex_t* vertex = graph->vertices.data + i;
-			if (vertex->flags & DE_GRAPH_VERTEX_FLAGS_IS_OPEN) {
-				if (!current) {
-					current = vertex;
-				}
-				if (vertex->f_score < current->f_score) {
-					current = vertex;
-				}
-			}
+static void de_graph_open_set_sift_up(de_graph_search_context_t* context, uint32_t i)
+{
+	while (i > 0) {
+		const uint32_t parent = (i - 1) / 2;
+		if (de_graph_open_set_f_score(context, parent) <= de_graph_open_set_f_score(context, i)) {
+			break;
 		}
+		de_graph_open_set_swap(context, parent, i);
+		i = parent;
+	}
+}
 
-		DE_ASSERT(current);
+static void de_graph_open_set_sift_down(de_graph_search_context_t* context, uint32_t i)
+{
+	const uint32_t size = (uint32_t)context->open_set.size;
+	for (;;) {
+		const uint32_t left = 2 * i + 1;
+		const uint32_t right = left + 1;
+		uint32_t smallest = i;
+		if (left < size && de_graph_open_set_f_score(context, left) < de_graph_open_set_f_score(context, smallest)) {
+			smallest = left;
+		}
+		if (right < size && de_graph_open_set_f_score(context, right) < de_graph_open_set_f_score(context, smallest)) {
+			smallest = right;
+		}
+		if (smallest == i) {
+			break;
+		}
+		de_graph_open_set_swap(context, smallest, i);
+		i = smallest;
+	}
+}
 
-		if (current == goal) {
-			de_graph_reconstruct_path(current, out_path);
-			return DE_GRAPH_PATH_TYPE_FULL;
+static void de_graph_open_set_push(de_graph_search_context_t* context, uint32_t vertex)
+{
+	const uint32_t heap_index = (uint32_t)context->open_set.size;
+	context->states.data[vertex].heap_index = heap_index;
+	DE_ARRAY_APPEND(context->open_set, vertex);
+	de_graph_open_set_sift_up(context, heap_index);
+}
+
+static uint32_t de_graph_open_set_pop(de_graph_search_context_t* context)
+{
+	const uint32_t top = context->open_set.data[0];
+	const uint32_t last = DE_ARRAY_POP(context->open_set);
+	if (context->open_set.size > 0) {
+		context->open_set.data[0] = last;
+		context->states.data[last].heap_index = 0;
+		de_graph_open_set_sift_down(context, 0);
+	}
+	return top;
+}
+
+/**
+ * Returns state of vertex for current search. Vertices which was not touched by current
+ * search are treated as non visited.
+ */
+static de_graph_search_state_t* de_graph_search_state(de_graph_search_context_t* context, uint32_t vertex)
+{
+	de_graph_search_state_t* state = context->states.data + vertex;
+	if (state->generation != context->generation) {
+		state->generation = context->generation;
+		state->g_score = FLT_MAX;
+		state->f_score = FLT_MAX;
+		state->flags = DE_GRAPH_VERTEX_FLAGS_NON_VISITED;
+		state->parent = UINT32_MAX;
+	}
+	return state;
+}
+
+static void de_graph_search_context_begin(de_graph_search_context_t* context, size_t vertex_count)
+{
+	DE_ARRAY_CLEAR(context->open_set);
+
+	/* New vertices could be added to graph since last search */
+	if (context->states.size < vertex_count) {
+		const size_t old_size = context->states.size;
+		DE_ARRAY_GROW(context->states, vertex_count - old_size);
+		for (size_t i = old_size; i < vertex_count; ++i) {
+			context->states.data[i].generation = 0;
+		}
+	}
+
+	/* Generation counter can wrap around after ~4 billion searches, in this rare case we
+	 * have to do full reset so old stamps won't be confused with new ones. */
+	++context->generation;
+	if (context->generation == 0) {
+		for (size_t i = 0; i < context->states.size; ++i) {
+			context->states.data[i].generation = 0;
 		}
+		context->generation = 1;
+	}
+}
+
+typedef struct de_graph_search_t {
+	de_graph_search_context_t* context;
+	const uint32_t* regions; /**< Optional, search is limited to vertices with regions[i] == region. */
+	uint32_t region;
+	uint32_t goal; /**< UINT32_MAX for search without goal (flood fill). */
+	de_vec3_t goal_position;
+	uint32_t closest; /**< Vertex with lowest f_score, used to build partial path when goal is unreachable. */
+	float closest_f_score;
+} de_graph_search_t;
+
+/**
+ * Tries to improve path to neighbour through current vertex.
+ */
+static void de_graph_search_relax(de_graph_search_t* search, uint32_t current, float current_g_score,
+	uint32_t neighbour, float edge_cost, const de_vec3_t* neighbour_position)
+{
+	if (search->regions && search->regions[neighbour] != search->region) {
+		return;
+	}
+
+	de_graph_search_context_t* context = search->context;
+	de_graph_search_state_t* neighbour_state = de_graph_search_state(context, neighbour);
+
+	if (neighbour_state->flags & DE_GRAPH_VERTEX_FLAGS_IS_CLOSED) {
+		return;
+	}
+
+	const float gScore = current_g_score + edge_cost;
+
+	if (gScore >= neighbour_state->g_score) {
+		return;
+	}
+
+	neighbour_state->parent = current;
+	neighbour_state->g_score = gScore;
+	neighbour_state->f_score = gScore;
+	if (search->goal != UINT32_MAX) {
+		neighbour_state->f_score += de_vec3_sqr_distance(neighbour_position, &search->goal_position);
+	}
+
+	if (neighbour_state->f_score < search->closest_f_score) {
+		search->closest = neighbour;
+		search->closest_f_score = neighbour_state->f_score;
+	}
+
+	if (neighbour_state->flags & DE_GRAPH_VERTEX_FLAGS_IS_OPEN) {
+		/* f_score can only decrease here */
+		de_graph_open_set_sift_up(context, neighbour_state->heap_index);
+	} else {
+		neighbour_state->flags |= DE_GRAPH_VERTEX_FLAGS_IS_OPEN;
+		de_graph_open_set_push(context, neighbour);
+	}
+}
+
+/**
+ * A* search from start to goal, or Dijkstra flood fill from start when goal is UINT32_MAX.
+ */
+static de_graph_path_type_t de_graph_search(const de_graph_t* graph, de_graph_search_context_t* context,
+	const uint32_t* regions, uint32_t region, uint32_t start_index, uint32_t goal_index, de_graph_path_t* out_path)
+{
+	DE_ASSERT(context);
+	DE_ASSERT(graph->vertices.size < UINT32_MAX);
+	DE_ASSERT(start_index < graph->vertices.size);
 
-		current->flags &= ~DE_GRAPH_VERTEX_FLAGS_IS_OPEN;
-		current->flags |= DE_GRAPH_VERTEX_FLAGS_IS_CLOSED;
-		--open_set_size;
+	if (out_path) {
+		DE_ARRAY_CLEAR(*out_path);
+	}
 
-		for (size_t i = 0; i < current->neighbours.size; ++i) {
-			de_graph_vertex_t* neighbour = current->neighbours.data[i];
+	de_graph_search_context_begin(context, graph->vertices.size);
+
+	de_graph_search_t search = {
+		.context = context,
+		.regions = regions,
+		.region = region,
+		.goal = goal_index,
+		.closest = start_index,
+	};
+
+	de_graph_search_state_t* start_state = de_graph_search_state(context, start_index);
+	start_state->flags |= DE_GRAPH_VERTEX_FLAGS_IS_OPEN;
+	start_state->g_score = 0;
+	start_state->f_score = 0;
+	if (goal_index != UINT32_MAX) {
+		search.goal_position = graph->vertices.data[goal_index].position;
+		start_state->f_score = de_vec3_sqr_distance(&graph->vertices.data[start_index].position, &search.goal_position);
+	}
+	search.closest_f_score = start_state->f_score;
+	de_graph_open_set_push(context, start_index);
 
-			DE_ASSERT(neighbour != current);
+	const de_graph_baked_t* baked = &graph->baked;
 
-			if (neighbour->flags & DE_GRAPH_VERTEX_FLAGS_IS_CLOSED) {
-				continue;
+	while (context->open_set.size > 0) {
+		const uint32_t current_index = de_graph_open_set_pop(context);
+
+		if (current_index == search.goal) {
+			if (out_path) {
+				de_graph_reconstruct_path(graph, context, current_index, out_path);
 			}
+			return DE_GRAPH_PATH_TYPE_FULL;
+		}
 
-			neighbour->flags |= DE_GRAPH_VERTEX_FLAGS_IS_OPEN;
-			++open_set_size;
+		de_graph_search_state_t* current_state = context->states.data + current_index;
+		current_state->flags &= ~DE_GRAPH_VERTEX_FLAGS_IS_OPEN;
+		current_state->flags |= DE_GRAPH_VERTEX_FLAGS_IS_CLOSED;
+		const float current_g_score = current_state->g_score;
 
-			const float gScore = current->g_score + de_pathfinder_heuristic(current, neighbour);
+		if (graph->is_baked) {
+			const uint32_t edge_end = baked->edge_offsets[current_index + 1];
+			for (uint32_t edge = baked->edge_offsets[current_index]; edge < edge_end; ++edge) {
+				const uint32_t neighbour_index = baked->edge_targets[edge];
 
-			if (gScore >= neighbour->g_score) {
-				continue;
+				DE_ASSERT(neighbour_index != current_index);
+
+				const de_vec3_t neighbour_position = {
+					baked->position_x[neighbour_index],
+					baked->position_y[neighbour_index],
+					baked->position_z[neighbour_index]
+				};
+				de_graph_search_relax(&search, current_index, current_g_score, neighbour_index, baked->edge_costs[edge], &neighbour_position);
 			}
+		} else {
+			const de_graph_vertex_t* current = graph->vertices.data + current_index;
+			for (size_t i = 0; i < current->neighbours.size; ++i) {
+				const de_graph_vertex_t* neighbour = current->neighbours.data[i];
+
+				DE_ASSERT(neighbour != current);
 
-			neighbour->parent = current;
-			neighbour->g_score = gScore;
-			neighbour->f_score = gScore + de_pathfinder_heuristic(neighbour, goal);
+				const uint32_t neighbour_index = (uint32_t)(neighbour - graph->vertices.data);
+				de_graph_search_relax(&search, current_index, current_g_score, neighbour_index, de_pathfinder_heuristic(current, neighbour), &neighbour->position);
+			}
 		}
 	}
 
-	de_graph_vertex_t* current = graph->vertices.data;
-	for (size_t i = 0; i < graph->vertices.size; ++i) {
-		de_graph_vertex_t* vertex = graph->vertices.data + i;
-		if (vertex->f_score < current->f_score) {
-			current = vertex;
-		}
+	if (!out_path) {
+		return DE_GRAPH_PATH_TYPE_PARTIAL;
 	}
 
-	de_graph_reconstruct_path(current, out_path);
+	de_graph_reconstruct_path(graph, context, search.closest, out_path);
 
 	return out_path->size ? DE_GRAPH_PATH_TYPE_PARTIAL : DE_GRAPH_PATH_TYPE_EMPTY;
 }
 
+de_graph_path_type_t de_graph_find_path_ex(const de_graph_t* graph, de_graph_search_context_t* context, de_graph_vertex_t* start, de_graph_vertex_t* goal, de_graph_path_t* out_path)
+{
+	if (!start || !goal || graph->vertices.size == 0) {
+		return DE_GRAPH_PATH_TYPE_EMPTY;
+	}
+	return de_graph_search(graph, context, NULL, 0, (uint32_t)(start - graph->vertices.data), (uint32_t)(goal - graph->vertices.data), out_path);
+}
+
+de_graph_path_type_t de_graph_find_path_in_region(const de_graph_t* graph, de_graph_search_context_t* context, const uint32_t* regions, uint32_t region, de_graph_vertex_t* start, de_graph_vertex_t* goal, de_graph_path_t* out_path)
+{
+	DE_ASSERT(regions);
+	if (!start || !goal || graph->vertices.size == 0) {
+		return DE_GRAPH_PATH_TYPE_EMPTY;
+	}
+	return de_graph_search(graph, context, regions, region, (uint32_t)(start - graph->vertices.data), (uint32_t)(goal - graph->vertices.data), out_path);
+}
+
+void de_graph_flood_region(const de_graph_t* graph, de_graph_search_context_t* context, const uint32_t* regions, uint32_t region, de_graph_vertex_t* start)
+{
+	DE_ASSERT(regions);
+	DE_ASSERT(start);
+	de_graph_search(graph, context, regions, region, (uint32_t)(start - graph->vertices.data), UINT32_MAX, NULL);
+}
+
+float de_graph_search_context_get_cost(const de_graph_search_context_t* context, uint32_t vertex)
+{
+	if (vertex >= context->states.size) {
+		return FLT_MAX;
+	}
+	const de_graph_search_state_t* state = context->states.data + vertex;
+	return state->generation == context->generation ? state->g_score : FLT_MAX;
+}
+
+de_graph_path_type_t de_graph_find_path(de_graph_t* graph, de_graph_vertex_t* start, de_graph_vertex_t* goal, de_graph_path_t* out_path)
+{
+	if (!graph) {
+		return DE_GRAPH_PATH_TYPE_EMPTY;
+	}
+	return de_graph_find_path_ex(graph, &graph->context, start, goal, out_path);
+}
+
+typedef struct de_graph_path_batch_t {
+	const de_graph_t* graph;
+	de_graph_search_context_t* contexts;
+	de_graph_path_query_t* queries;
+} de_graph_path_batch_t;
+
+static void de_graph_find_path_batch_range(void* user_data, size_t begin, size_t end, size_t thread_index)
+{
+	de_graph_path_batch_t* batch = user_data;
+	de_graph_search_context_t* context = batch->contexts + thread_index;
+	for (size_t i = begin; i < end; ++i) {
+		de_graph_path_query_t* query = batch->queries + i;
+		query->type = de_graph_find_path_ex(batch->graph, context, query->start, query->goal, &query->path);
+	}
+}
+
+void de_graph_find_path_batch(const de_graph_t* graph, de_thread_pool_t* pool, de_graph_search_context_t* contexts, de_graph_path_query_t* queries, size_t query_count)
+{
+	DE_ASSERT(graph);
+	DE_ASSERT(contexts);
+	de_graph_path_batch_t batch = {
+		.graph = graph,
+		.contexts = contexts,
+		.queries = queries
+	};
+	de_thread_pool_parallel_for(pool, query_count, 0, de_graph_find_path_batch_range, &batch);
+}
+
+static void de_graph_vertex_invalidate_cluster(de_graph_vertex_t* vertex)
+{
+	if (vertex->cluster) {
+		vertex->cluster->is_dirty = true;
+	}
+}
+
 void de_graph_vertex_link_bidirect(de_graph_vertex_t* vertex_a, de_graph_vertex_t* vertex_b)
 {
 	DE_ASSERT(vertex_a != vertex_b);
+	DE_ASSERT(!vertex_a->is_baked && !vertex_b->is_baked);
 	DE_ARRAY_APPEND(vertex_a->neighbours, vertex_b);
 	DE_ARRAY_APPEND(vertex_b->neighbours, vertex_a);
+	de_graph_vertex_invalidate_cluster(vertex_a);
+	de_graph_vertex_invalidate_cluster(vertex_b);
 }
 
 void de_graph_vertex_link_unidirect(de_graph_vertex_t* vertex_a, de_graph_vertex_t* vertex_b)
 {
 	DE_ASSERT(vertex_a != vertex_b);
+	DE_ASSERT(!vertex_a->is_baked);
 	DE_ARRAY_APPEND(vertex_a->neighbours, vertex_b);
+	de_graph_vertex_invalidate_cluster(vertex_a);
 }
 
 void de_graph_vertex_init(de_graph_vertex_t* vertex, const de_vec3_t* position)
 {
 	vertex->position = *position;
-	vertex->g_score = 0;
-	vertex->f_score = 0;
-	vertex->parent = NULL;
-	vertex->flags = DE_GRAPH_VERTEX_FLAGS_NON_VISITED;
 	DE_ARRAY_INIT(vertex->neighbours);
+	vertex->cluster = NULL;
+	vertex->is_baked = false;
 }
 
 void de_graph_vertex_isolate(de_graph_t* graph, de_graph_vertex_t* vertex)
 {
+	DE_ASSERT(!graph->is_baked);
 	DE_ARRAY_CLEAR(vertex->neighbours);
+	de_graph_vertex_invalidate_cluster(vertex);
 	for (size_t i = 0; i < graph->vertices.size; ++i) {
 		de_graph_vertex_t* other_vertex = graph->vertices.data + i;
 		for(int k = (int)other_vertex->neighbours.size - 1; k >= 0; --k) {
 			if (other_vertex->neighbours.data[k] == vertex) {
 				DE_ARRAY_REMOVE_AT(other_vertex->neighbours, (size_t)k);
+				de_graph_vertex_invalidate_cluster(other_vertex);
 			}
 		}
 	}
@@ -168,7 +490,146 @@ void de_graph_vertex_isolate(de_graph_t* graph, de_graph_vertex_t* vertex)
 
 void de_graph_vertex_unlink(de_graph_vertex_t* vertex)
 {
+	DE_ASSERT(!vertex->is_baked);
 	DE_ARRAY_CLEAR(vertex->neighbours);
+	de_graph_vertex_invalidate_cluster(vertex);
+}
+
+void de_graph_make_grid(de_graph_t* graph, int size)
+{
+	for (int y = 0; y < size; ++y) {
+		for (int x = 0; x < size; ++x) {
+			de_graph_vertex_t* vertex = DE_ARRAY_GROW(graph->vertices, 1);
+			de_graph_vertex_init(vertex, &(de_vec3_t) {.x = (float)x, .y = (float)y, .z = 0 });
+		}
+	}
+
+	/* link to form grid */
+	for (int y = 0; y < size; ++y) {
+		for (int x = 0; x < size; ++x) {
+			if (x + 1 < size) {
+				de_graph_vertex_link_bidirect(&graph->vertices.data[y * size + x], &graph->vertices.data[y * size + x + 1]);
+			}
+			if (y + 1 < size) {
+				de_graph_vertex_link_bidirect(&graph->vertices.data[y * size + x], &graph->vertices.data[(y + 1) * size + x]);
+			}
+		}
+	}
+}
+
+static bool de_graph_is_linked(const de_graph_t* graph, const de_graph_vertex_t* from, const de_graph_vertex_t* to)
+{
+	if (graph->is_baked) {
+		const de_graph_baked_t* baked = &graph->baked;
+		const uint32_t from_index = (uint32_t)(from - graph->vertices.data);
+		const uint32_t to_index = (uint32_t)(to - graph->vertices.data);
+		for (uint32_t edge = baked->edge_offsets[from_index]; edge < baked->edge_offsets[from_index + 1]; ++edge) {
+			if (baked->edge_targets[edge] == to_index) {
+				return true;
+			}
+		}
+	} else {
+		for (size_t k = 0; k < from->neighbours.size; ++k) {
+			if (from->neighbours.data[k] == to) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool de_graph_is_path_valid(const de_graph_t* graph, const de_graph_path_t* path, const de_graph_vertex_t* start, const de_graph_vertex_t* goal)
+{
+	/* path is reversed */
+	if (path->size == 0 || path->data[0] != goal || path->data[path->size - 1] != start) {
+		return false;
+	}
+	for (size_t i = 0; i + 1 < path->size; ++i) {
+		if (!de_graph_is_linked(graph, path->data[i + 1], path->data[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void de_graph_benchmark(int size, int query_count)
+{
+	de_graph_t graph;
+	de_graph_init(&graph);
+
+	de_graph_make_grid(&graph, size);
+
+	de_graph_path_query_t* queries = de_calloc(query_count, sizeof(*queries));
+	for (int i = 0; i < query_count; ++i) {
+		queries[i].start = &graph.vertices.data[de_irand(0, (int)graph.vertices.size - 1)];
+		queries[i].goal = &graph.vertices.data[de_irand(0, (int)graph.vertices.size - 1)];
+	}
+
+	de_graph_path_t path;
+	DE_ARRAY_INIT(path);
+
+	double start_time = de_time_get_seconds();
+	for (int i = 0; i < query_count; ++i) {
+		de_graph_path_type_t path_type = de_graph_find_path(&graph, queries[i].start, queries[i].goal, &path);
+		DE_ASSERT(path_type == DE_GRAPH_PATH_TYPE_FULL);
+		DE_ASSERT(de_graph_is_path_valid(&graph, &path, queries[i].start, queries[i].goal));
+	}
+	double total_time = de_time_get_seconds() - start_time;
+
+	de_log("pathfinder benchmark: %d vertices, %d queries in %f s (%f ms per query)",
+		size * size, query_count, total_time, 1000.0 * total_time / query_count);
+
+	/* same queries, but in parallel */
+	de_thread_pool_t* pool = de_thread_pool_create(0);
+	const size_t thread_count = de_thread_pool_get_thread_count(pool);
+	de_graph_search_context_t* contexts = de_malloc(thread_count * sizeof(*contexts));
+	for (size_t i = 0; i < thread_count; ++i) {
+		de_graph_search_context_init(&contexts[i]);
+	}
+
+	start_time = de_time_get_seconds();
+	de_graph_find_path_batch(&graph, pool, contexts, queries, query_count);
+	total_time = de_time_get_seconds() - start_time;
+
+	for (int i = 0; i < query_count; ++i) {
+		DE_ASSERT(queries[i].type == DE_GRAPH_PATH_TYPE_FULL);
+		DE_ASSERT(de_graph_is_path_valid(&graph, &queries[i].path, queries[i].start, queries[i].goal));
+		DE_ARRAY_FREE(queries[i].path);
+	}
+
+	de_log("pathfinder benchmark: %d vertices, %d batched queries on %d threads in %f s (%f ms per query)",
+		size * size, query_count, (int)thread_count, total_time, 1000.0 * total_time / query_count);
+
+	/* same queries on baked graph */
+	size_t mutable_size = graph.vertices.size * sizeof(de_graph_vertex_t);
+	for (size_t i = 0; i < graph.vertices.size; ++i) {
+		mutable_size += graph.vertices.data[i].neighbours.size * sizeof(de_graph_vertex_t*);
+	}
+
+	de_graph_bake(&graph);
+
+	const size_t baked_size = graph.baked.vertex_count * (3 * sizeof(float) + sizeof(uint32_t)) +
+		graph.baked.edge_count * (sizeof(uint32_t) + sizeof(float));
+
+	start_time = de_time_get_seconds();
+	for (int i = 0; i < query_count; ++i) {
+		de_graph_path_type_t path_type = de_graph_find_path(&graph, queries[i].start, queries[i].goal, &path);
+		DE_ASSERT(path_type == DE_GRAPH_PATH_TYPE_FULL);
+		DE_ASSERT(de_graph_is_path_valid(&graph, &path, queries[i].start, queries[i].goal));
+	}
+	total_time = de_time_get_seconds() - start_time;
+
+	de_log("pathfinder benchmark: %d vertices, %d queries on baked graph in %f s (%f ms per query), memory %d kb -> %d kb",
+		size * size, query_count, total_time, 1000.0 * total_time / query_count, (int)(mutable_size / 1024), (int)(baked_size / 1024));
+
+	for (size_t i = 0; i < thread_count; ++i) {
+		de_graph_search_context_free(&contexts[i]);
+	}
+	de_free(contexts);
+	de_thread_pool_free(pool);
+	de_free(queries);
+	DE_ARRAY_FREE(path);
+	de_graph_free(&graph);
 }
 
 void de_graph_tests()
@@ -180,22 +641,8 @@ void de_graph_tests()
 	de_graph_path_type_t path_type = de_graph_find_path(NULL, NULL, NULL, NULL);
 	DE_ASSERT(path_type == DE_GRAPH_PATH_TYPE_EMPTY);
 
-	/* initialize vertices first */
 	int size = 40;
-	for (float y = 0; y < size; ++y) {
-		for (float x = 0; x < size; ++x) {
-			de_graph_vertex_t* vertex = DE_ARRAY_GROW(graph.vertices, 1);
-			de_graph_vertex_init(vertex, &(de_vec3_t) {.x = x, .y = y, .z = 0 });
-		}
-	}
-
-	/* link to form grid */
-	for (int y = 0; y < size - 1; ++y) {
-		for (int x = 0; x < size - 1; ++x) {
-			de_graph_vertex_link_bidirect(&graph.vertices.data[y * size + x], &graph.vertices.data[y * size + x + 1]);
-			de_graph_vertex_link_bidirect(&graph.vertices.data[y * size + x], &graph.vertices.data[(y + 1) * size + x]);
-		}
-	}
+	de_graph_make_grid(&graph, size);
 
 	/* do tests from random to random point */
 	de_graph_path_t path;
@@ -212,6 +659,7 @@ void de_graph_tests()
 		de_graph_vertex_t* to = &graph.vertices.data[gy * size + gx];
 		path_type = de_graph_find_path(&graph, from, to, &path);
 		DE_ASSERT(path_type == DE_GRAPH_PATH_TYPE_FULL);
+		DE_ASSERT(de_graph_is_path_valid(&graph, &path, from, to));
 	}
 
 	/* isolated vertex test */
@@ -219,6 +667,43 @@ void de_graph_tests()
 	path_type = de_graph_find_path(&graph, &DE_ARRAY_FIRST(graph.vertices), &DE_ARRAY_LAST(graph.vertices), &path);
 	DE_ASSERT(path_type == DE_GRAPH_PATH_TYPE_PARTIAL);
 
+	/* unreachable goal test - partial path must lead somewhere to the goal */
+	path_type = de_graph_find_path(&graph, &DE_ARRAY_LAST(graph.vertices), &DE_ARRAY_FIRST(graph.vertices), &path);
+	DE_ASSERT(path_type == DE_GRAPH_PATH_TYPE_PARTIAL);
+	DE_ASSERT(path.data[0] != &DE_ARRAY_FIRST(graph.vertices));
+
+	/* baked graph must give exactly the same paths as mutable one */
+	de_graph_t baked_graph;
+	de_graph_init(&baked_graph);
+	de_graph_make_grid(&baked_graph, size);
+	de_graph_t mutable_graph;
+	de_graph_init(&mutable_graph);
+	de_graph_make_grid(&mutable_graph, size);
+	de_graph_bake(&baked_graph);
+	DE_ASSERT(baked_graph.is_baked);
+	DE_ASSERT(baked_graph.baked.edge_count == (size_t)(4 * size * (size - 1)));
+
+	de_graph_path_t baked_path;
+	DE_ARRAY_INIT(baked_path);
+	for (int i = 0; i < 200; ++i) {
+		const size_t from = de_irand(0, (int)mutable_graph.vertices.size - 1);
+		const size_t to = de_irand(0, (int)mutable_graph.vertices.size - 1);
+		de_graph_path_type_t mutable_type = de_graph_find_path(&mutable_graph, &mutable_graph.vertices.data[from], &mutable_graph.vertices.data[to], &path);
+		de_graph_path_type_t baked_type = de_graph_find_path(&baked_graph, &baked_graph.vertices.data[from], &baked_graph.vertices.data[to], &baked_path);
+		DE_ASSERT(mutable_type == baked_type);
+		DE_ASSERT(path.size == baked_path.size);
+		DE_ASSERT(de_graph_is_path_valid(&baked_graph, &baked_path, &baked_graph.vertices.data[from], &baked_graph.vertices.data[to]));
+		for (size_t k = 0; k < path.size; ++k) {
+			DE_ASSERT(path.data[k] - mutable_graph.vertices.data == baked_path.data[k] - baked_graph.vertices.data);
+		}
+	}
+	DE_ARRAY_FREE(baked_path);
+	de_graph_free(&mutable_graph);
+	de_graph_free(&baked_graph);
+
 	DE_ARRAY_FREE(path);
 	de_graph_free(&graph);
-}
\ No newline at end of file
+
+	/* performance test on large grid (~100k vertices) */
+	de_graph_benchmark(320, 100);
+}
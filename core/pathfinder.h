@@ -34,15 +34,9 @@ typedef enum de_graph_vertex_flags_t {
  */
 typedef struct de_graph_vertex_t {
 	de_vec3_t position;
-	de_graph_vertex_flags_t flags;
-	float g_score;
-	float f_score;
-	/** 
-	 * Pointer to "parent" vertex from which we can reach this vertex on shorthest path to target.
-	 * In other words this pointer used to store path information.
-	 */
-	struct de_graph_vertex_t* parent;
 	DE_ARRAY_DECLARE(struct de_graph_vertex_t*, neighbours); /**< Array of pointers to neighbour vertices. */
+	struct de_graph_cluster_t* cluster; /**< Cluster of graph hierarchy vertex belongs to. Can be NULL. */
+	bool is_baked; /**< Neighbours were moved into baked form of graph, links can not be changed anymore. */
 } de_graph_vertex_t;
 
 /**
@@ -50,11 +44,61 @@ typedef struct de_graph_vertex_t {
 */
 typedef DE_ARRAY_DECLARE(de_graph_vertex_t*, de_graph_path_t);
 
+/**
+ * @brief Per-vertex state of a search.
+ */
+typedef struct de_graph_search_state_t {
+	float g_score;
+	float f_score;
+	uint32_t generation; /**< Number of search which wrote this state last time. */
+	/** 
+	 * Index of "parent" vertex from which we can reach this vertex on shorthest path to target.
+	 * In other words this index used to store path information. UINT32_MAX if there is no parent.
+	 */
+	uint32_t parent;
+	uint32_t heap_index; /**< Position of vertex in open set heap. Valid only if vertex is open. */
+	de_graph_vertex_flags_t flags;
+} de_graph_search_state_t;
+
+/**
+ * @brief Scratch data of pathfinder. Graph itself is never modified by search, so any amount of
+ * threads can search on same graph simultaneously as long as each thread uses its own context.
+ * Context can be reused for any amount of searches on any graph, memory is reused between searches.
+ */
+typedef struct de_graph_search_context_t {
+	DE_ARRAY_DECLARE(de_graph_search_state_t, states); /**< Indexed by vertex index in graph. */
+	DE_ARRAY_DECLARE(uint32_t, open_set); /**< Binary min-heap of vertex indices ordered by f_score. */
+	/**
+	 * Incremented on each search. Vertex state is valid only when its generation is equal to this
+	 * value, so there is no need to reset state of every vertex before search.
+	 */
+	uint32_t generation;
+} de_graph_search_context_t;
+
+/**
+ * @brief Compact read-only form of graph produced by @ref de_graph_bake. Positions are stored
+ * as structure of arrays, edges are stored in compressed sparse row form: outgoing edges of
+ * vertex i are edge_targets[edge_offsets[i]] .. edge_targets[edge_offsets[i + 1] - 1].
+ */
+typedef struct de_graph_baked_t {
+	float* position_x;
+	float* position_y;
+	float* position_z;
+	uint32_t* edge_offsets; /**< vertex_count + 1 offsets into edge arrays. */
+	uint32_t* edge_targets; /**< Indices of target vertices. */
+	float* edge_costs; /**< Precomputed costs of edges. */
+	size_t vertex_count;
+	size_t edge_count;
+} de_graph_baked_t;
+
 /**
  * @brief Graph is just array of vertices.
  */
 typedef struct de_graph_t {
 	DE_ARRAY_DECLARE(de_graph_vertex_t, vertices);
+	de_graph_search_context_t context; /**< Context used by @ref de_graph_find_path */
+	bool is_baked; /**< Set by @ref de_graph_bake, pathfinder will use baked form of graph. */
+	de_graph_baked_t baked;
 } de_graph_t;
 
 typedef enum de_graph_path_type_t {
@@ -63,6 +107,16 @@ typedef enum de_graph_path_type_t {
 	DE_GRAPH_PATH_TYPE_EMPTY,
 } de_graph_path_type_t;
 
+/**
+ * @brief Single request of batched pathfinding, see @ref de_graph_find_path_batch.
+ */
+typedef struct de_graph_path_query_t {
+	de_graph_vertex_t* start;
+	de_graph_vertex_t* goal;
+	de_graph_path_t path; /**< Output path. Must be initialized by caller, its memory is reused. */
+	de_graph_path_type_t type; /**< Output type of path. */
+} de_graph_path_query_t;
+
 /**
  * @brief Prepares graph.
  */
@@ -73,6 +127,14 @@ void de_graph_init(de_graph_t* graph);
  */
 void de_graph_free(de_graph_t* graph);
 
+/**
+ * @brief Converts graph to compact read-only form which is much more cache friendly and takes
+ * less memory than graph with per-vertex arrays of neighbours. Conversion is one-way: arrays of
+ * neighbours are freed and graph must not be modified after this call. Vertices are still valid
+ * and pathfinder functions will return pointers to them as usual.
+ */
+void de_graph_bake(de_graph_t* graph);
+
 /**
  * @brief Initializes vertex with specified position.
  */
@@ -90,27 +152,88 @@ void de_graph_vertex_init(de_graph_vertex_t* vertex, const de_vec3_t* position);
  */
 de_graph_path_type_t de_graph_find_path(de_graph_t* graph, de_graph_vertex_t* start, de_graph_vertex_t* goal, de_graph_path_t* out_path);
 
+/**
+ * @brief Same as @ref de_graph_find_path, but uses specified context to store search state instead
+ * of context of graph. Thread-safe as long as graph is not modified during search and each thread uses
+ * its own context.
+ */
+de_graph_path_type_t de_graph_find_path_ex(const de_graph_t* graph, de_graph_search_context_t* context, de_graph_vertex_t* start, de_graph_vertex_t* goal, de_graph_path_t* out_path);
+
+/**
+ * @brief Same as @ref de_graph_find_path_ex, but search will visit only vertices which have
+ * regions[vertex_index] == region. regions must contain value for each vertex of graph.
+ */
+de_graph_path_type_t de_graph_find_path_in_region(const de_graph_t* graph, de_graph_search_context_t* context, const uint32_t* regions, uint32_t region, de_graph_vertex_t* start, de_graph_vertex_t* goal, de_graph_path_t* out_path);
+
+/**
+ * @brief Calculates costs of shortest paths from start vertex to every reachable vertex of
+ * region (see @ref de_graph_find_path_in_region). Costs can be fetched using
+ * @ref de_graph_search_context_get_cost until next search on same context.
+ */
+void de_graph_flood_region(const de_graph_t* graph, de_graph_search_context_t* context, const uint32_t* regions, uint32_t region, de_graph_vertex_t* start);
+
+/**
+ * @brief Returns cost of path to specified vertex found by last search on context. Returns FLT_MAX
+ * if vertex was not reached by last search.
+ */
+float de_graph_search_context_get_cost(const de_graph_search_context_t* context, uint32_t vertex);
+
+/**
+ * @brief Solves every query using threads of specified pool (can be NULL). contexts must point to
+ * array of de_thread_pool_get_thread_count(pool) search contexts, they can be reused between batches.
+ * Graph must not be modified while batch is running.
+ */
+void de_graph_find_path_batch(const de_graph_t* graph, de_thread_pool_t* pool, de_graph_search_context_t* contexts, de_graph_path_query_t* queries, size_t query_count);
+
+/**
+ * @brief Prepares search context.
+ */
+void de_graph_search_context_init(de_graph_search_context_t* context);
+
+/**
+ * @brief Frees search context resources.
+ */
+void de_graph_search_context_free(de_graph_search_context_t* context);
+
 /**
  * @brief Links graph vertices to each other making bidirectional link A <-> B.
+ * Must not be used on baked graph.
  */
 void de_graph_vertex_link_bidirect(de_graph_vertex_t* vertex_a, de_graph_vertex_t* vertex_b);
 
 /**
  * @brief Links vertex_a with vertex_b making unidirectional link A -> B
+ * Must not be used on baked graph.
  */
 void de_graph_vertex_link_unidirect(de_graph_vertex_t* vertex_a, de_graph_vertex_t* vertex_b);
 
 /**
  * @brief Breaks A <-> B link between vertex and its neighbour so vertex become isolated. O(n) complexity.
+ * Must not be used on baked graph.
  */
 void de_graph_vertex_isolate(de_graph_t* graph, de_graph_vertex_t* vertex);
 
 /**
- * @brief Breaks A -> B link.
+ * @brief Breaks A -> B link. Must not be used on baked graph.
+ *
+ * Link, unlink and isolate functions mark affected clusters of graph hierarchy (if any) as dirty,
+ * so hierarchy will be updated before next hierarchical search.
  */
 void de_graph_vertex_unlink(de_graph_vertex_t* vertex);
 
 /**
- * @brief Tests. Can be used as code examples.
+ * @brief Internal. Test helper, fills graph with size x size grid of vertices, each linked with
+ * its horizontal and vertical neighbours.
+ */
+void de_graph_make_grid(de_graph_t* graph, int size);
+
+/**
+ * @brief Internal. Test helper, checks that reversed path goes from start to goal by links of graph.
+ */
+bool de_graph_is_path_valid(const de_graph_t* graph, const de_graph_path_t* path, const de_graph_vertex_t* start, const de_graph_vertex_t* goal);
+
+/**
+ * @brief Tests. Can be used as code examples. Also measures performance of pathfinder on large
+ * grid and prints results into log.
  */
 void de_graph_tests();
\ No newline at end of file
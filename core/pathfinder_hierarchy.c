@@ -0,0 +1,826 @@
+/* Copyright (c) 2017-2019 Dmitry Stepanov a.k.a mr.DIMAS
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+* OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+static uint32_t de_graph_hierarchy_get_cluster_index(const de_graph_hierarchy_t* hierarchy, const de_vec3_t* position)
+{
+	const uint32_t x = (uint32_t)((position->x - hierarchy->origin.x) / hierarchy->cluster_size);
+	const uint32_t y = (uint32_t)((position->y - hierarchy->origin.y) / hierarchy->cluster_size);
+	const uint32_t z = (uint32_t)((position->z - hierarchy->origin.z) / hierarchy->cluster_size);
+	return (z * hierarchy->size_y + y) * hierarchy->size_x + x;
+}
+
+/**
+ * Writes outgoing edges of vertex into hierarchy->edges, target of each edge is vertex index.
+ */
+static void de_graph_hierarchy_collect_edges(de_graph_hierarchy_t* hierarchy, uint32_t vertex_index)
+{
+	const de_graph_t* graph = hierarchy->graph;
+	DE_ARRAY_CLEAR(hierarchy->edges);
+	if (graph->is_baked) {
+		const de_graph_baked_t* baked = &graph->baked;
+		for (uint32_t edge = baked->edge_offsets[vertex_index]; edge < baked->edge_offsets[vertex_index + 1]; ++edge) {
+			de_graph_abstract_edge_t* abstract_edge = DE_ARRAY_GROW(hierarchy->edges, 1);
+			abstract_edge->target = baked->edge_targets[edge];
+			abstract_edge->cost = baked->edge_costs[edge];
+		}
+	} else {
+		const de_graph_vertex_t* vertex = graph->vertices.data + vertex_index;
+		for (size_t i = 0; i < vertex->neighbours.size; ++i) {
+			const de_graph_vertex_t* neighbour = vertex->neighbours.data[i];
+			de_graph_abstract_edge_t* abstract_edge = DE_ARRAY_GROW(hierarchy->edges, 1);
+			abstract_edge->target = (uint32_t)(neighbour - graph->vertices.data);
+			abstract_edge->cost = de_vec3_sqr_distance(&vertex->position, &neighbour->position);
+		}
+	}
+}
+
+/**
+ * Makes vertex a portal if it is not a portal yet. Returns true if new portal was created.
+ */
+static bool de_graph_hierarchy_make_portal(de_graph_hierarchy_t* hierarchy, uint32_t vertex_index)
+{
+	if (hierarchy->vertex_portal[vertex_index] != UINT32_MAX) {
+		return false;
+	}
+
+	const uint32_t portal_index = (uint32_t)hierarchy->portals.size;
+	de_graph_portal_t* portal = DE_ARRAY_GROW(hierarchy->portals, 1);
+	portal->vertex = vertex_index;
+	portal->cluster = hierarchy->vertex_cluster[vertex_index];
+	portal->goal_cost = FLT_MAX;
+	DE_ARRAY_INIT(portal->edges);
+
+	hierarchy->vertex_portal[vertex_index] = portal_index;
+	DE_ARRAY_APPEND(hierarchy->clusters[portal->cluster].portals, portal_index);
+
+	/* cluster of portal needs edges for it, portals of neighbour clusters linked to its vertex
+	 * need edges to it, so all of them are reconnected */
+	hierarchy->clusters[portal->cluster].is_dirty = true;
+	de_graph_hierarchy_collect_edges(hierarchy, vertex_index);
+	for (size_t i = 0; i < hierarchy->edges.size; ++i) {
+		hierarchy->clusters[hierarchy->vertex_cluster[hierarchy->edges.data[i].target]].is_dirty = true;
+	}
+
+	return true;
+}
+
+static int de_graph_crossing_compare(const void* a, const void* b)
+{
+	const de_graph_crossing_t* crossing_a = a;
+	const de_graph_crossing_t* crossing_b = b;
+	if (crossing_a->target_cluster != crossing_b->target_cluster) {
+		return crossing_a->target_cluster < crossing_b->target_cluster ? -1 : 1;
+	}
+	if (crossing_a->vertex != crossing_b->vertex) {
+		return crossing_a->vertex < crossing_b->vertex ? -1 : 1;
+	}
+	return 0;
+}
+
+static uint32_t de_graph_hierarchy_next_mark(de_graph_hierarchy_t* hierarchy)
+{
+	if (hierarchy->mark >= UINT32_MAX - 2) {
+		memset(hierarchy->vertex_mark, 0, hierarchy->vertex_count * sizeof(uint32_t));
+		hierarchy->mark = 0;
+	}
+	hierarchy->mark += 2;
+	return hierarchy->mark;
+}
+
+/**
+ * Finds entrances from cluster to its neighbours and creates portals for them. Portals created in
+ * other clusters make them dirty.
+ */
+static void de_graph_hierarchy_scan_cluster(de_graph_hierarchy_t* hierarchy, uint32_t cluster_index)
+{
+	de_graph_cluster_t* cluster = hierarchy->clusters + cluster_index;
+
+	DE_ARRAY_CLEAR(hierarchy->crossings);
+	for (size_t i = 0; i < cluster->vertices.size; ++i) {
+		const uint32_t vertex_index = cluster->vertices.data[i];
+		de_graph_hierarchy_collect_edges(hierarchy, vertex_index);
+		for (size_t k = 0; k < hierarchy->edges.size; ++k) {
+			const uint32_t target = hierarchy->edges.data[k].target;
+			const uint32_t target_cluster = hierarchy->vertex_cluster[target];
+			if (target_cluster != cluster_index) {
+				de_graph_crossing_t crossing = {
+					.vertex = vertex_index,
+					.target = target,
+					.target_cluster = target_cluster
+				};
+				DE_ARRAY_APPEND(hierarchy->crossings, crossing);
+			}
+		}
+	}
+
+	/* crossings to same cluster are adjacent after sorting */
+	DE_ARRAY_QSORT(hierarchy->crossings, de_graph_crossing_compare);
+
+	size_t group_begin = 0;
+	while (group_begin < hierarchy->crossings.size) {
+		const uint32_t target_cluster = hierarchy->crossings.data[group_begin].target_cluster;
+		size_t group_end = group_begin;
+		while (group_end < hierarchy->crossings.size && hierarchy->crossings.data[group_end].target_cluster == target_cluster) {
+			++group_end;
+		}
+
+		/* vertices with crossings to target cluster are marked with "border" mark, vertices of
+		 * already found entrances are marked with "visited" mark */
+		const uint32_t border_mark = de_graph_hierarchy_next_mark(hierarchy);
+		const uint32_t visited_mark = border_mark + 1;
+		for (size_t i = group_begin; i < group_end; ++i) {
+			hierarchy->vertex_mark[hierarchy->crossings.data[i].vertex] = border_mark;
+		}
+
+		for (size_t i = group_begin; i < group_end; ++i) {
+			const uint32_t first_vertex = hierarchy->crossings.data[i].vertex;
+			if (hierarchy->vertex_mark[first_vertex] != border_mark) {
+				continue;
+			}
+
+			/* entrance is a connected set of border vertices */
+			DE_ARRAY_CLEAR(hierarchy->entrance);
+			DE_ARRAY_APPEND(hierarchy->entrance, first_vertex);
+			hierarchy->vertex_mark[first_vertex] = visited_mark;
+			for (size_t k = 0; k < hierarchy->entrance.size; ++k) {
+				de_graph_hierarchy_collect_edges(hierarchy, hierarchy->entrance.data[k]);
+				for (size_t n = 0; n < hierarchy->edges.size; ++n) {
+					const uint32_t neighbour = hierarchy->edges.data[n].target;
+					if (hierarchy->vertex_mark[neighbour] == border_mark) {
+						hierarchy->vertex_mark[neighbour] = visited_mark;
+						DE_ARRAY_APPEND(hierarchy->entrance, neighbour);
+					}
+				}
+			}
+
+			/* middle of entrance becomes portal */
+			const uint32_t portal_vertex = hierarchy->entrance.data[hierarchy->entrance.size / 2];
+			for (size_t k = group_begin; k < group_end; ++k) {
+				const de_graph_crossing_t* crossing = hierarchy->crossings.data + k;
+				if (crossing->vertex == portal_vertex) {
+					de_graph_hierarchy_make_portal(hierarchy, portal_vertex);
+					de_graph_hierarchy_make_portal(hierarchy, crossing->target);
+					break;
+				}
+			}
+		}
+
+		group_begin = group_end;
+	}
+
+	cluster->is_scanned = true;
+}
+
+/**
+ * Rebuilds abstract edges of every portal of cluster.
+ */
+static void de_graph_hierarchy_connect_cluster(de_graph_hierarchy_t* hierarchy, uint32_t cluster_index)
+{
+	de_graph_t* graph = hierarchy->graph;
+	de_graph_cluster_t* cluster = hierarchy->clusters + cluster_index;
+	for (size_t i = 0; i < cluster->portals.size; ++i) {
+		de_graph_portal_t* portal = hierarchy->portals.data + cluster->portals.data[i];
+		DE_ARRAY_CLEAR(portal->edges);
+
+		/* inter-cluster edges are edges of graph between portals */
+		de_graph_hierarchy_collect_edges(hierarchy, portal->vertex);
+		for (size_t k = 0; k < hierarchy->edges.size; ++k) {
+			const de_graph_abstract_edge_t* edge = hierarchy->edges.data + k;
+			const uint32_t target_portal = hierarchy->vertex_portal[edge->target];
+			if (hierarchy->vertex_cluster[edge->target] != cluster_index && target_portal != UINT32_MAX) {
+				de_graph_abstract_edge_t abstract_edge = {
+					.target = target_portal,
+					.cost = edge->cost
+				};
+				DE_ARRAY_APPEND(portal->edges, abstract_edge);
+			}
+		}
+
+		/* intra-cluster edges are shortest paths inside of cluster */
+		de_graph_flood_region(graph, &hierarchy->context, hierarchy->vertex_cluster, cluster_index, graph->vertices.data + portal->vertex);
+		for (size_t k = 0; k < cluster->portals.size; ++k) {
+			const uint32_t other_index = cluster->portals.data[k];
+			const float cost = de_graph_search_context_get_cost(&hierarchy->context, hierarchy->portals.data[other_index].vertex);
+			if (k != i && cost != FLT_MAX) {
+				de_graph_abstract_edge_t abstract_edge = {
+					.target = other_index,
+					.cost = cost
+				};
+				DE_ARRAY_APPEND(portal->edges, abstract_edge);
+			}
+		}
+	}
+	cluster->is_dirty = false;
+	cluster->is_scanned = false;
+	++hierarchy->rebuilt_cluster_count;
+}
+
+void de_graph_hierarchy_update(de_graph_hierarchy_t* hierarchy)
+{
+	/* Scanning may create portals in neighbour clusters and make them dirty, so repeat until
+	 * every dirty cluster is scanned. */
+	bool changed;
+	do {
+		changed = false;
+		for (size_t i = 0; i < hierarchy->cluster_count; ++i) {
+			const de_graph_cluster_t* cluster = hierarchy->clusters + i;
+			if (cluster->is_dirty && !cluster->is_scanned) {
+				de_graph_hierarchy_scan_cluster(hierarchy, (uint32_t)i);
+				changed = true;
+			}
+		}
+	} while (changed);
+
+	for (size_t i = 0; i < hierarchy->cluster_count; ++i) {
+		if (hierarchy->clusters[i].is_dirty) {
+			de_graph_hierarchy_connect_cluster(hierarchy, (uint32_t)i);
+		}
+	}
+}
+
+void de_graph_hierarchy_init(de_graph_hierarchy_t* hierarchy, de_graph_t* graph, float cluster_size)
+{
+	DE_ASSERT(graph);
+	DE_ASSERT(cluster_size > 0);
+	DE_ASSERT(graph->vertices.size < UINT32_MAX);
+
+	de_zero(hierarchy, sizeof(*hierarchy));
+	hierarchy->graph = graph;
+	hierarchy->cluster_size = cluster_size;
+	de_graph_search_context_init(&hierarchy->context);
+	DE_ARRAY_INIT(hierarchy->portals);
+	DE_ARRAY_INIT(hierarchy->states);
+	DE_ARRAY_INIT(hierarchy->open_set);
+	DE_ARRAY_INIT(hierarchy->edges);
+	DE_ARRAY_INIT(hierarchy->start_edges);
+	DE_ARRAY_INIT(hierarchy->crossings);
+	DE_ARRAY_INIT(hierarchy->entrance);
+	DE_ARRAY_INIT(hierarchy->segment);
+
+	const size_t vertex_count = graph->vertices.size;
+	hierarchy->vertex_count = vertex_count;
+	if (vertex_count == 0) {
+		return;
+	}
+
+	/* spatial grid of clusters */
+	de_vec3_t min = graph->vertices.data[0].position;
+	de_vec3_t max = min;
+	for (size_t i = 1; i < vertex_count; ++i) {
+		de_vec3_min_max(&graph->vertices.data[i].position, &min, &max);
+	}
+	hierarchy->origin = min;
+	hierarchy->size_x = (uint32_t)((max.x - min.x) / cluster_size) + 1;
+	hierarchy->size_y = (uint32_t)((max.y - min.y) / cluster_size) + 1;
+	hierarchy->size_z = (uint32_t)((max.z - min.z) / cluster_size) + 1;
+	hierarchy->cluster_count = (size_t)hierarchy->size_x * hierarchy->size_y * hierarchy->size_z;
+	hierarchy->clusters = de_calloc(hierarchy->cluster_count, sizeof(*hierarchy->clusters));
+	for (size_t i = 0; i < hierarchy->cluster_count; ++i) {
+		de_graph_cluster_t* cluster = hierarchy->clusters + i;
+		DE_ARRAY_INIT(cluster->vertices);
+		DE_ARRAY_INIT(cluster->portals);
+		cluster->is_dirty = true;
+	}
+
+	hierarchy->vertex_cluster = de_malloc(vertex_count * sizeof(uint32_t));
+	hierarchy->vertex_portal = de_malloc(vertex_count * sizeof(uint32_t));
+	hierarchy->vertex_mark = de_calloc(vertex_count, sizeof(uint32_t));
+	for (size_t i = 0; i < vertex_count; ++i) {
+		de_graph_vertex_t* vertex = graph->vertices.data + i;
+		const uint32_t cluster_index = de_graph_hierarchy_get_cluster_index(hierarchy, &vertex->position);
+		DE_ASSERT(cluster_index < hierarchy->cluster_count);
+		DE_ARRAY_APPEND(hierarchy->clusters[cluster_index].vertices, (uint32_t)i);
+		hierarchy->vertex_cluster[i] = cluster_index;
+		hierarchy->vertex_portal[i] = UINT32_MAX;
+		vertex->cluster = hierarchy->clusters + cluster_index;
+	}
+
+	de_graph_hierarchy_update(hierarchy);
+}
+
+void de_graph_hierarchy_free(de_graph_hierarchy_t* hierarchy)
+{
+	for (size_t i = 0; i < hierarchy->vertex_count && i < hierarchy->graph->vertices.size; ++i) {
+		hierarchy->graph->vertices.data[i].cluster = NULL;
+	}
+	for (size_t i = 0; i < hierarchy->cluster_count; ++i) {
+		DE_ARRAY_FREE(hierarchy->clusters[i].vertices);
+		DE_ARRAY_FREE(hierarchy->clusters[i].portals);
+	}
+	de_free(hierarchy->clusters);
+	for (size_t i = 0; i < hierarchy->portals.size; ++i) {
+		DE_ARRAY_FREE(hierarchy->portals.data[i].edges);
+	}
+	DE_ARRAY_FREE(hierarchy->portals);
+	de_free(hierarchy->vertex_cluster);
+	de_free(hierarchy->vertex_portal);
+	de_free(hierarchy->vertex_mark);
+	de_graph_search_context_free(&hierarchy->context);
+	DE_ARRAY_FREE(hierarchy->states);
+	DE_ARRAY_FREE(hierarchy->open_set);
+	DE_ARRAY_FREE(hierarchy->edges);
+	DE_ARRAY_FREE(hierarchy->start_edges);
+	DE_ARRAY_FREE(hierarchy->crossings);
+	DE_ARRAY_FREE(hierarchy->entrance);
+	DE_ARRAY_FREE(hierarchy->segment);
+}
+
+static void de_graph_abstract_open_set_push(de_graph_hierarchy_t* hierarchy, uint32_t node, float f_score)
+{
+	de_graph_abstract_open_t entry = { .f_score = f_score, .node = node };
+	size_t i = hierarchy->open_set.size;
+	DE_ARRAY_APPEND(hierarchy->open_set, entry);
+	while (i > 0) {
+		const size_t parent = (i - 1) / 2;
+		if (hierarchy->open_set.data[parent].f_score <= f_score) {
+			break;
+		}
+		hierarchy->open_set.data[i] = hierarchy->open_set.data[parent];
+		i = parent;
+	}
+	hierarchy->open_set.data[i] = entry;
+}
+
+static uint32_t de_graph_abstract_open_set_pop(de_graph_hierarchy_t* hierarchy)
+{
+	const uint32_t top = hierarchy->open_set.data[0].node;
+	const de_graph_abstract_open_t last = DE_ARRAY_POP(hierarchy->open_set);
+	const size_t size = hierarchy->open_set.size;
+	if (size > 0) {
+		size_t i = 0;
+		for (;;) {
+			size_t child = 2 * i + 1;
+			if (child >= size) {
+				break;
+			}
+			if (child + 1 < size && hierarchy->open_set.data[child + 1].f_score < hierarchy->open_set.data[child].f_score) {
+				++child;
+			}
+			if (last.f_score <= hierarchy->open_set.data[child].f_score) {
+				break;
+			}
+			hierarchy->open_set.data[i] = hierarchy->open_set.data[child];
+			i = child;
+		}
+		hierarchy->open_set.data[i] = last;
+	}
+	return top;
+}
+
+static de_graph_abstract_state_t* de_graph_abstract_state(de_graph_hierarchy_t* hierarchy, uint32_t node)
+{
+	de_graph_abstract_state_t* state = hierarchy->states.data + node;
+	if (state->generation != hierarchy->generation) {
+		state->generation = hierarchy->generation;
+		state->g_score = FLT_MAX;
+		state->parent = UINT32_MAX;
+		state->is_closed = false;
+	}
+	return state;
+}
+
+static void de_graph_abstract_search_begin(de_graph_hierarchy_t* hierarchy, size_t node_count)
+{
+	DE_ARRAY_CLEAR(hierarchy->open_set);
+	if (hierarchy->states.size < node_count) {
+		const size_t old_size = hierarchy->states.size;
+		DE_ARRAY_GROW(hierarchy->states, node_count - old_size);
+		for (size_t i = old_size; i < node_count; ++i) {
+			hierarchy->states.data[i].generation = 0;
+		}
+	}
+	++hierarchy->generation;
+	if (hierarchy->generation == 0) {
+		for (size_t i = 0; i < hierarchy->states.size; ++i) {
+			hierarchy->states.data[i].generation = 0;
+		}
+		hierarchy->generation = 1;
+	}
+}
+
+static void de_graph_abstract_relax(de_graph_hierarchy_t* hierarchy, uint32_t current, float current_g_score,
+	uint32_t node, float cost, const de_vec3_t* position, const de_vec3_t* goal_position)
+{
+	de_graph_abstract_state_t* state = de_graph_abstract_state(hierarchy, node);
+	const float g_score = current_g_score + cost;
+	if (state->is_closed || g_score >= state->g_score) {
+		return;
+	}
+	state->g_score = g_score;
+	state->parent = current;
+	de_graph_abstract_open_set_push(hierarchy, node, g_score + de_vec3_sqr_distance(position, goal_position));
+}
+
+de_graph_path_type_t de_graph_hierarchy_find_abstract_path(de_graph_hierarchy_t* hierarchy, de_graph_vertex_t* start, de_graph_vertex_t* goal, de_graph_path_t* out_waypoints)
+{
+	if (!start || !goal || hierarchy->vertex_count == 0) {
+		return DE_GRAPH_PATH_TYPE_EMPTY;
+	}
+
+	de_graph_t* graph = hierarchy->graph;
+
+	DE_ASSERT(graph->vertices.size == hierarchy->vertex_count);
+
+	DE_ARRAY_CLEAR(*out_waypoints);
+
+	de_graph_hierarchy_update(hierarchy);
+
+	const uint32_t start_index = (uint32_t)(start - graph->vertices.data);
+	const uint32_t goal_index = (uint32_t)(goal - graph->vertices.data);
+	const uint32_t start_cluster_index = hierarchy->vertex_cluster[start_index];
+	const uint32_t goal_cluster_index = hierarchy->vertex_cluster[goal_index];
+	const de_graph_cluster_t* start_cluster = hierarchy->clusters + start_cluster_index;
+	const de_graph_cluster_t* goal_cluster = hierarchy->clusters + goal_cluster_index;
+
+	/* Temporary nodes of start and goal are placed after portals */
+	const uint32_t start_node = (uint32_t)hierarchy->portals.size;
+	const uint32_t goal_node = start_node + 1;
+
+	/* connect start with portals of its cluster and with goal if they're in same cluster */
+	DE_ARRAY_CLEAR(hierarchy->start_edges);
+	de_graph_flood_region(graph, &hierarchy->context, hierarchy->vertex_cluster, start_cluster_index, start);
+	for (size_t i = 0; i < start_cluster->portals.size; ++i) {
+		const uint32_t portal_index = start_cluster->portals.data[i];
+		const float cost = de_graph_search_context_get_cost(&hierarchy->context, hierarchy->portals.data[portal_index].vertex);
+		if (cost != FLT_MAX) {
+			de_graph_abstract_edge_t edge = { .target = portal_index, .cost = cost };
+			DE_ARRAY_APPEND(hierarchy->start_edges, edge);
+		}
+	}
+	if (start_cluster_index == goal_cluster_index) {
+		const float cost = de_graph_search_context_get_cost(&hierarchy->context, goal_index);
+		if (cost != FLT_MAX) {
+			de_graph_abstract_edge_t edge = { .target = goal_node, .cost = cost };
+			DE_ARRAY_APPEND(hierarchy->start_edges, edge);
+		}
+	}
+
+	/* connect portals of goal cluster with goal */
+	for (size_t i = 0; i < goal_cluster->portals.size; ++i) {
+		de_graph_portal_t* portal = hierarchy->portals.data + goal_cluster->portals.data[i];
+		if (de_graph_find_path_in_region(graph, &hierarchy->context, hierarchy->vertex_cluster, goal_cluster_index,
+			graph->vertices.data + portal->vertex, goal, &hierarchy->segment) == DE_GRAPH_PATH_TYPE_FULL) {
+			portal->goal_cost = de_graph_search_context_get_cost(&hierarchy->context, goal_index);
+		}
+	}
+
+	de_graph_abstract_search_begin(hierarchy, hierarchy->portals.size + 2);
+
+	de_graph_abstract_state_t* start_state = de_graph_abstract_state(hierarchy, start_node);
+	start_state->g_score = 0;
+	de_graph_abstract_open_set_push(hierarchy, start_node, de_vec3_sqr_distance(&start->position, &goal->position));
+
+	uint32_t closest = start_node;
+	float closest_distance = de_vec3_sqr_distance(&start->position, &goal->position);
+
+	while (hierarchy->open_set.size > 0) {
+		const uint32_t current = de_graph_abstract_open_set_pop(hierarchy);
+		de_graph_abstract_state_t* current_state = hierarchy->states.data + current;
+		if (current_state->is_closed) {
+			/* stale entry of lazy deletion */
+			continue;
+		}
+		current_state->is_closed = true;
+
+		if (current == goal_node) {
+			closest = goal_node;
+			break;
+		}
+
+		const float current_g_score = current_state->g_score;
+
+		if (current == start_node) {
+			for (size_t i = 0; i < hierarchy->start_edges.size; ++i) {
+				const de_graph_abstract_edge_t* edge = hierarchy->start_edges.data + i;
+				const de_vec3_t* position = edge->target == goal_node ? &goal->position : &graph->vertices.data[hierarchy->portals.data[edge->target].vertex].position;
+				de_graph_abstract_relax(hierarchy, current, current_g_score, edge->target, edge->cost, position, &goal->position);
+			}
+			continue;
+		}
+
+		const de_graph_portal_t* portal = hierarchy->portals.data + current;
+		const de_vec3_t* portal_position = &graph->vertices.data[portal->vertex].position;
+		const float distance = de_vec3_sqr_distance(portal_position, &goal->position);
+		if (distance < closest_distance) {
+			closest = current;
+			closest_distance = distance;
+		}
+
+		for (size_t i = 0; i < portal->edges.size; ++i) {
+			const de_graph_abstract_edge_t* edge = portal->edges.data + i;
+			const de_vec3_t* position = &graph->vertices.data[hierarchy->portals.data[edge->target].vertex].position;
+			de_graph_abstract_relax(hierarchy, current, current_g_score, edge->target, edge->cost, position, &goal->position);
+		}
+		if (portal->goal_cost != FLT_MAX) {
+			de_graph_abstract_relax(hierarchy, current, current_g_score, goal_node, portal->goal_cost, &goal->position, &goal->position);
+		}
+	}
+
+	for (size_t i = 0; i < goal_cluster->portals.size; ++i) {
+		hierarchy->portals.data[goal_cluster->portals.data[i]].goal_cost = FLT_MAX;
+	}
+
+	/* reconstruct reversed path of waypoints */
+	for (uint32_t node = closest; node != UINT32_MAX; node = hierarchy->states.data[node].parent) {
+		de_graph_vertex_t* vertex;
+		if (node == start_node) {
+			vertex = start;
+		} else if (node == goal_node) {
+			vertex = goal;
+		} else {
+			vertex = graph->vertices.data + hierarchy->portals.data[node].vertex;
+		}
+		DE_ARRAY_APPEND(*out_waypoints, vertex);
+	}
+
+	return closest == goal_node ? DE_GRAPH_PATH_TYPE_FULL : DE_GRAPH_PATH_TYPE_PARTIAL;
+}
+
+size_t de_graph_hierarchy_refine_path(de_graph_hierarchy_t* hierarchy, const de_graph_path_t* waypoints, size_t max_segments, de_graph_path_t* out_path)
+{
+	de_graph_t* graph = hierarchy->graph;
+
+	DE_ARRAY_CLEAR(*out_path);
+
+	if (waypoints->size == 0) {
+		return 0;
+	}
+
+	/* path is built in forward order and reversed at the end */
+	DE_ARRAY_APPEND(*out_path, waypoints->data[waypoints->size - 1]);
+
+	size_t segment_count = 0;
+	for (size_t i = waypoints->size - 1; i > 0 && segment_count < max_segments; --i, ++segment_count) {
+		de_graph_vertex_t* from = waypoints->data[i];
+		de_graph_vertex_t* to = waypoints->data[i - 1];
+		if (from->cluster == to->cluster) {
+			const uint32_t cluster_index = hierarchy->vertex_cluster[from - graph->vertices.data];
+			de_graph_path_type_t type = de_graph_find_path_in_region(graph, &hierarchy->context, hierarchy->vertex_cluster, cluster_index, from, to, &hierarchy->segment);
+			DE_ASSERT(type == DE_GRAPH_PATH_TYPE_FULL);
+			/* segment is reversed and its last vertex is already in path */
+			for (int k = (int)hierarchy->segment.size - 2; k >= 0; --k) {
+				DE_ARRAY_APPEND(*out_path, hierarchy->segment.data[k]);
+			}
+		} else {
+			/* waypoints in different clusters are linked directly */
+			DE_ARRAY_APPEND(*out_path, to);
+		}
+	}
+
+	DE_ARRAY_REVERSE(*out_path);
+
+	return segment_count;
+}
+
+de_graph_path_type_t de_graph_hierarchy_find_path(de_graph_hierarchy_t* hierarchy, de_graph_vertex_t* start, de_graph_vertex_t* goal, de_graph_path_t* out_path)
+{
+	de_graph_path_t waypoints;
+	DE_ARRAY_INIT(waypoints);
+	de_graph_path_type_t type = de_graph_hierarchy_find_abstract_path(hierarchy, start, goal, &waypoints);
+	if (type != DE_GRAPH_PATH_TYPE_EMPTY) {
+		de_graph_hierarchy_refine_path(hierarchy, &waypoints, SIZE_MAX, out_path);
+	}
+	DE_ARRAY_FREE(waypoints);
+	return type;
+}
+
+static void de_graph_hierarchy_benchmark(int size, float cluster_size, int query_count)
+{
+	de_graph_t graph;
+	de_graph_init(&graph);
+	de_graph_make_grid(&graph, size);
+
+	de_graph_hierarchy_t hierarchy;
+	double start_time = de_time_get_seconds();
+	de_graph_hierarchy_init(&hierarchy, &graph, cluster_size);
+	const double build_time = de_time_get_seconds() - start_time;
+
+	/* long-range queries between opposite sides of grid */
+	de_graph_vertex_t** ends = de_malloc(2 * query_count * sizeof(*ends));
+	for (int i = 0; i < query_count; ++i) {
+		ends[2 * i] = &graph.vertices.data[(rand() % size) * size + rand() % (size / 8)];
+		ends[2 * i + 1] = &graph.vertices.data[(rand() % size) * size + size - 1 - rand() % (size / 8)];
+	}
+
+	de_graph_path_t path;
+	DE_ARRAY_INIT(path);
+
+	size_t plain_length = 0;
+	start_time = de_time_get_seconds();
+	for (int i = 0; i < query_count; ++i) {
+		de_graph_path_type_t type = de_graph_find_path(&graph, ends[2 * i], ends[2 * i + 1], &path);
+		DE_ASSERT(type == DE_GRAPH_PATH_TYPE_FULL);
+		plain_length += path.size;
+	}
+	const double plain_time = de_time_get_seconds() - start_time;
+
+	size_t hierarchical_length = 0;
+	start_time = de_time_get_seconds();
+	for (int i = 0; i < query_count; ++i) {
+		de_graph_path_type_t type = de_graph_hierarchy_find_path(&hierarchy, ends[2 * i], ends[2 * i + 1], &path);
+		DE_ASSERT(type == DE_GRAPH_PATH_TYPE_FULL);
+		hierarchical_length += path.size;
+	}
+	const double hierarchical_time = de_time_get_seconds() - start_time;
+
+	/* typical usage - refine only the beginning of the path */
+	de_graph_path_t waypoints;
+	DE_ARRAY_INIT(waypoints);
+	start_time = de_time_get_seconds();
+	for (int i = 0; i < query_count; ++i) {
+		de_graph_path_type_t type = de_graph_hierarchy_find_abstract_path(&hierarchy, ends[2 * i], ends[2 * i + 1], &waypoints);
+		DE_ASSERT(type == DE_GRAPH_PATH_TYPE_FULL);
+		de_graph_hierarchy_refine_path(&hierarchy, &waypoints, 2, &path);
+	}
+	const double refine_time = de_time_get_seconds() - start_time;
+	DE_ARRAY_FREE(waypoints);
+
+	de_log("hierarchical pathfinder benchmark: %d vertices, %d clusters, %d portals, built in %f s",
+		size * size, (int)hierarchy.cluster_count, (int)hierarchy.portals.size, build_time);
+	de_log("hierarchical pathfinder benchmark: %d long queries: plain %f ms per query, hierarchical %f ms per query, "
+		"hierarchical with partial refinement %f ms per query, path length ratio %f",
+		query_count, 1000.0 * plain_time / query_count, 1000.0 * hierarchical_time / query_count,
+		1000.0 * refine_time / query_count, (double)hierarchical_length / (double)plain_length);
+
+	DE_ARRAY_FREE(path);
+	de_free(ends);
+	de_graph_hierarchy_free(&hierarchy);
+	de_graph_free(&graph);
+}
+
+/**
+ * Checks that every abstract edge between portals has reverse edge. Used by tests only.
+ */
+static bool de_graph_hierarchy_is_symmetric(const de_graph_hierarchy_t* hierarchy)
+{
+	for (size_t i = 0; i < hierarchy->portals.size; ++i) {
+		const de_graph_portal_t* portal = hierarchy->portals.data + i;
+		for (size_t k = 0; k < portal->edges.size; ++k) {
+			const de_graph_portal_t* other = hierarchy->portals.data + portal->edges.data[k].target;
+			bool has_reverse = false;
+			for (size_t n = 0; n < other->edges.size; ++n) {
+				if (other->edges.data[n].target == i) {
+					has_reverse = true;
+					break;
+				}
+			}
+			if (!has_reverse) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void de_graph_hierarchy_tests()
+{
+	const int size = 64;
+
+	de_graph_t graph;
+	de_graph_init(&graph);
+	de_graph_make_grid(&graph, size);
+
+	de_graph_hierarchy_t hierarchy;
+	de_graph_hierarchy_init(&hierarchy, &graph, 8.0f);
+	DE_ASSERT(hierarchy.cluster_count == 64);
+	DE_ASSERT(hierarchy.portals.size > 0);
+
+	de_graph_path_t path;
+	DE_ARRAY_INIT(path);
+
+	/* random queries */
+	for (int i = 0; i < 500; ++i) {
+		de_graph_vertex_t* from = &graph.vertices.data[rand() % graph.vertices.size];
+		de_graph_vertex_t* to = &graph.vertices.data[rand() % graph.vertices.size];
+		de_graph_path_type_t type = de_graph_hierarchy_find_path(&hierarchy, from, to, &path);
+		DE_ASSERT(type == DE_GRAPH_PATH_TYPE_FULL);
+		DE_ASSERT(de_graph_is_path_valid(&graph, &path, from, to));
+	}
+
+	/* partial refinement - only the beginning of the path is refined */
+	de_graph_vertex_t* start = &graph.vertices.data[0];
+	de_graph_vertex_t* goal = &DE_ARRAY_LAST(graph.vertices);
+	de_graph_path_t waypoints;
+	DE_ARRAY_INIT(waypoints);
+	de_graph_path_type_t type = de_graph_hierarchy_find_abstract_path(&hierarchy, start, goal, &waypoints);
+	DE_ASSERT(type == DE_GRAPH_PATH_TYPE_FULL);
+	DE_ASSERT(waypoints.size > 2);
+	DE_ASSERT(DE_ARRAY_FIRST(waypoints) == goal && DE_ARRAY_LAST(waypoints) == start);
+	size_t refined = de_graph_hierarchy_refine_path(&hierarchy, &waypoints, 2, &path);
+	DE_ASSERT(refined == 2);
+	DE_ASSERT(de_graph_is_path_valid(&graph, &path, start, waypoints.data[waypoints.size - 3]));
+
+	/* wall with one gap, only clusters near the wall must be rebuilt */
+	const int wall_x = 32;
+	const int gap_y = 10;
+	const size_t rebuilt_cluster_count = hierarchy.rebuilt_cluster_count;
+	for (int y = 0; y < size; ++y) {
+		if (y != gap_y) {
+			de_graph_vertex_isolate(&graph, &graph.vertices.data[y * size + wall_x]);
+		}
+	}
+	de_graph_hierarchy_update(&hierarchy);
+	DE_ASSERT(hierarchy.rebuilt_cluster_count - rebuilt_cluster_count <= 16);
+
+	de_graph_vertex_t* gap = &graph.vertices.data[gap_y * size + wall_x];
+	start = &graph.vertices.data[50 * size + 5];
+	goal = &graph.vertices.data[50 * size + 60];
+	type = de_graph_hierarchy_find_path(&hierarchy, start, goal, &path);
+	DE_ASSERT(type == DE_GRAPH_PATH_TYPE_FULL);
+	DE_ASSERT(de_graph_is_path_valid(&graph, &path, start, goal));
+	bool passes_gap = false;
+	for (size_t i = 0; i < path.size; ++i) {
+		if (path.data[i] == gap) {
+			passes_gap = true;
+		}
+	}
+	DE_ASSERT(passes_gap);
+
+	/* close the gap, goal becomes unreachable */
+	de_graph_vertex_isolate(&graph, gap);
+	type = de_graph_hierarchy_find_path(&hierarchy, start, goal, &path);
+	DE_ASSERT(type == DE_GRAPH_PATH_TYPE_PARTIAL);
+	DE_ASSERT(path.data[0] != goal && DE_ARRAY_LAST(path) == start);
+	DE_ASSERT(de_graph_find_path(&graph, start, goal, &path) == DE_GRAPH_PATH_TYPE_PARTIAL);
+
+	/* open it again with new links */
+	de_graph_vertex_link_bidirect(gap, gap - 1);
+	de_graph_vertex_link_bidirect(gap, gap + 1);
+	type = de_graph_hierarchy_find_path(&hierarchy, start, goal, &path);
+	DE_ASSERT(type == DE_GRAPH_PATH_TYPE_FULL);
+	DE_ASSERT(de_graph_is_path_valid(&graph, &path, start, goal));
+
+	/* abstract edges stay bidirectional after incremental updates */
+	type = de_graph_hierarchy_find_path(&hierarchy, goal, start, &path);
+	DE_ASSERT(type == DE_GRAPH_PATH_TYPE_FULL);
+	DE_ASSERT(de_graph_is_path_valid(&graph, &path, goal, start));
+	DE_ASSERT(de_graph_hierarchy_is_symmetric(&hierarchy));
+
+	/* random isolation and restoration of vertices near cluster borders creates portals next
+	 * to existing ones in neighbour clusters */
+	char* isolated = de_calloc(graph.vertices.size, 1);
+	for (int i = 0; i < 300; ++i) {
+		const int x = de_irand(0, size - 1);
+		const int y = de_irand(0, size - 1);
+		de_graph_vertex_t* vertex = &graph.vertices.data[y * size + x];
+		if (!isolated[y * size + x]) {
+			de_graph_vertex_isolate(&graph, vertex);
+			isolated[y * size + x] = 1;
+		} else {
+			static const int dx[] = { 1, -1, 0, 0 };
+			static const int dy[] = { 0, 0, 1, -1 };
+			isolated[y * size + x] = 0;
+			for (int k = 0; k < 4; ++k) {
+				const int nx = x + dx[k];
+				const int ny = y + dy[k];
+				if (nx >= 0 && ny >= 0 && nx < size && ny < size && !isolated[ny * size + nx]) {
+					de_graph_vertex_link_bidirect(vertex, &graph.vertices.data[ny * size + nx]);
+				}
+			}
+		}
+		de_graph_hierarchy_update(&hierarchy);
+		DE_ASSERT(de_graph_hierarchy_is_symmetric(&hierarchy));
+	}
+	de_free(isolated);
+
+	DE_ARRAY_FREE(waypoints);
+	de_graph_hierarchy_free(&hierarchy);
+	de_graph_free(&graph);
+
+	/* baked graph */
+	de_graph_init(&graph);
+	de_graph_make_grid(&graph, size);
+	de_graph_bake(&graph);
+	de_graph_hierarchy_init(&hierarchy, &graph, 8.0f);
+	for (int i = 0; i < 100; ++i) {
+		de_graph_vertex_t* from = &graph.vertices.data[rand() % graph.vertices.size];
+		de_graph_vertex_t* to = &graph.vertices.data[rand() % graph.vertices.size];
+		type = de_graph_hierarchy_find_path(&hierarchy, from, to, &path);
+		DE_ASSERT(type == DE_GRAPH_PATH_TYPE_FULL);
+		DE_ASSERT(path.data[0] == to && DE_ARRAY_LAST(path) == from);
+	}
+	de_graph_hierarchy_free(&hierarchy);
+	de_graph_free(&graph);
+
+	DE_ARRAY_FREE(path);
+
+	de_graph_hierarchy_benchmark(320, 16.0f, 50);
+}
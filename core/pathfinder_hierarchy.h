@@ -0,0 +1,167 @@
+/* Copyright (c) 2017-2019 Dmitry Stepanov a.k.a mr.DIMAS
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+* OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+/**
+ * Hierarchical pathfinding (HPA*) on top of de_graph_t.
+ *
+ * Vertices of graph are partitioned into clusters using uniform spatial grid. Edges that cross border
+ * between two clusters are grouped into entrances - sets of linked border vertices, and middle edge of
+ * each entrance gives two portals, one on each side. Portals form abstract graph: portals of same
+ * cluster are connected by edges with cost of shortest path inside of cluster, portals of different
+ * clusters are connected by original edges of graph. Long-range search is done on abstract graph
+ * which is much smaller than original one, and abstract path is refined to a path over vertices of
+ * graph only when needed - refinement of each segment is local to one cluster.
+ *
+ * Hierarchy is updated incrementally: link/unlink/isolate functions mark clusters of changed
+ * vertices as dirty, and only dirty clusters are rebuilt before next search. Portals are never
+ * removed by incremental update, portal that lost its border edge just stays as an ordinary
+ * cluster vertex in abstract graph, it does not affect correctness.
+ *
+ * Path costs are the same as in de_graph_find_path. Paths found by hierarchy are not always
+ * optimal, but they are usually close to optimal ones.
+ */
+
+/**
+ * @brief Edge of abstract graph.
+ */
+typedef struct de_graph_abstract_edge_t {
+	uint32_t target; /**< Index of target portal. */
+	float cost;
+} de_graph_abstract_edge_t;
+
+/**
+ * @brief Vertex of graph which is a node of abstract graph.
+ */
+typedef struct de_graph_portal_t {
+	uint32_t vertex; /**< Index of vertex in graph. */
+	uint32_t cluster;
+	DE_ARRAY_DECLARE(de_graph_abstract_edge_t, edges);
+	float goal_cost; /**< Cost of path to goal vertex of current search, FLT_MAX if not known. */
+} de_graph_portal_t;
+
+/**
+ * @brief Edge of graph that crosses border of cluster.
+ */
+typedef struct de_graph_crossing_t {
+	uint32_t vertex;
+	uint32_t target;
+	uint32_t target_cluster;
+} de_graph_crossing_t;
+
+/**
+ * @brief Set of graph vertices inside of a cell of spatial grid.
+ */
+typedef struct de_graph_cluster_t {
+	DE_ARRAY_DECLARE(uint32_t, vertices); /**< Indices of vertices of graph. */
+	DE_ARRAY_DECLARE(uint32_t, portals); /**< Indices of portals of hierarchy. */
+	bool is_dirty; /**< Connectivity inside of cluster was changed, abstract edges must be rebuilt. */
+	bool is_scanned; /**< Portals of cluster are up to date. Used only during update. */
+} de_graph_cluster_t;
+
+/**
+ * @brief Per-node state of abstract search.
+ */
+typedef struct de_graph_abstract_state_t {
+	float g_score;
+	uint32_t parent; /**< UINT32_MAX if there is no parent. */
+	uint32_t generation;
+	bool is_closed;
+} de_graph_abstract_state_t;
+
+/**
+ * @brief Entry of open set of abstract search.
+ */
+typedef struct de_graph_abstract_open_t {
+	float f_score;
+	uint32_t node;
+} de_graph_abstract_open_t;
+
+typedef struct de_graph_hierarchy_t {
+	de_graph_t* graph;
+	float cluster_size;
+	de_vec3_t origin; /**< Minimal corner of cluster grid. */
+	uint32_t size_x;
+	uint32_t size_y;
+	uint32_t size_z;
+	de_graph_cluster_t* clusters; /**< Allocated once, vertices of graph store pointers to clusters. */
+	size_t cluster_count;
+	uint32_t* vertex_cluster; /**< Index of cluster for each vertex of graph. */
+	uint32_t* vertex_portal; /**< Index of portal for each vertex of graph, UINT32_MAX if vertex is not a portal. */
+	uint32_t* vertex_mark; /**< Scratch marks of vertices used to find entrances. */
+	uint32_t mark;
+	size_t vertex_count;
+	DE_ARRAY_DECLARE(de_graph_portal_t, portals);
+	size_t rebuilt_cluster_count; /**< Statistics: total amount of cluster rebuilds. */
+	/* Scratch data */
+	de_graph_search_context_t context; /**< Used for searches inside of clusters. */
+	DE_ARRAY_DECLARE(de_graph_abstract_state_t, states);
+	DE_ARRAY_DECLARE(de_graph_abstract_open_t, open_set); /**< Binary min-heap with lazy deletion. */
+	uint32_t generation;
+	DE_ARRAY_DECLARE(de_graph_abstract_edge_t, edges);
+	DE_ARRAY_DECLARE(de_graph_abstract_edge_t, start_edges);
+	DE_ARRAY_DECLARE(de_graph_crossing_t, crossings);
+	DE_ARRAY_DECLARE(uint32_t, entrance);
+	de_graph_path_t segment;
+} de_graph_hierarchy_t;
+
+/**
+ * @brief Builds hierarchy for specified graph. Graph vertices are partitioned into cubic clusters
+ * with side of cluster_size. Hierarchy must be rebuilt if vertices were added to or removed from
+ * graph, changes of links are handled automatically. Graph can be baked. Each graph can have only
+ * one hierarchy at a time.
+ */
+void de_graph_hierarchy_init(de_graph_hierarchy_t* hierarchy, de_graph_t* graph, float cluster_size);
+
+/**
+ * @brief Frees hierarchy resources. Must be called before graph is freed.
+ */
+void de_graph_hierarchy_free(de_graph_hierarchy_t* hierarchy);
+
+/**
+ * @brief Rebuilds abstract graph of dirty clusters. Called automatically by search functions.
+ */
+void de_graph_hierarchy_update(de_graph_hierarchy_t* hierarchy);
+
+/**
+ * @brief Searches path on abstract graph. Writes path as reversed array of waypoints: goal (or closest
+ * reachable vertex if path is partial), portals, start. Two successive waypoints are either vertices of
+ * one cluster or linked vertices. Result type has same meaning as in @ref de_graph_find_path.
+ */
+de_graph_path_type_t de_graph_hierarchy_find_abstract_path(de_graph_hierarchy_t* hierarchy, de_graph_vertex_t* start, de_graph_vertex_t* goal, de_graph_path_t* out_waypoints);
+
+/**
+ * @brief Refines up to max_segments segments of abstract path starting from its start, so path can be
+ * refined only near the agent. Writes reversed path over graph vertices to out_path, start of abstract
+ * path is last vertex. Returns amount of refined segments.
+ */
+size_t de_graph_hierarchy_refine_path(de_graph_hierarchy_t* hierarchy, const de_graph_path_t* waypoints, size_t max_segments, de_graph_path_t* out_path);
+
+/**
+ * @brief Finds abstract path and refines it completely. Writes reversed path to out_path, see
+ * @ref de_graph_find_path.
+ */
+de_graph_path_type_t de_graph_hierarchy_find_path(de_graph_hierarchy_t* hierarchy, de_graph_vertex_t* start, de_graph_vertex_t* goal, de_graph_path_t* out_path);
+
+/**
+ * @brief Tests. Also compares performance of hierarchical and plain search on large grid and
+ * prints results into log.
+ */
+void de_graph_hierarchy_tests();
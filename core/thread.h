@@ -117,4 +117,15 @@ void de_cnd_broadcast(de_cnd_t* cnd);
 /**
  * @brief Waits until awake signal is received.
  */
-void de_cnd_wait(de_cnd_t* cnd, de_mtx_t* mtx);
\ No newline at end of file
+void de_cnd_wait(de_cnd_t* cnd, de_mtx_t* mtx);
+
+/**
+ * @brief Returns amount of hardware threads (logical cores) available to the process. Never
+ * returns less than one.
+ */
+size_t de_thrd_hardware_concurrency(void);
+
+/**
+ * @brief Atomically adds amount to specified value and returns new value. Thread-safe.
+ */
+long de_atomic_add(volatile long* value, long amount);
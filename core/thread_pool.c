@@ -0,0 +1,263 @@
+/* Copyright (c) 2017-2019 Dmitry Stepanov a.k.a mr.DIMAS
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+* OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+typedef struct de_thread_pool_worker_t {
+	de_thread_pool_t* pool;
+	size_t thread_index;
+} de_thread_pool_worker_t;
+
+/**
+ * Job lives on stack of submitting thread until all of its items are processed.
+ */
+typedef struct de_thread_pool_job_t {
+	struct de_thread_pool_job_t* next_job; /**< Next job in list of pool. */
+	de_parallel_for_func_t func;
+	void* user_data;
+	size_t count; /**< Total amount of items. */
+	size_t batch_size;
+	size_t next; /**< Index of first item of next batch to be taken. */
+	size_t remaining; /**< Amount of items not processed yet. */
+} de_thread_pool_job_t;
+
+/**
+ * Takes next batch of job and processes it. Job is removed from list of pool when its last batch is
+ * taken. Mutex must be locked before call, it will be locked on return.
+ */
+static void de_thread_pool_run_batch(de_thread_pool_t* pool, de_thread_pool_job_t* job, size_t thread_index)
+{
+	const size_t begin = job->next;
+	const size_t end = begin + job->batch_size < job->count ? begin + job->batch_size : job->count;
+	job->next = end;
+	if (end == job->count) {
+		de_thread_pool_job_t** link = &pool->jobs;
+		while (*link != job) {
+			link = &(*link)->next_job;
+		}
+		*link = job->next_job;
+	}
+
+	de_mtx_unlock(&pool->mutex);
+	job->func(job->user_data, begin, end, thread_index);
+	de_mtx_lock(&pool->mutex);
+
+	job->remaining -= end - begin;
+	if (job->remaining == 0) {
+		de_cnd_broadcast(&pool->done_cnd);
+	}
+}
+
+static int de_thread_pool_worker_thread(void* arg)
+{
+	de_thread_pool_worker_t* worker = arg;
+	de_thread_pool_t* pool = worker->pool;
+	const size_t thread_index = worker->thread_index;
+	de_free(worker);
+
+	de_mtx_lock(&pool->mutex);
+	for (;;) {
+		while (!pool->shutdown && !pool->jobs) {
+			de_cnd_wait(&pool->job_cnd, &pool->mutex);
+		}
+		if (pool->shutdown) {
+			break;
+		}
+		de_thread_pool_run_batch(pool, pool->jobs, thread_index);
+	}
+	de_mtx_unlock(&pool->mutex);
+
+	return 0;
+}
+
+de_thread_pool_t* de_thread_pool_create(size_t worker_count)
+{
+	de_thread_pool_t* pool = DE_NEW(de_thread_pool_t);
+	if (worker_count == 0) {
+		worker_count = de_thrd_hardware_concurrency() - 1;
+	}
+	de_mtx_init(&pool->mutex);
+	de_cnd_init(&pool->job_cnd);
+	de_cnd_init(&pool->done_cnd);
+	DE_ARRAY_INIT(pool->threads);
+	for (size_t i = 0; i < worker_count; ++i) {
+		de_thread_pool_worker_t* worker = DE_NEW(de_thread_pool_worker_t);
+		worker->pool = pool;
+		/* Index 0 is reserved for submitting thread */
+		worker->thread_index = i + 1;
+		de_thrd_t* thread = DE_ARRAY_GROW(pool->threads, 1);
+		de_thrd_create(thread, de_thread_pool_worker_thread, worker);
+	}
+	return pool;
+}
+
+void de_thread_pool_free(de_thread_pool_t* pool)
+{
+	if (!pool) {
+		return;
+	}
+	de_mtx_lock(&pool->mutex);
+	DE_ASSERT(!pool->jobs);
+	pool->shutdown = true;
+	de_cnd_broadcast(&pool->job_cnd);
+	de_mtx_unlock(&pool->mutex);
+	for (size_t i = 0; i < pool->threads.size; ++i) {
+		de_thrd_join(&pool->threads.data[i]);
+	}
+	DE_ARRAY_FREE(pool->threads);
+	de_cnd_destroy(&pool->done_cnd);
+	de_cnd_destroy(&pool->job_cnd);
+	de_mtx_destroy(&pool->mutex);
+	de_free(pool);
+}
+
+size_t de_thread_pool_get_thread_count(const de_thread_pool_t* pool)
+{
+	return pool ? pool->threads.size + 1 : 1;
+}
+
+void de_thread_pool_parallel_for(de_thread_pool_t* pool, size_t count, size_t batch_size, de_parallel_for_func_t func, void* user_data)
+{
+	DE_ASSERT(func);
+
+	if (count == 0) {
+		return;
+	}
+
+	const size_t thread_count = de_thread_pool_get_thread_count(pool);
+
+	if (batch_size == 0) {
+		/* Few batches per thread gives good balance between load balancing and locking overhead */
+		batch_size = count / (4 * thread_count);
+		if (batch_size == 0) {
+			batch_size = 1;
+		}
+	}
+
+	/* No need to wake up workers if there is only one batch */
+	if (thread_count == 1 || batch_size >= count) {
+		func(user_data, 0, count, 0);
+		return;
+	}
+
+	de_thread_pool_job_t job = {
+		.func = func,
+		.user_data = user_data,
+		.count = count,
+		.batch_size = batch_size,
+		.remaining = count
+	};
+
+	de_mtx_lock(&pool->mutex);
+	job.next_job = pool->jobs;
+	pool->jobs = &job;
+	de_cnd_broadcast(&pool->job_cnd);
+
+	/* Submitting thread helps workers instead of just waiting. It takes only batches of its own job:
+	 * if it is a worker inside of outer job, batch of outer job would run with its thread index twice. */
+	while (job.next < job.count) {
+		de_thread_pool_run_batch(pool, &job, 0);
+	}
+
+	while (job.remaining > 0) {
+		de_cnd_wait(&pool->done_cnd, &pool->mutex);
+	}
+	de_mtx_unlock(&pool->mutex);
+}
+
+typedef struct de_thread_pool_test_t {
+	de_thread_pool_t* pool;
+	volatile long* hits; /**< How many times each item was processed. */
+	size_t count;
+	size_t inner_count; /**< Amount of items of nested job per item of outer job, zero for no nesting. */
+	volatile long bad_thread_index_count;
+} de_thread_pool_test_t;
+
+static void de_thread_pool_test_range(void* user_data, size_t begin, size_t end, size_t thread_index)
+{
+	de_thread_pool_test_t* test = user_data;
+	if (thread_index >= de_thread_pool_get_thread_count(test->pool)) {
+		de_atomic_add(&test->bad_thread_index_count, 1);
+	}
+	for (size_t i = begin; i < end; ++i) {
+		if (test->inner_count) {
+			de_thread_pool_test_t inner = {
+				.pool = test->pool,
+				.hits = test->hits + i * test->inner_count,
+				.count = test->inner_count
+			};
+			de_thread_pool_parallel_for(test->pool, inner.count, 7, de_thread_pool_test_range, &inner);
+			de_atomic_add(&test->bad_thread_index_count, inner.bad_thread_index_count);
+		} else {
+			de_atomic_add(&test->hits[i], 1);
+		}
+	}
+}
+
+static int de_thread_pool_test_thread(void* arg)
+{
+	de_thread_pool_test_t* test = arg;
+	for (int i = 0; i < 50; ++i) {
+		de_thread_pool_parallel_for(test->pool, test->count, 0, de_thread_pool_test_range, test);
+	}
+	return 0;
+}
+
+void de_thread_pool_tests()
+{
+	de_thread_pool_t* pool = de_thread_pool_create(3);
+
+	/* nested jobs: every item of outer job submits a job of its own */
+	const size_t outer_count = 64;
+	const size_t inner_count = 100;
+	de_thread_pool_test_t nested = {
+		.pool = pool,
+		.hits = de_calloc(outer_count * inner_count, sizeof(long)),
+		.count = outer_count,
+		.inner_count = inner_count
+	};
+	de_thread_pool_parallel_for(pool, outer_count, 1, de_thread_pool_test_range, &nested);
+	for (size_t i = 0; i < outer_count * inner_count; ++i) {
+		DE_ASSERT(nested.hits[i] == 1);
+	}
+	DE_ASSERT(nested.bad_thread_index_count == 0);
+	de_free((void*)nested.hits);
+
+	/* concurrent jobs: several threads submit to same pool at once, 50 times each */
+	de_thread_pool_test_t concurrent[4];
+	de_thrd_t threads[4];
+	for (size_t k = 0; k < 4; ++k) {
+		concurrent[k] = (de_thread_pool_test_t) {
+			.pool = pool,
+			.hits = de_calloc(1000, sizeof(long)),
+			.count = 1000
+		};
+		de_thrd_create(&threads[k], de_thread_pool_test_thread, &concurrent[k]);
+	}
+	for (size_t k = 0; k < 4; ++k) {
+		de_thrd_join(&threads[k]);
+		for (size_t i = 0; i < concurrent[k].count; ++i) {
+			DE_ASSERT(concurrent[k].hits[i] == 50);
+		}
+		DE_ASSERT(concurrent[k].bad_thread_index_count == 0);
+		de_free((void*)concurrent[k].hits);
+	}
+
+	de_thread_pool_free(pool);
+}
@@ -0,0 +1,79 @@
+/* Copyright (c) 2017-2019 Dmitry Stepanov a.k.a mr.DIMAS
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+* OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+/**
+ * Simple pool of worker threads built on top of core/thread.h.
+ *
+ * Job is a range of items which is split into batches and distributed between worker threads
+ * and the thread that submitted the job. Submitting thread is blocked until whole range is
+ * processed, meanwhile it takes batches of its own job only. Jobs can be submitted to same pool
+ * from multiple threads at once and from inside of other job. Workers take batches of newest
+ * job first, so nested jobs, which block batches of outer ones, are finished sooner.
+ */
+
+/**
+ * @brief Callback of parallel-for. Processes items in range [begin; end). thread_index is in
+ * range [0; de_thread_pool_get_thread_count()), it is unique among threads that run same
+ * job simultaneously and can be used to access per-thread scratch data of the job without
+ * locks. Submitting thread always has index 0.
+ */
+typedef void(*de_parallel_for_func_t)(void* user_data, size_t begin, size_t end, size_t thread_index);
+
+typedef struct de_thread_pool_t {
+	/* All fields are private. Do not access directly! */
+	DE_ARRAY_DECLARE(de_thrd_t, threads);
+	de_mtx_t mutex;
+	de_cnd_t job_cnd; /**< Signaled when new job was submitted or pool is shutting down. */
+	de_cnd_t done_cnd; /**< Signaled when last item of any job was processed. */
+	struct de_thread_pool_job_t* jobs; /**< Jobs which have batches not taken yet, newest first. */
+	bool shutdown;
+} de_thread_pool_t;
+
+/**
+ * @brief Creates new thread pool with specified amount of worker threads. If worker_count is zero,
+ * amount of workers will be selected automatically so total amount of threads running a job (including
+ * submitting thread) will be equal to amount of hardware threads.
+ */
+de_thread_pool_t* de_thread_pool_create(size_t worker_count);
+
+/**
+ * @brief Stops every worker thread and frees pool.
+ */
+void de_thread_pool_free(de_thread_pool_t* pool);
+
+/**
+ * @brief Returns maximum amount of threads that can run a job simultaneously: amount of workers plus
+ * submitting thread. Use it to allocate per-thread scratch data.
+ */
+size_t de_thread_pool_get_thread_count(const de_thread_pool_t* pool);
+
+/**
+ * @brief Calls func for every batch of items in range [0; count) using every thread of pool and
+ * blocks until all items are processed. batch_size is amount of items processed by single call,
+ * zero means that batch size will be selected automatically. Pool can be NULL, in this case
+ * whole range will be processed by calling thread.
+ */
+void de_thread_pool_parallel_for(de_thread_pool_t* pool, size_t count, size_t batch_size, de_parallel_for_func_t func, void* user_data);
+
+/**
+ * @brief Runs concurrent and nested jobs on pool and checks that every item is processed once per job.
+ */
+void de_thread_pool_tests();
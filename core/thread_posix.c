@@ -82,4 +82,15 @@ void de_cnd_broadcast(de_cnd_t* cnd)
 void de_cnd_wait(de_cnd_t* cnd, de_mtx_t* mtx)
 {
 	pthread_cond_wait(cnd, mtx);
-}
\ No newline at end of file
+}
+
+size_t de_thrd_hardware_concurrency(void)
+{
+	const long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (size_t)count : 1;
+}
+
+long de_atomic_add(volatile long* value, long amount)
+{
+	return __sync_add_and_fetch(value, amount);
+}
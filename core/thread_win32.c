@@ -87,3 +87,15 @@ void de_cnd_wait(de_cnd_t* cnd, de_mtx_t* mtx)
 {
 	SleepConditionVariableCS((CONDITION_VARIABLE*)cnd->handle, (CRITICAL_SECTION*)mtx->handle, INFINITE);
 }
+
+size_t de_thrd_hardware_concurrency(void)
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors > 0 ? (size_t)info.dwNumberOfProcessors : 1;
+}
+
+long de_atomic_add(volatile long* value, long amount)
+{
+	return InterlockedExchangeAdd(value, amount) + amount;
+}
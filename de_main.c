@@ -40,6 +40,7 @@
 #include "core/utility.c"
 #include "core/serialization.c"
 #include "core/pathfinder.c"
+#include "core/pathfinder_hierarchy.c"
 #include "core/core.c"
 #include "physics/physics.c"
 #include "fbx/fbx.c"
@@ -59,6 +60,7 @@
 #include "gui/gui.c" 
 #include "vg/vgraster.c"
 #include "core/thread.c"
+#include "core/thread_pool.c"
 #include "sound/sound.c"
 #include "resources/resource.c"
 
@@ -176,6 +176,7 @@ typedef struct de_video_mode_t de_video_mode_t;
 #include "core/array.h"
 #include "core/base64.h"
 #include "core/thread.h"
+#include "core/thread_pool.h"
 #include "core/string.h"
 #include "core/string_utils.h"
 #include "core/path.h"
@@ -190,6 +191,7 @@ typedef struct de_video_mode_t de_video_mode_t;
 #include "resources/builtin_fonts.h"
 #include "math/mathlib.h"
 #include "core/pathfinder.h"
+#include "core/pathfinder_hierarchy.h"
 #include "core/rect.h"
 #include "core/serialization.h"
 #include "math/triangulator.h"	
@@ -202,8 +204,8 @@ typedef struct de_video_mode_t de_video_mode_t;
 #include "scene/particle_system.h"
 #include "scene/node.h"
 #include "scene/animation.h"
-#include "scene/scene.h"
 #include "physics/physics.h"
+#include "scene/scene.h"
 #include "renderer/surface.h"
 #include "fbx/fbx.h"
 #include "renderer/renderer.h"
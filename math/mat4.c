@@ -264,6 +264,28 @@ void de_mat4_rotation(de_mat4_t * out, const de_quat_t * q)
 	out->f[15] = 1.0f;
 }
 
+void de_mat4_trs(de_mat4_t * out, const de_vec3_t * t, const de_quat_t * q, const de_vec3_t * s)
+{
+	/* columns of rotation matrix are scaled, translation is last column */
+	de_mat4_rotation(out, q);
+
+	out->f[0] *= s->x;
+	out->f[1] *= s->x;
+	out->f[2] *= s->x;
+
+	out->f[4] *= s->y;
+	out->f[5] *= s->y;
+	out->f[6] *= s->y;
+
+	out->f[8] *= s->z;
+	out->f[9] *= s->z;
+	out->f[10] *= s->z;
+
+	out->f[12] = t->x;
+	out->f[13] = t->y;
+	out->f[14] = t->z;
+}
+
 void de_mat4_rotation_x(de_mat4_t * out, float angle_radians)
 {
 	float c = (float)cos(angle_radians);
@@ -122,6 +122,15 @@ void de_mat4_inverse(de_mat4_t* out, const de_mat4_t* a);
  */
 void de_mat4_rotation(de_mat4_t* out, const struct de_quat_t* q);
 
+/**
+ * @brief Builds translation * rotation * scale matrix directly, without matrix multiplications.
+ * @param out pointer to output matrix
+ * @param t translation
+ * @param q rotation quaternion
+ * @param s scale
+ */
+void de_mat4_trs(de_mat4_t* out, const de_vec3_t* t, const struct de_quat_t* q, const de_vec3_t* s);
+
 /**
  * @brief Builds rotation matrix around (1, 0, 0) axis
  * @param out pointer to output matrix
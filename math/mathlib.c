@@ -278,7 +278,15 @@ float de_frand(float min, float max)
 
 int de_irand(int min, int max)
 {
-	return min + rand() * (max - min) / (int)RAND_MAX;
+	/* 64-bit product, rand() * (max - min) overflows int for ranges wider than a few elements */
+	return min + (int)((int64_t)rand() * (max - min) / RAND_MAX);
+}
+
+float de_frand_r(uint32_t* state, float min, float max)
+{
+	/* linear congruential generator, any state is valid; low bits have short period so only upper 24 are used */
+	*state = *state * 1664525u + 1013904223u;
+	return min + (*state >> 8) / (float)0xFFFFFF * (max - min);
 }
 
 de_vec3_t de_point_cloud_get_farthest_point(const de_vec3_t* points, int count, const de_vec3_t* dir)
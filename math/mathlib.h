@@ -161,6 +161,12 @@ float de_frand(float min, float max);
  */
 int de_irand(int min, int max);
 
+/**
+ * @brief Returns random real number in range [min; max] and advances given state. Does not use
+ * global state of rand(), so can be called from multiple threads, each with its own state.
+ */
+float de_frand_r(uint32_t* state, float min, float max);
+
 de_vec3_t de_point_cloud_get_farthest_point(const de_vec3_t* points, int count, const de_vec3_t* dir);
 
 void de_get_barycentric_coords(const de_vec3_t* p, const de_vec3_t* a, const de_vec3_t* b, const de_vec3_t* c, float *u, float *v, float *w);
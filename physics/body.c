@@ -153,7 +153,7 @@ void de_body_triangle_collision(de_static_geometry_t* geom, de_static_triangle_t
 }
 #endif
 
-static void de_sphere_sphere_body_collision(de_body_t* body, de_body_t* other)
+static bool de_sphere_sphere_body_collision(de_body_t* body, de_body_t* other)
 {
 	const de_sphere_shape_t* shape = de_convex_shape_to_sphere(&body->shape);
 	const de_sphere_shape_t* other_shape = de_convex_shape_to_sphere(&other->shape);
@@ -188,21 +188,44 @@ static void de_sphere_sphere_body_collision(de_body_t* body, de_body_t* other)
 			contact->triangle = NULL;
 			contact->geometry = NULL;
 		}
+		return true;
 	}
+	return false;
 }
 
-void de_body_body_collision(de_body_t* body, de_body_t* other)
+de_vec3_t* de_body_get_cached_search_dir(de_body_t* body, const void* key, uint32_t step)
 {
+	de_contact_cache_entry_t* victim = &body->contact_cache[0];
+	for (int i = 0; i < DE_BODY_CONTACT_CACHE_SIZE; ++i) {
+		de_contact_cache_entry_t* entry = &body->contact_cache[i];
+		if (entry->key == key && entry->step + 1 >= step) {
+			entry->step = step;
+			return &entry->search_dir;
+		}
+		if (entry->step < victim->step) {
+			victim = entry;
+		}
+	}
+	victim->key = key;
+	victim->step = step;
+	victim->search_dir = (de_vec3_t) { 0, 0, 0 };
+	return &victim->search_dir;
+}
+
+/* search_dir is warm start of GJK for this pair, see de_gjk_is_intersects_ex */
+bool de_body_body_collision(de_body_t* body, de_body_t* other, de_vec3_t* search_dir, int* support_count)
+{
+	*support_count = 0;
 	if (body->shape.type == DE_CONVEX_SHAPE_TYPE_SPHERE && other->shape.type == DE_CONVEX_SHAPE_TYPE_SPHERE) {
 		/* Special, very fast method to resolve collisions between two spheres */
-		de_sphere_sphere_body_collision(body, other);
+		return de_sphere_sphere_body_collision(body, other);
 	} else {
 		/* Generic collisions between two convex bodies */
 		de_convex_shape_t* shape1 = &body->shape;
 		de_convex_shape_t* shape2 = &other->shape;
 
 		de_simplex_t simplex;
-		if (de_gjk_is_intersects(shape1, &body->position, shape2, &other->position, &simplex)) {
+		if (de_gjk_is_intersects_ex(shape1, &body->position, shape2, &other->position, search_dir, &simplex, support_count)) {
 			de_vec3_t penetration_vector;
 			de_vec3_t contact_point;
 			if (de_epa_get_penetration_info(&simplex, shape1, &body->position, shape2, &other->position, &penetration_vector, &contact_point)) {
@@ -233,21 +256,29 @@ void de_body_body_collision(de_body_t* body, de_body_t* other)
 						contact->triangle = NULL;
 						contact->geometry = NULL;
 					}
+					return true;
 				}
 			}
 		}
 	}
+	return false;
 }
 
 void de_body_add_acceleration(de_body_t* body, const de_vec3_t* acceleration)
 {
 	DE_ASSERT(body);
 	de_vec3_add(&body->acceleration, &body->acceleration, acceleration);
+	if (de_vec3_sqr_len(acceleration) > 0.0f) {
+		de_body_wake_up(body);
+	}
 }
 
 void de_body_set_gravity(de_body_t* body, const de_vec3_t * gravity)
 {
 	DE_ASSERT(body);
+	if (memcmp(&body->gravity, gravity, sizeof(*gravity)) != 0) {
+		de_body_wake_up(body);
+	}
 	body->gravity = *gravity;
 }
 
@@ -256,6 +287,34 @@ void de_body_set_position(de_body_t* body, const de_vec3_t * pos)
 	DE_ASSERT(body);
 	body->position = *pos;
 	body->last_position = *pos;
+	/* teleport, no interpolation from old position */
+	body->step_start_position = *pos;
+	de_body_wake_up(body);
+}
+
+void de_body_wake_up(de_body_t* body)
+{
+	DE_ASSERT(body);
+	body->sleeping = false;
+	body->rest_step_count = 0;
+}
+
+bool de_body_is_sleeping(const de_body_t* body)
+{
+	DE_ASSERT(body);
+	return body->sleeping;
+}
+
+void de_body_set_ccd_enabled(de_body_t* body, bool enabled)
+{
+	DE_ASSERT(body);
+	body->ccd = enabled;
+}
+
+bool de_body_is_ccd_enabled(const de_body_t* body)
+{
+	DE_ASSERT(body);
+	return body->ccd;
 }
 
 void de_body_get_position(const de_body_t* body, de_vec3_t* pos)
@@ -264,6 +323,16 @@ void de_body_get_position(const de_body_t* body, de_vec3_t* pos)
 	*pos = body->position;
 }
 
+void de_body_get_interpolated_position(const de_body_t* body, float t, de_vec3_t* pos)
+{
+	DE_ASSERT(body);
+	if (t >= 1.0f) {
+		*pos = body->position;
+	} else {
+		de_vec3_lerp(pos, &body->step_start_position, &body->position, t);
+	}
+}
+
 size_t de_body_get_contact_count(de_body_t* body)
 {
 	DE_ASSERT(body);
@@ -298,6 +367,9 @@ void de_body_move(de_body_t* body, const de_vec3_t* velocity)
 {
 	DE_ASSERT(body);
 	de_vec3_add(&body->position, &body->position, velocity);
+	if (de_vec3_sqr_len(velocity) > 0.0f) {
+		de_body_wake_up(body);
+	}
 }
 
 void de_body_set_velocity(de_body_t* body, const de_vec3_t* velocity)
@@ -305,24 +377,37 @@ void de_body_set_velocity(de_body_t* body, const de_vec3_t* velocity)
 	DE_ASSERT(body);
 	body->last_position = body->position;
 	de_vec3_sub(&body->last_position, &body->last_position, velocity);
+	/* sleeping body has zero velocity, so setting zero velocity does not wake it up */
+	if (de_vec3_sqr_len(velocity) > 0.0f) {
+		de_body_wake_up(body);
+	}
 }
 
 void de_body_set_y_velocity(de_body_t* body, float y_velocity)
 {
 	DE_ASSERT(body);
 	body->last_position.y = body->position.y - y_velocity;
+	if (y_velocity != 0.0f) {
+		de_body_wake_up(body);
+	}
 }
 
 void de_body_set_x_velocity(de_body_t* body, float x_velocity)
 {
 	DE_ASSERT(body);
 	body->last_position.x = body->position.x - x_velocity;
+	if (x_velocity != 0.0f) {
+		de_body_wake_up(body);
+	}
 }
 
 void de_body_set_z_velocity(de_body_t* body, float z_velocity)
 {
 	DE_ASSERT(body);
 	body->last_position.z = body->position.z - z_velocity;
+	if (z_velocity != 0.0f) {
+		de_body_wake_up(body);
+	}
 }
 
 void de_body_get_velocity(de_body_t* body, de_vec3_t * velocity)
@@ -331,18 +416,6 @@ void de_body_get_velocity(de_body_t* body, de_vec3_t * velocity)
 	de_vec3_sub(velocity, &body->position, &body->last_position);
 }
 
-static de_convex_shape_t de_convex_shape_copy(de_convex_shape_t* shape)
-{
-	if (shape->type == DE_CONVEX_SHAPE_TYPE_POINT_CLOUD) {
-		/* Point cloud is special becuase it contains heap-allocated memory which we 
-		 * must copy, not share between multiple shapes to prevent double free. */
-		de_convex_shape_t copy;		
-		DE_ARRAY_COPY(shape->s.point_cloud.points, copy.s.point_cloud.points);
-	}
-	/* In other cases we can make byte-to-byte copy */
-	return *shape;
-}
-
 de_body_t* de_body_create(de_scene_t* s, de_convex_shape_t shape)
 {
 	DE_ASSERT(s);
@@ -377,8 +450,10 @@ de_body_t* de_body_copy(de_scene_t* dest_scene, de_body_t* body)
 	copy->gravity = body->gravity;
 	copy->position = body->position;
 	copy->last_position = body->last_position;
+	copy->step_start_position = body->step_start_position;
 	copy->acceleration = body->acceleration;
 	copy->shape = de_convex_shape_copy(&body->shape);
 	copy->friction = body->friction;
+	copy->ccd = body->ccd;
 	return copy;
 }
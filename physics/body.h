@@ -19,6 +19,17 @@
 * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
 * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
 
+/**
+ * @brief Entry of contact cache of body: last separating axis found by GJK for body and one triangle
+ * or other body. Used as initial search direction of GJK on next step, pair which stays separated is
+ * rejected with one support point.
+ */
+typedef struct de_contact_cache_entry_t {
+	const void* key; /**< Triangle of static geometry or other body. */
+	de_vec3_t search_dir; /**< Zero if pair was intersecting. */
+	uint32_t step; /**< Index of physics step when entry was used last time. */
+} de_contact_cache_entry_t;
+
 /**
  * @class de_body_s
  * @brief Body type for position-based physics.
@@ -29,13 +40,25 @@ struct de_body_t {
 	de_vec3_t gravity;
 	de_vec3_t position; /**< Global position of body */
 	de_vec3_t last_position; /**< Global position of previous frame */
+	de_vec3_t step_start_position; /**< Position before last physics step, rendered position is interpolated from it. */
 	de_vec3_t acceleration; /**< Acceleration of a body in m/s^2 */
 	float friction; /**< Friction coefficient [0; 1]. Zero means no friction */
 	de_contact_t contacts[DE_MAX_CONTACTS]; /**< Array of contacts. */
 	int contact_count; /**< Actual count of physical contacts */	
+	bool sleeping; /**< Sleeping body is not integrated and keeps contacts of last step it was awake. */
+	int rest_step_count; /**< Amount of consecutive steps body barely moved. */
+	bool ccd; /**< Continuous collision detection with static geometry, see de_body_set_ccd_enabled. */
+	de_contact_cache_entry_t contact_cache[DE_BODY_CONTACT_CACHE_SIZE]; /**< Written only by threads which own body. */
 	DE_LINKED_LIST_ITEM(de_body_t);
 };
 
+/**
+ * @brief Returns search direction cached for pair of body and key (triangle or other body) to be
+ * passed into de_gjk_is_intersects_ex. Entries not used on this or previous step are stale, new
+ * pair takes place of the least recently used entry and starts with zero direction.
+ */
+de_vec3_t* de_body_get_cached_search_dir(de_body_t* body, const void* key, uint32_t step);
+
 /**
 * @brief Frees all resources associated with body
 * @param body pointer to body
@@ -104,11 +127,42 @@ void de_body_set_position(de_body_t* body, const de_vec3_t* pos);
  */
 void de_body_get_position(const de_body_t* body, de_vec3_t* pos);
 
+/**
+ * @brief Returns position between position before last physics step (t = 0) and current position
+ * (t = 1). Used to smoothly render bodies simulated with fixed timestep, see de_physics_set_fixed_step.
+ */
+void de_body_get_interpolated_position(const de_body_t* body, float t, de_vec3_t* pos);
+
 /**
  * @brief Applies specified amount of acceleration to specified body.
  */
 void de_body_add_acceleration(de_body_t* body, const de_vec3_t* acceleration);
 
+/**
+ * @brief Wakes up sleeping body. Body falls asleep when it barely moves for DE_BODY_SLEEP_STEP_COUNT
+ * steps and wakes up when moving body collides with it, when static geometry around it changes or
+ * when its position, velocity, acceleration or gravity is changed using body functions.
+ */
+void de_body_wake_up(de_body_t* body);
+
+/**
+ * @brief Returns true if body is sleeping, see @ref de_body_wake_up.
+ */
+bool de_body_is_sleeping(const de_body_t* body);
+
+/**
+ * @brief Enables continuous collision detection (CCD) of body with static geometry. Sphere inscribed
+ * in body shape is swept from last position to new position each step and body is stopped at first
+ * time of impact, so fast body does not tunnel through thin walls. Costs one extra BVH query per step
+ * when body moves faster than DE_BODY_CCD_RADIUS_FRACTION of its size, disabled by default.
+ */
+void de_body_set_ccd_enabled(de_body_t* body, bool enabled);
+
+/**
+ * @brief Returns true if continuous collision detection is enabled for body.
+ */
+bool de_body_is_ccd_enabled(const de_body_t* body);
+
 /**
  * @brief Returns total amount of physical contacts.
  */
@@ -0,0 +1,216 @@
+/* Copyright (c) 2017-2019 Dmitry Stepanov a.k.a mr.DIMAS
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+* OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.*/
+
+static int de_broadphase_proxy_comparer(const void* a, const void* b)
+{
+	const de_broadphase_proxy_t* proxy_a = a;
+	const de_broadphase_proxy_t* proxy_b = b;
+	if (proxy_a->min.x < proxy_b->min.x) {
+		return -1;
+	} else if (proxy_a->min.x > proxy_b->min.x) {
+		return 1;
+	}
+	/* equal keys are ordered by index, so result does not depend on qsort implementation */
+	return proxy_a->index < proxy_b->index ? -1 : (proxy_a->index > proxy_b->index ? 1 : 0);
+}
+
+static int de_broadphase_pair_comparer(const void* a, const void* b)
+{
+	const de_broadphase_pair_t* pair_a = a;
+	const de_broadphase_pair_t* pair_b = b;
+	if (pair_a->a != pair_b->a) {
+		return pair_a->a < pair_b->a ? -1 : 1;
+	}
+	if (pair_a->b != pair_b->b) {
+		return pair_a->b < pair_b->b ? -1 : 1;
+	}
+	return 0;
+}
+
+void de_broadphase_init(de_broadphase_t* broadphase)
+{
+	DE_ARRAY_INIT(broadphase->proxies);
+	DE_ARRAY_INIT(broadphase->pairs);
+	DE_ARRAY_INIT(broadphase->batches);
+	DE_ARRAY_INIT(broadphase->body_batches);
+	DE_ARRAY_INIT(broadphase->sorted_pairs);
+}
+
+void de_broadphase_free(de_broadphase_t* broadphase)
+{
+	DE_ARRAY_FREE(broadphase->proxies);
+	DE_ARRAY_FREE(broadphase->pairs);
+	DE_ARRAY_FREE(broadphase->batches);
+	DE_ARRAY_FREE(broadphase->body_batches);
+	DE_ARRAY_FREE(broadphase->sorted_pairs);
+}
+
+void de_broadphase_find_pairs(de_broadphase_t* broadphase, de_body_t* first_body)
+{
+	DE_ARRAY_CLEAR(broadphase->proxies);
+	DE_ARRAY_CLEAR(broadphase->pairs);
+	DE_ARRAY_CLEAR(broadphase->batches);
+	DE_ARRAY_CLEAR(broadphase->body_batches);
+
+	size_t index = 0;
+	for (de_body_t* body = first_body; body; body = body->next) {
+		de_broadphase_proxy_t* proxy = DE_ARRAY_GROW(broadphase->proxies, 1);
+		de_convex_shape_get_aabb(&body->shape, &body->position, &proxy->min, &proxy->max);
+		proxy->body = body;
+		proxy->index = index++;
+		DE_ARRAY_APPEND(broadphase->body_batches, 0);
+	}
+
+	DE_ARRAY_QSORT(broadphase->proxies, de_broadphase_proxy_comparer);
+
+	/* sweep along X axis, every box is tested only with boxes which start inside of it */
+	const de_broadphase_proxy_t* proxies = broadphase->proxies.data;
+	const size_t count = broadphase->proxies.size;
+	uint32_t* body_batches = broadphase->body_batches.data;
+	uint32_t batch_count = 0;
+	for (size_t i = 0; i < count; ++i) {
+		const de_broadphase_proxy_t* a = proxies + i;
+		for (size_t k = i + 1; k < count && proxies[k].min.x <= a->max.x; ++k) {
+			const de_broadphase_proxy_t* b = proxies + k;
+			if (a->min.y <= b->max.y && a->max.y >= b->min.y && a->min.z <= b->max.z && a->max.z >= b->min.z) {
+				de_broadphase_pair_t* pair = DE_ARRAY_GROW(broadphase->pairs, 1);
+				if (a->index < b->index) {
+					pair->a = a->body;
+					pair->b = b->body;
+				} else {
+					pair->a = b->body;
+					pair->b = a->body;
+				}
+				const uint32_t a_batch = body_batches[a->index];
+				const uint32_t b_batch = body_batches[b->index];
+				pair->batch = a_batch > b_batch ? a_batch : b_batch;
+				body_batches[a->index] = body_batches[b->index] = pair->batch + 1;
+				if (pair->batch + 1 > batch_count) {
+					batch_count = pair->batch + 1;
+				}
+			}
+		}
+	}
+
+	/* stable counting sort of pairs by batch */
+	DE_ARRAY_GROW(broadphase->batches, batch_count + 1);
+	size_t* batches = broadphase->batches.data;
+	memset(batches, 0, (batch_count + 1) * sizeof(*batches));
+	for (size_t i = 0; i < broadphase->pairs.size; ++i) {
+		++batches[broadphase->pairs.data[i].batch + 1];
+	}
+	for (uint32_t i = 0; i < batch_count; ++i) {
+		batches[i + 1] += batches[i];
+	}
+	DE_ARRAY_CLEAR(broadphase->sorted_pairs);
+	DE_ARRAY_GROW(broadphase->sorted_pairs, broadphase->pairs.size);
+	for (size_t i = 0; i < broadphase->pairs.size; ++i) {
+		const de_broadphase_pair_t* pair = broadphase->pairs.data + i;
+		broadphase->sorted_pairs.data[batches[pair->batch]++] = *pair;
+	}
+	/* offsets were shifted by placement, restore them */
+	for (uint32_t i = batch_count; i > 0; --i) {
+		batches[i] = batches[i - 1];
+	}
+	batches[0] = 0;
+	if (broadphase->pairs.size) {
+		memcpy(broadphase->pairs.data, broadphase->sorted_pairs.data, broadphase->pairs.size * sizeof(*broadphase->pairs.data));
+	}
+}
+
+size_t de_broadphase_get_batch_count(const de_broadphase_t* broadphase)
+{
+	return broadphase->batches.size ? broadphase->batches.size - 1 : 0;
+}
+
+void de_broadphase_tests()
+{
+	de_scene_t scene = { 0 };
+	const size_t body_count = 2000;
+	const float size = 100.0f;
+	for (size_t i = 0; i < body_count; ++i) {
+		de_convex_shape_t shape;
+		if (i % 2) {
+			shape = de_convex_shape_create_sphere(0.5f + rand() / (float)RAND_MAX);
+		} else {
+			shape = de_convex_shape_create_capsule(DE_AXIS_Y, 0.5f, 1.0f + rand() / (float)RAND_MAX);
+		}
+		de_body_t* body = de_body_create(&scene, shape);
+		de_body_set_position(body, &(de_vec3_t) { size * (rand() / (float)RAND_MAX), size * 0.1f * (rand() / (float)RAND_MAX), size * (rand() / (float)RAND_MAX) });
+	}
+
+	de_broadphase_t broadphase;
+	de_broadphase_init(&broadphase);
+
+	double start_time = de_time_get_seconds();
+	de_broadphase_find_pairs(&broadphase, scene.bodies.head);
+	const double broadphase_time = de_time_get_seconds() - start_time;
+
+	/* brute force over every unordered pair must give same set of pairs */
+	DE_ARRAY_DECLARE(de_broadphase_pair_t, expected);
+	DE_ARRAY_INIT(expected);
+	start_time = de_time_get_seconds();
+	for (de_body_t* a = scene.bodies.head; a; a = a->next) {
+		de_vec3_t a_min, a_max;
+		de_convex_shape_get_aabb(&a->shape, &a->position, &a_min, &a_max);
+		for (de_body_t* b = a->next; b; b = b->next) {
+			de_vec3_t b_min, b_max;
+			de_convex_shape_get_aabb(&b->shape, &b->position, &b_min, &b_max);
+			if (a_min.x <= b_max.x && a_max.x >= b_min.x && a_min.y <= b_max.y && a_max.y >= b_min.y && a_min.z <= b_max.z && a_max.z >= b_min.z) {
+				de_broadphase_pair_t pair = { .a = a, .b = b };
+				DE_ARRAY_APPEND(expected, pair);
+			}
+		}
+	}
+	const double brute_force_time = de_time_get_seconds() - start_time;
+
+	/* no body may appear twice in one batch and every pair must be in its batch */
+	DE_ASSERT(broadphase.batches.data[0] == 0);
+	DE_ASSERT(broadphase.batches.data[de_broadphase_get_batch_count(&broadphase)] == broadphase.pairs.size);
+	for (size_t i = 0; i < de_broadphase_get_batch_count(&broadphase); ++i) {
+		for (size_t k = broadphase.batches.data[i]; k < broadphase.batches.data[i + 1]; ++k) {
+			const de_broadphase_pair_t* pair = broadphase.pairs.data + k;
+			DE_ASSERT(pair->batch == i);
+			for (size_t j = k + 1; j < broadphase.batches.data[i + 1]; ++j) {
+				const de_broadphase_pair_t* other = broadphase.pairs.data + j;
+				DE_ASSERT(pair->a != other->a && pair->a != other->b && pair->b != other->a && pair->b != other->b);
+			}
+		}
+	}
+
+	DE_ASSERT(expected.size > 0);
+	DE_ASSERT(expected.size == broadphase.pairs.size);
+	DE_ARRAY_QSORT(expected, de_broadphase_pair_comparer);
+	DE_ARRAY_QSORT(broadphase.pairs, de_broadphase_pair_comparer);
+	for (size_t i = 0; i < expected.size; ++i) {
+		DE_ASSERT(expected.data[i].a == broadphase.pairs.data[i].a);
+		DE_ASSERT(expected.data[i].b == broadphase.pairs.data[i].b);
+	}
+
+	de_log("broadphase benchmark: %d bodies, %d pairs in %d batches in %f s, brute force in %f s",
+		(int)body_count, (int)broadphase.pairs.size, (int)de_broadphase_get_batch_count(&broadphase), broadphase_time, brute_force_time);
+
+	DE_ARRAY_FREE(expected);
+	de_broadphase_free(&broadphase);
+	while (scene.bodies.head) {
+		de_body_free(scene.bodies.head);
+	}
+}
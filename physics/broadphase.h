@@ -0,0 +1,82 @@
+/* Copyright (c) 2017-2019 Dmitry Stepanov a.k.a mr.DIMAS
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+* OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+/**
+ * Sweep-and-prune broadphase for body-body collisions.
+ *
+ * Bounding boxes of bodies are sorted along X axis, then overlapping boxes are found in one sweep
+ * over sorted array. This gives unique pairs of bodies which may collide, so expensive narrowphase
+ * (GJK/EPA) runs only for them and only once per pair.
+ */
+
+typedef struct de_broadphase_proxy_t {
+	de_vec3_t min;
+	de_vec3_t max;
+	de_body_t* body;
+	size_t index; /**< Index of body in scene, used to make order of pairs stable. */
+} de_broadphase_proxy_t;
+
+typedef struct de_broadphase_pair_t {
+	de_body_t* a; /**< Body which goes first in scene. */
+	de_body_t* b;
+	uint32_t batch; /**< Index of batch pair belongs to. */
+} de_broadphase_pair_t;
+
+/**
+ * Pairs are split into batches so no body appears twice in one batch, which means that pairs of
+ * one batch can be resolved in parallel. Batches must be resolved one after another in order.
+ * Every pair is placed into batch right after last batch that touches any of its bodies, so each
+ * body sees exactly same sequence of pair resolutions as in serial loop over pairs in order they
+ * were found - results do not depend on amount of threads.
+ */
+typedef struct de_broadphase_t {
+	DE_ARRAY_DECLARE(de_broadphase_proxy_t, proxies);
+	DE_ARRAY_DECLARE(de_broadphase_pair_t, pairs); /**< Result of last @ref de_broadphase_find_pairs, sorted by batch. */
+	DE_ARRAY_DECLARE(size_t, batches); /**< batch_count + 1 offsets, batch i is pairs [batches[i]; batches[i + 1]) */
+	DE_ARRAY_DECLARE(uint32_t, body_batches); /**< Scratch: first batch free for body, indexed by body index. */
+	DE_ARRAY_DECLARE(de_broadphase_pair_t, sorted_pairs); /**< Scratch for sorting pairs by batch. */
+} de_broadphase_t;
+
+/**
+ * @brief Prepares broadphase.
+ */
+void de_broadphase_init(de_broadphase_t* broadphase);
+
+/**
+ * @brief Frees broadphase resources.
+ */
+void de_broadphase_free(de_broadphase_t* broadphase);
+
+/**
+ * @brief Finds unique pairs of bodies with overlapping bounding boxes in linked list of bodies
+ * starting from first_body. Writes them into pairs array of broadphase and splits them into batches.
+ */
+void de_broadphase_find_pairs(de_broadphase_t* broadphase, de_body_t* first_body);
+
+/**
+ * @brief Returns amount of batches found by last @ref de_broadphase_find_pairs.
+ */
+size_t de_broadphase_get_batch_count(const de_broadphase_t* broadphase);
+
+/**
+ * @brief Tests. Compares pairs with brute force, checks batches and prints timings into log.
+ */
+void de_broadphase_tests();
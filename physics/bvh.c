@@ -0,0 +1,1224 @@
+/* Copyright (c) 2017-2019 Dmitry Stepanov a.k.a mr.DIMAS
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+* OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.*/
+
+#define DE_BVH_BIN_COUNT (16)
+
+typedef struct de_bvh_triangle_t {
+	de_vec3_t min;
+	de_vec3_t max;
+	de_vec3_t center;
+} de_bvh_triangle_t;
+
+typedef struct de_bvh_bin_t {
+	de_vec3_t min;
+	de_vec3_t max;
+	size_t count;
+} de_bvh_bin_t;
+
+/* Value of count of top level node which is replaced by subtree, first is index of subtree. */
+#define DE_BVH_SUBTREE_NODE (UINT32_MAX)
+
+/* Nodes with fewer triangles are not split into subtrees to build them in parallel. */
+#define DE_BVH_MIN_SUBTREE_SIZE (4096)
+
+typedef struct de_bvh_subtree_t {
+	size_t first;
+	size_t count;
+	int depth;
+	de_bvh_node_t* nodes;
+	size_t node_count;
+	size_t leaf_count;
+} de_bvh_subtree_t;
+
+typedef struct de_bvh_builder_t {
+	const de_bvh_triangle_t* triangles;
+	uint32_t* order;
+	size_t max_triangles_per_leaf;
+	de_bvh_node_t* nodes;
+	size_t node_count;
+	size_t leaf_count;
+	size_t subtree_size; /**< Nodes with at most this amount of triangles are deferred as subtrees. Zero disables. */
+	DE_ARRAY_DECLARE(de_bvh_subtree_t, subtrees);
+} de_bvh_builder_t;
+
+typedef struct de_bvh_prepare_t {
+	de_bvh_triangle_t* triangles;
+	const void* src_triangles;
+	int pos_stride;
+	uint32_t* order;
+} de_bvh_prepare_t;
+
+static void de_bvh_bounds_reset(de_vec3_t* min, de_vec3_t* max)
+{
+	*min = (de_vec3_t) { FLT_MAX, FLT_MAX, FLT_MAX };
+	*max = (de_vec3_t) { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+}
+
+static void de_bvh_bounds_merge(de_vec3_t* min, de_vec3_t* max, const de_vec3_t* other_min, const de_vec3_t* other_max)
+{
+	min->x = de_minf(min->x, other_min->x);
+	min->y = de_minf(min->y, other_min->y);
+	min->z = de_minf(min->z, other_min->z);
+	max->x = de_maxf(max->x, other_max->x);
+	max->y = de_maxf(max->y, other_max->y);
+	max->z = de_maxf(max->z, other_max->z);
+}
+
+/**
+ * @brief Returns half of surface area of box, empty box has zero area.
+ */
+static float de_bvh_bounds_half_area(const de_vec3_t* min, const de_vec3_t* max)
+{
+	const float dx = max->x - min->x;
+	const float dy = max->y - min->y;
+	const float dz = max->z - min->z;
+	if (dx < 0.0f || dy < 0.0f || dz < 0.0f) {
+		return 0.0f;
+	}
+	return dx * dy + dy * dz + dz * dx;
+}
+
+static float de_bvh_get_axis(const de_vec3_t* v, int axis)
+{
+	return axis == 0 ? v->x : (axis == 1 ? v->y : v->z);
+}
+
+static int de_bvh_get_bin(float value, float bin_min, float bin_scale)
+{
+	const int bin = (int)((value - bin_min) * bin_scale);
+	return bin < DE_BVH_BIN_COUNT ? bin : DE_BVH_BIN_COUNT - 1;
+}
+
+static uint32_t de_bvh_build_recursive(de_bvh_builder_t* builder, size_t first, size_t count, int depth)
+{
+	uint32_t* order = builder->order + first;
+
+	/* node array is allocated for worst case before build, so pointer stays valid */
+	const uint32_t index = (uint32_t)builder->node_count++;
+	de_bvh_node_t* node = &builder->nodes[index];
+
+	if (count <= builder->subtree_size && count > builder->max_triangles_per_leaf) {
+		de_bvh_subtree_t subtree = { .first = first, .count = count, .depth = depth };
+		node->first = (uint32_t)builder->subtrees.size;
+		node->count = DE_BVH_SUBTREE_NODE;
+		DE_ARRAY_APPEND(builder->subtrees, subtree);
+		return index;
+	}
+
+	de_vec3_t center_min, center_max;
+	de_bvh_bounds_reset(&node->min, &node->max);
+	de_bvh_bounds_reset(&center_min, &center_max);
+	for (size_t i = 0; i < count; ++i) {
+		const de_bvh_triangle_t* triangle = &builder->triangles[order[i]];
+		de_bvh_bounds_merge(&node->min, &node->max, &triangle->min, &triangle->max);
+		de_vec3_min_max(&triangle->center, &center_min, &center_max);
+	}
+
+	/* find split with lowest cost using binned surface area heuristic */
+	int best_axis = -1;
+	int best_split = 0;
+	float best_cost = FLT_MAX;
+	float best_bin_scale = 0.0f;
+	if (count > builder->max_triangles_per_leaf && depth < DE_BVH_MAX_DEPTH - 1) {
+		for (int axis = 0; axis < 3; ++axis) {
+			const float bin_min = de_bvh_get_axis(&center_min, axis);
+			const float extent = de_bvh_get_axis(&center_max, axis) - bin_min;
+			if (extent <= FLT_EPSILON) {
+				continue;
+			}
+			const float bin_scale = DE_BVH_BIN_COUNT * (1.0f - 1e-5f) / extent;
+
+			de_bvh_bin_t bins[DE_BVH_BIN_COUNT];
+			for (int k = 0; k < DE_BVH_BIN_COUNT; ++k) {
+				de_bvh_bounds_reset(&bins[k].min, &bins[k].max);
+				bins[k].count = 0;
+			}
+			for (size_t i = 0; i < count; ++i) {
+				const de_bvh_triangle_t* triangle = &builder->triangles[order[i]];
+				de_bvh_bin_t* bin = &bins[de_bvh_get_bin(de_bvh_get_axis(&triangle->center, axis), bin_min, bin_scale)];
+				de_bvh_bounds_merge(&bin->min, &bin->max, &triangle->min, &triangle->max);
+				++bin->count;
+			}
+
+			/* sweep from right to get areas of right parts, then from left to evaluate cost */
+			float right_area[DE_BVH_BIN_COUNT];
+			size_t right_count[DE_BVH_BIN_COUNT];
+			de_vec3_t min, max;
+			de_bvh_bounds_reset(&min, &max);
+			size_t sum = 0;
+			for (int k = DE_BVH_BIN_COUNT - 1; k > 0; --k) {
+				de_bvh_bounds_merge(&min, &max, &bins[k].min, &bins[k].max);
+				sum += bins[k].count;
+				right_area[k] = de_bvh_bounds_half_area(&min, &max);
+				right_count[k] = sum;
+			}
+			de_bvh_bounds_reset(&min, &max);
+			sum = 0;
+			for (int k = 1; k < DE_BVH_BIN_COUNT; ++k) {
+				de_bvh_bounds_merge(&min, &max, &bins[k - 1].min, &bins[k - 1].max);
+				sum += bins[k - 1].count;
+				if (sum == 0 || right_count[k] == 0) {
+					continue;
+				}
+				const float cost = de_bvh_bounds_half_area(&min, &max) * sum + right_area[k] * right_count[k];
+				if (cost < best_cost) {
+					best_cost = cost;
+					best_axis = axis;
+					best_split = k;
+					best_bin_scale = bin_scale;
+				}
+			}
+		}
+	}
+
+	if (best_axis < 0) {
+		/* too few triangles, too deep or all centers are in one point - make leaf */
+		node->first = (uint32_t)first;
+		node->count = (uint32_t)count;
+		++builder->leaf_count;
+		return index;
+	}
+
+	/* partition triangles in place, left part goes first */
+	const float bin_min = de_bvh_get_axis(&center_min, best_axis);
+	size_t left = 0;
+	size_t right = count;
+	while (left < right) {
+		const de_bvh_triangle_t* triangle = &builder->triangles[order[left]];
+		if (de_bvh_get_bin(de_bvh_get_axis(&triangle->center, best_axis), bin_min, best_bin_scale) < best_split) {
+			++left;
+		} else {
+			const uint32_t temp = order[left];
+			order[left] = order[--right];
+			order[right] = temp;
+		}
+	}
+
+	/* first child is always next node */
+	node->count = 0;
+	de_bvh_build_recursive(builder, first, left, depth + 1);
+	node->first = de_bvh_build_recursive(builder, first + left, count - left, depth + 1);
+
+	return index;
+}
+
+static void de_bvh_prepare_range(void* user_data, size_t begin, size_t end, size_t thread_index)
+{
+	de_bvh_prepare_t* prepare = user_data;
+	DE_UNUSED(thread_index);
+	for (size_t i = begin; i < end; ++i) {
+		de_bvh_triangle_t* triangle = prepare->triangles + i;
+
+		const de_vec3_t* v0 = (de_vec3_t*)((char*)prepare->src_triangles + i * prepare->pos_stride);
+		const de_vec3_t* v1 = v0 + 1;
+		const de_vec3_t* v2 = v1 + 1;
+
+		de_bvh_bounds_reset(&triangle->min, &triangle->max);
+		de_vec3_min_max(v0, &triangle->min, &triangle->max);
+		de_vec3_min_max(v1, &triangle->min, &triangle->max);
+		de_vec3_min_max(v2, &triangle->min, &triangle->max);
+		de_vec3_middle(&triangle->center, &triangle->min, &triangle->max);
+
+		prepare->order[i] = (uint32_t)i;
+	}
+}
+
+static void de_bvh_build_subtree_range(void* user_data, size_t begin, size_t end, size_t thread_index)
+{
+	const de_bvh_builder_t* top = user_data;
+	DE_UNUSED(thread_index);
+	for (size_t i = begin; i < end; ++i) {
+		de_bvh_subtree_t* subtree = top->subtrees.data + i;
+		de_bvh_builder_t builder = {
+			.triangles = top->triangles,
+			.order = top->order,
+			.max_triangles_per_leaf = top->max_triangles_per_leaf,
+			.nodes = de_malloc((2 * subtree->count - 1) * sizeof(*builder.nodes))
+		};
+		de_bvh_build_recursive(&builder, subtree->first, subtree->count, subtree->depth);
+		subtree->nodes = builder.nodes;
+		subtree->node_count = builder.node_count;
+		subtree->leaf_count = builder.leaf_count;
+	}
+}
+
+/**
+ * @brief Copies top level node with its children into bvh in depth-first order, deferred nodes
+ * are replaced with their subtrees. Returns index of node in bvh.
+ */
+static uint32_t de_bvh_assemble(de_bvh_t* bvh, const de_bvh_builder_t* top, uint32_t index)
+{
+	const de_bvh_node_t* node = &top->nodes[index];
+	const uint32_t out_index = (uint32_t)bvh->node_count;
+	if (node->count == DE_BVH_SUBTREE_NODE) {
+		const de_bvh_subtree_t* subtree = &top->subtrees.data[node->first];
+		for (size_t i = 0; i < subtree->node_count; ++i) {
+			de_bvh_node_t* out = &bvh->nodes[out_index + i];
+			*out = subtree->nodes[i];
+			if (!out->count) {
+				out->first += out_index;
+			}
+		}
+		bvh->node_count += subtree->node_count;
+		bvh->leaf_count += subtree->leaf_count;
+	} else if (node->count) {
+		bvh->nodes[bvh->node_count++] = *node;
+		++bvh->leaf_count;
+	} else {
+		bvh->nodes[bvh->node_count++] = *node;
+		de_bvh_assemble(bvh, top, index + 1);
+		const uint32_t second = de_bvh_assemble(bvh, top, node->first);
+		bvh->nodes[out_index].first = second;
+	}
+	return out_index;
+}
+
+void de_bvh_build(de_bvh_t* bvh, de_thread_pool_t* pool, const void* src_triangles, size_t triangle_count, int pos_stride, size_t max_triangles_per_leaf, uint32_t* out_order)
+{
+	DE_ASSERT(bvh);
+	DE_ASSERT(max_triangles_per_leaf > 0);
+
+	de_zero(bvh, sizeof(*bvh));
+
+	if (triangle_count == 0) {
+		return;
+	}
+
+	de_bvh_prepare_t prepare = {
+		.triangles = de_malloc(triangle_count * sizeof(*prepare.triangles)),
+		.src_triangles = src_triangles,
+		.pos_stride = pos_stride,
+		.order = out_order
+	};
+	de_thread_pool_parallel_for(pool, triangle_count, 0, de_bvh_prepare_range, &prepare);
+
+	/* top levels are built on calling thread until nodes are small enough to give a few
+	 * subtrees per thread, then subtrees are built in parallel and stitched together */
+	const size_t thread_count = pool ? de_thread_pool_get_thread_count(pool) : 1;
+	size_t subtree_size = 0;
+	if (thread_count > 1) {
+		subtree_size = triangle_count / (4 * thread_count);
+		if (subtree_size < DE_BVH_MIN_SUBTREE_SIZE) {
+			subtree_size = DE_BVH_MIN_SUBTREE_SIZE;
+		}
+	}
+
+	/* binary tree with N leaves has 2N - 1 nodes, each leaf has at least one triangle */
+	de_bvh_builder_t builder = {
+		.triangles = prepare.triangles,
+		.order = out_order,
+		.max_triangles_per_leaf = max_triangles_per_leaf,
+		.nodes = de_malloc((2 * triangle_count - 1) * sizeof(*builder.nodes)),
+		.subtree_size = subtree_size
+	};
+	DE_ARRAY_INIT(builder.subtrees);
+	de_bvh_build_recursive(&builder, 0, triangle_count, 0);
+
+	if (builder.subtrees.size) {
+		de_thread_pool_parallel_for(pool, builder.subtrees.size, 1, de_bvh_build_subtree_range, &builder);
+
+		size_t node_count = builder.node_count - builder.subtrees.size;
+		for (size_t i = 0; i < builder.subtrees.size; ++i) {
+			node_count += builder.subtrees.data[i].node_count;
+		}
+		bvh->nodes = de_malloc(node_count * sizeof(*bvh->nodes));
+		de_bvh_assemble(bvh, &builder, 0);
+		DE_ASSERT(bvh->node_count == node_count);
+
+		for (size_t i = 0; i < builder.subtrees.size; ++i) {
+			de_free(builder.subtrees.data[i].nodes);
+		}
+		de_free(builder.nodes);
+	} else {
+		bvh->nodes = de_realloc(builder.nodes, builder.node_count * sizeof(*bvh->nodes));
+		bvh->node_count = builder.node_count;
+		bvh->leaf_count = builder.leaf_count;
+	}
+	bvh->trace_buffer.nodes = de_malloc(bvh->leaf_count * sizeof(*bvh->trace_buffer.nodes));
+	bvh->trace_buffer.capacity = bvh->leaf_count;
+
+	DE_ARRAY_FREE(builder.subtrees);
+	de_free(prepare.triangles);
+}
+
+void de_bvh_free(de_bvh_t* bvh)
+{
+	de_free(bvh->nodes);
+	de_free(bvh->trace_buffer.nodes);
+	de_zero(bvh, sizeof(*bvh));
+}
+
+static bool de_bvh_node_is_intersect_sphere(const de_bvh_node_t* node, const de_vec3_t* position, float radius)
+{
+	float sqr_distance = 0.0f;
+
+	if (position->x < node->min.x) {
+		sqr_distance += de_sqr(position->x - node->min.x);
+	} else if (position->x > node->max.x) {
+		sqr_distance += de_sqr(position->x - node->max.x);
+	}
+
+	if (position->y < node->min.y) {
+		sqr_distance += de_sqr(position->y - node->min.y);
+	} else if (position->y > node->max.y) {
+		sqr_distance += de_sqr(position->y - node->max.y);
+	}
+
+	if (position->z < node->min.z) {
+		sqr_distance += de_sqr(position->z - node->min.z);
+	} else if (position->z > node->max.z) {
+		sqr_distance += de_sqr(position->z - node->max.z);
+	}
+
+	return sqr_distance <= radius * radius;
+}
+
+void de_bvh_visit_sphere(const de_bvh_t* bvh, const de_vec3_t* position, float radius, de_bvh_leaf_visitor_t visitor, void* user_data)
+{
+	if (bvh->node_count == 0) {
+		return;
+	}
+
+	uint32_t stack[DE_BVH_MAX_DEPTH];
+	size_t stack_size = 0;
+	uint32_t index = 0;
+	for (;;) {
+		const de_bvh_node_t* node = &bvh->nodes[index];
+		if (de_bvh_node_is_intersect_sphere(node, position, radius)) {
+			if (node->count) {
+				if (!visitor(user_data, node)) {
+					break;
+				}
+			} else {
+				stack[stack_size++] = node->first;
+				++index;
+				continue;
+			}
+		}
+		if (stack_size == 0) {
+			break;
+		}
+		index = stack[--stack_size];
+	}
+}
+
+static bool de_bvh_node_is_intersect_aabb(const de_bvh_node_t* node, const de_vec3_t* min, const de_vec3_t* max)
+{
+	return node->min.x <= max->x && node->max.x >= min->x &&
+		node->min.y <= max->y && node->max.y >= min->y &&
+		node->min.z <= max->z && node->max.z >= min->z;
+}
+
+void de_bvh_visit_aabb(const de_bvh_t* bvh, const de_vec3_t* min, const de_vec3_t* max, de_bvh_leaf_visitor_t visitor, void* user_data)
+{
+	if (bvh->node_count == 0) {
+		return;
+	}
+
+	uint32_t stack[DE_BVH_MAX_DEPTH];
+	size_t stack_size = 0;
+	uint32_t index = 0;
+	for (;;) {
+		const de_bvh_node_t* node = &bvh->nodes[index];
+		if (de_bvh_node_is_intersect_aabb(node, min, max)) {
+			if (node->count) {
+				if (!visitor(user_data, node)) {
+					break;
+				}
+			} else {
+				stack[stack_size++] = node->first;
+				++index;
+				continue;
+			}
+		}
+		if (stack_size == 0) {
+			break;
+		}
+		index = stack[--stack_size];
+	}
+}
+
+/**
+ * @brief Slab test for ray with precomputed inverse direction. Same as de_ray_aabb_intersection,
+ * ray is treated as segment from origin to origin + dir. Writes ray parameter of entry point into
+ * node (zero if origin is inside) to out_entry. Comparisons are used instead of fminf/fmaxf: they
+ * are compiled into single minss/maxss instructions while fminf/fmaxf have to handle NaN and end
+ * up as library calls, which also stops this function from being inlined into traversal loops.
+ * Results differ only when 0 * inf gives NaN (axis-parallel ray starting exactly on a slab plane).
+ */
+static bool de_bvh_node_is_intersect_ray(const de_bvh_node_t* node, const de_vec3_t* origin, const de_vec3_t* inv_dir, float* out_entry)
+{
+	const float tx1 = (node->min.x - origin->x) * inv_dir->x;
+	const float tx2 = (node->max.x - origin->x) * inv_dir->x;
+	float tmin = tx1 < tx2 ? tx1 : tx2;
+	float tmax = tx1 > tx2 ? tx1 : tx2;
+
+	const float ty1 = (node->min.y - origin->y) * inv_dir->y;
+	const float ty2 = (node->max.y - origin->y) * inv_dir->y;
+	const float ty_min = ty1 < ty2 ? ty1 : ty2;
+	const float ty_max = ty1 > ty2 ? ty1 : ty2;
+	tmin = tmin > ty_min ? tmin : ty_min;
+	tmax = tmax < ty_max ? tmax : ty_max;
+
+	const float tz1 = (node->min.z - origin->z) * inv_dir->z;
+	const float tz2 = (node->max.z - origin->z) * inv_dir->z;
+	const float tz_min = tz1 < tz2 ? tz1 : tz2;
+	const float tz_max = tz1 > tz2 ? tz1 : tz2;
+	tmin = tmin > tz_min ? tmin : tz_min;
+	tmax = tmax < tz_max ? tmax : tz_max;
+
+	*out_entry = tmin > 0.0f ? tmin : 0.0f;
+	return tmax >= 0.0f && tmin <= 1.0f && tmin <= tmax;
+}
+
+void de_bvh_visit_ray(const de_bvh_t* bvh, const de_ray_t* ray, de_bvh_leaf_visitor_t visitor, void* user_data)
+{
+	if (bvh->node_count == 0) {
+		return;
+	}
+
+	/* division by zero gives infinity here, which slab test handles correctly */
+	const de_vec3_t inv_dir = { 1.0f / ray->dir.x, 1.0f / ray->dir.y, 1.0f / ray->dir.z };
+
+	uint32_t stack[DE_BVH_MAX_DEPTH];
+	size_t stack_size = 0;
+	uint32_t index = 0;
+	for (;;) {
+		const de_bvh_node_t* node = &bvh->nodes[index];
+		float entry;
+		if (de_bvh_node_is_intersect_ray(node, &ray->origin, &inv_dir, &entry)) {
+			if (node->count) {
+				if (!visitor(user_data, node)) {
+					break;
+				}
+			} else {
+				stack[stack_size++] = node->first;
+				++index;
+				continue;
+			}
+		}
+		if (stack_size == 0) {
+			break;
+		}
+		index = stack[--stack_size];
+	}
+}
+
+void de_bvh_visit_ray_front_to_back(const de_bvh_t* bvh, const de_ray_t* ray, const float* max_t, de_bvh_leaf_visitor_t visitor, void* user_data)
+{
+	if (bvh->node_count == 0) {
+		return;
+	}
+
+	const de_vec3_t inv_dir = { 1.0f / ray->dir.x, 1.0f / ray->dir.y, 1.0f / ray->dir.z };
+
+	/* far children are deferred together with their entry distance, so they can be skipped
+	 * when closer hit was found while processing near children */
+	uint32_t stack[DE_BVH_MAX_DEPTH];
+	float stack_entry[DE_BVH_MAX_DEPTH];
+	size_t stack_size = 0;
+
+	float entry;
+	if (!de_bvh_node_is_intersect_ray(&bvh->nodes[0], &ray->origin, &inv_dir, &entry)) {
+		return;
+	}
+	uint32_t index = 0;
+	for (;;) {
+		const de_bvh_node_t* node = &bvh->nodes[index];
+		if (node->count) {
+			if (!visitor(user_data, node)) {
+				break;
+			}
+		} else {
+			uint32_t near = index + 1;
+			uint32_t far = node->first;
+			float near_entry, far_entry;
+			bool near_hit = de_bvh_node_is_intersect_ray(&bvh->nodes[near], &ray->origin, &inv_dir, &near_entry) && near_entry <= *max_t;
+			bool far_hit = de_bvh_node_is_intersect_ray(&bvh->nodes[far], &ray->origin, &inv_dir, &far_entry) && far_entry <= *max_t;
+			if (near_hit && far_hit) {
+				if (far_entry < near_entry) {
+					const uint32_t temp_index = near;
+					near = far;
+					far = temp_index;
+					const float temp_entry = near_entry;
+					near_entry = far_entry;
+					far_entry = temp_entry;
+				}
+				stack[stack_size] = far;
+				stack_entry[stack_size] = far_entry;
+				++stack_size;
+				index = near;
+				continue;
+			} else if (near_hit) {
+				index = near;
+				continue;
+			} else if (far_hit) {
+				index = far;
+				continue;
+			}
+		}
+
+		/* take next deferred node which is still closer than best hit */
+		bool found = false;
+		while (stack_size > 0) {
+			--stack_size;
+			if (stack_entry[stack_size] <= *max_t) {
+				index = stack[stack_size];
+				found = true;
+				break;
+			}
+		}
+		if (!found) {
+			break;
+		}
+	}
+}
+
+/**
+ * @brief Rays of packet in form of structure of arrays.
+ */
+typedef struct de_bvh_ray_packet_t {
+	float origin_x[DE_BVH_RAY_PACKET_SIZE];
+	float origin_y[DE_BVH_RAY_PACKET_SIZE];
+	float origin_z[DE_BVH_RAY_PACKET_SIZE];
+	float inv_dir_x[DE_BVH_RAY_PACKET_SIZE];
+	float inv_dir_y[DE_BVH_RAY_PACKET_SIZE];
+	float inv_dir_z[DE_BVH_RAY_PACKET_SIZE];
+} de_bvh_ray_packet_t;
+
+/**
+ * @brief Same slab test as de_bvh_node_is_intersect_ray for every lane of packet. All lanes are
+ * processed without branches, so compilers turn comparisons into vector min/max instructions.
+ * Returns mask of lanes which intersect node.
+ */
+static uint32_t de_bvh_node_intersect_ray_packet(const de_bvh_node_t* node, const de_bvh_ray_packet_t* packet)
+{
+	int hit[DE_BVH_RAY_PACKET_SIZE];
+	for (int i = 0; i < DE_BVH_RAY_PACKET_SIZE; ++i) {
+		const float tx1 = (node->min.x - packet->origin_x[i]) * packet->inv_dir_x[i];
+		const float tx2 = (node->max.x - packet->origin_x[i]) * packet->inv_dir_x[i];
+		float tmin = tx1 < tx2 ? tx1 : tx2;
+		float tmax = tx1 > tx2 ? tx1 : tx2;
+
+		const float ty1 = (node->min.y - packet->origin_y[i]) * packet->inv_dir_y[i];
+		const float ty2 = (node->max.y - packet->origin_y[i]) * packet->inv_dir_y[i];
+		const float ty_min = ty1 < ty2 ? ty1 : ty2;
+		const float ty_max = ty1 > ty2 ? ty1 : ty2;
+		tmin = tmin > ty_min ? tmin : ty_min;
+		tmax = tmax < ty_max ? tmax : ty_max;
+
+		const float tz1 = (node->min.z - packet->origin_z[i]) * packet->inv_dir_z[i];
+		const float tz2 = (node->max.z - packet->origin_z[i]) * packet->inv_dir_z[i];
+		const float tz_min = tz1 < tz2 ? tz1 : tz2;
+		const float tz_max = tz1 > tz2 ? tz1 : tz2;
+		tmin = tmin > tz_min ? tmin : tz_min;
+		tmax = tmax < tz_max ? tmax : tz_max;
+
+		hit[i] = (tmax >= 0.0f) & (tmin <= 1.0f) & (tmin <= tmax);
+	}
+	uint32_t mask = 0;
+	for (int i = 0; i < DE_BVH_RAY_PACKET_SIZE; ++i) {
+		mask |= (uint32_t)hit[i] << i;
+	}
+	return mask;
+}
+
+void de_bvh_visit_ray_packet(const de_bvh_t* bvh, const de_ray_t* rays, size_t ray_count, de_bvh_packet_leaf_visitor_t visitor, void* user_data)
+{
+	DE_ASSERT(ray_count <= DE_BVH_RAY_PACKET_SIZE);
+
+	if (bvh->node_count == 0 || ray_count == 0) {
+		return;
+	}
+
+	/* unused lanes repeat first ray and are masked out */
+	de_bvh_ray_packet_t packet;
+	for (size_t i = 0; i < DE_BVH_RAY_PACKET_SIZE; ++i) {
+		const de_ray_t* ray = &rays[i < ray_count ? i : 0];
+		packet.origin_x[i] = ray->origin.x;
+		packet.origin_y[i] = ray->origin.y;
+		packet.origin_z[i] = ray->origin.z;
+		packet.inv_dir_x[i] = 1.0f / ray->dir.x;
+		packet.inv_dir_y[i] = 1.0f / ray->dir.y;
+		packet.inv_dir_z[i] = 1.0f / ray->dir.z;
+	}
+
+	/* rays which missed node can not hit its children, so mask of active rays goes with node */
+	uint32_t stack[DE_BVH_MAX_DEPTH];
+	uint32_t stack_mask[DE_BVH_MAX_DEPTH];
+	size_t stack_size = 0;
+	uint32_t index = 0;
+	uint32_t active_mask = (1u << ray_count) - 1;
+	for (;;) {
+		const de_bvh_node_t* node = &bvh->nodes[index];
+		const uint32_t mask = de_bvh_node_intersect_ray_packet(node, &packet) & active_mask;
+		if (mask) {
+			if (node->count) {
+				if (!visitor(user_data, node, mask)) {
+					break;
+				}
+			} else {
+				stack[stack_size] = node->first;
+				stack_mask[stack_size] = mask;
+				++stack_size;
+				++index;
+				active_mask = mask;
+				continue;
+			}
+		}
+		if (stack_size == 0) {
+			break;
+		}
+		--stack_size;
+		index = stack[stack_size];
+		active_mask = stack_mask[stack_size];
+	}
+}
+
+typedef struct de_bvh_trace_t {
+	const de_bvh_t* bvh;
+	de_bvh_trace_buffer_t* buffer;
+} de_bvh_trace_t;
+
+static bool de_bvh_trace_visitor(void* user_data, const de_bvh_node_t* leaf)
+{
+	de_bvh_trace_t* trace = user_data;
+	trace->buffer->nodes[trace->buffer->size++] = (uint32_t)(leaf - trace->bvh->nodes);
+	return true;
+}
+
+/**
+ * @brief Clears buffer and makes sure that it can hold every leaf of bvh.
+ */
+static void de_bvh_trace_buffer_prepare(const de_bvh_t* bvh, de_bvh_trace_buffer_t* buffer)
+{
+	if (buffer->capacity < bvh->leaf_count) {
+		buffer->nodes = de_realloc(buffer->nodes, bvh->leaf_count * sizeof(*buffer->nodes));
+		buffer->capacity = bvh->leaf_count;
+	}
+	buffer->size = 0;
+}
+
+void de_bvh_trace_sphere_ex(const de_bvh_t* bvh, de_bvh_trace_buffer_t* buffer, const de_vec3_t* position, float radius)
+{
+	de_bvh_trace_buffer_prepare(bvh, buffer);
+	de_bvh_trace_t trace = { .bvh = bvh, .buffer = buffer };
+	de_bvh_visit_sphere(bvh, position, radius, de_bvh_trace_visitor, &trace);
+}
+
+void de_bvh_trace_ray_ex(const de_bvh_t* bvh, de_bvh_trace_buffer_t* buffer, const de_ray_t* ray)
+{
+	de_bvh_trace_buffer_prepare(bvh, buffer);
+	de_bvh_trace_t trace = { .bvh = bvh, .buffer = buffer };
+	de_bvh_visit_ray(bvh, ray, de_bvh_trace_visitor, &trace);
+}
+
+void de_bvh_trace_sphere(de_bvh_t* bvh, const de_vec3_t* position, float radius)
+{
+	de_bvh_trace_sphere_ex(bvh, &bvh->trace_buffer, position, radius);
+}
+
+void de_bvh_trace_ray(de_bvh_t* bvh, const de_ray_t* ray)
+{
+	de_bvh_trace_ray_ex(bvh, &bvh->trace_buffer, ray);
+}
+
+void de_bvh_trace_buffer_init(de_bvh_trace_buffer_t* buffer)
+{
+	de_zero(buffer, sizeof(*buffer));
+}
+
+void de_bvh_trace_buffer_free(de_bvh_trace_buffer_t* buffer)
+{
+	de_free(buffer->nodes);
+	de_zero(buffer, sizeof(*buffer));
+}
+
+static void de_bvh_tests_make_soup(de_vec3_t* positions, size_t triangle_count, float size)
+{
+	for (size_t i = 0; i < triangle_count; ++i) {
+		const de_vec3_t center = {
+			size * (rand() / (float)RAND_MAX),
+			size * (rand() / (float)RAND_MAX),
+			size * (rand() / (float)RAND_MAX)
+		};
+		for (int k = 0; k < 3; ++k) {
+			positions[i * 3 + k] = (de_vec3_t) {
+				center.x + rand() / (float)RAND_MAX - 0.5f,
+				center.y + rand() / (float)RAND_MAX - 0.5f,
+				center.z + rand() / (float)RAND_MAX - 0.5f
+			};
+		}
+	}
+}
+
+static bool de_bvh_tests_is_triangle_traced(const de_bvh_t* bvh, const de_bvh_trace_buffer_t* buffer, const uint32_t* order, uint32_t triangle)
+{
+	for (size_t i = 0; i < buffer->size; ++i) {
+		const de_bvh_node_t* leaf = &bvh->nodes[buffer->nodes[i]];
+		for (uint32_t k = leaf->first; k < leaf->first + leaf->count; ++k) {
+			if (order[k] == triangle) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+typedef struct de_bvh_tests_parallel_t {
+	const de_bvh_t* bvh;
+	de_bvh_trace_buffer_t* buffers;
+	const de_ray_t* rays;
+	const size_t* expected;
+	volatile long mismatches;
+} de_bvh_tests_parallel_t;
+
+static void de_bvh_tests_parallel_range(void* user_data, size_t begin, size_t end, size_t thread_index)
+{
+	de_bvh_tests_parallel_t* parallel = user_data;
+	de_bvh_trace_buffer_t* buffer = parallel->buffers + thread_index;
+	for (size_t i = begin; i < end; ++i) {
+		de_bvh_trace_ray_ex(parallel->bvh, buffer, &parallel->rays[i]);
+		if (buffer->size != parallel->expected[i]) {
+			de_atomic_add(&parallel->mismatches, 1);
+		}
+	}
+}
+
+typedef struct de_bvh_tests_closest_t {
+	const de_ray_t* ray;
+	const de_vec3_t* positions; /**< Triangles in order of leaves. */
+	float t; /**< Ray parameter of closest hit so far. */
+	size_t test_count;
+} de_bvh_tests_closest_t;
+
+static float de_bvh_tests_ray_param(const de_ray_t* ray, const de_vec3_t* point)
+{
+	de_vec3_t d;
+	de_vec3_sub(&d, point, &ray->origin);
+	return de_vec3_dot(&d, &ray->dir) / de_vec3_sqr_len(&ray->dir);
+}
+
+static bool de_bvh_tests_closest_visitor(void* user_data, const de_bvh_node_t* leaf)
+{
+	de_bvh_tests_closest_t* closest = user_data;
+	for (uint32_t k = leaf->first; k < leaf->first + leaf->count; ++k) {
+		const de_vec3_t* p = &closest->positions[k * 3];
+		de_vec3_t point;
+		++closest->test_count;
+		if (de_ray_triangle_intersection(closest->ray, &p[0], &p[1], &p[2], &point)) {
+			const float t = de_bvh_tests_ray_param(closest->ray, &point);
+			if (t < closest->t) {
+				closest->t = t;
+			}
+		}
+	}
+	return true;
+}
+
+typedef struct de_bvh_tests_packet_t {
+	size_t leaf_count[DE_BVH_RAY_PACKET_SIZE]; /**< Amount of leaves visited by each ray of packet. */
+} de_bvh_tests_packet_t;
+
+static bool de_bvh_tests_packet_visitor(void* user_data, const de_bvh_node_t* leaf, uint32_t ray_mask)
+{
+	de_bvh_tests_packet_t* packet = user_data;
+	DE_UNUSED(leaf);
+	for (int i = 0; i < DE_BVH_RAY_PACKET_SIZE; ++i) {
+		if (ray_mask & (1u << i)) {
+			++packet->leaf_count[i];
+		}
+	}
+	return true;
+}
+
+static bool de_bvh_tests_first_leaf_visitor(void* user_data, const de_bvh_node_t* leaf)
+{
+	DE_UNUSED(leaf);
+	++*(size_t*)user_data;
+	return false;
+}
+
+void de_bvh_tests()
+{
+	/* fixed amount of workers, so parallel build is tested on any hardware */
+	de_thread_pool_t* pool = de_thread_pool_create(3);
+
+	/* validate structure and compare queries with brute force, single-threaded and parallel builds */
+	for (int pass = 0; pass < 2; ++pass) {
+		const size_t triangle_count = 20000;
+		const float size = 100.0f;
+		de_vec3_t* positions = de_malloc(triangle_count * 3 * sizeof(*positions));
+		uint32_t* order = de_malloc(triangle_count * sizeof(*order));
+		de_bvh_tests_make_soup(positions, triangle_count, size);
+
+		de_bvh_t bvh;
+		de_bvh_build(&bvh, pass ? pool : NULL, positions, triangle_count, 3 * sizeof(de_vec3_t), 8, order);
+		DE_ASSERT(bvh.node_count == 2 * bvh.leaf_count - 1);
+
+		/* every triangle belongs to exactly one leaf and lies inside of it */
+		bool* used = de_calloc(triangle_count, sizeof(*used));
+		size_t referenced = 0;
+		for (size_t i = 0; i < bvh.node_count; ++i) {
+			const de_bvh_node_t* node = &bvh.nodes[i];
+			if (node->count) {
+				DE_ASSERT(node->count <= 8);
+				for (uint32_t k = node->first; k < node->first + node->count; ++k) {
+					DE_ASSERT(!used[order[k]]);
+					used[order[k]] = true;
+					++referenced;
+					for (int v = 0; v < 3; ++v) {
+						const de_vec3_t* p = &positions[order[k] * 3 + v];
+						DE_ASSERT(p->x >= node->min.x && p->y >= node->min.y && p->z >= node->min.z);
+						DE_ASSERT(p->x <= node->max.x && p->y <= node->max.y && p->z <= node->max.z);
+					}
+				}
+			} else {
+				DE_ASSERT(node->first > i + 1 && node->first < bvh.node_count);
+			}
+		}
+		DE_ASSERT(referenced == triangle_count);
+		de_free(used);
+
+		de_vec3_t* sorted = de_malloc(triangle_count * 3 * sizeof(*sorted));
+		for (size_t i = 0; i < triangle_count; ++i) {
+			memcpy(&sorted[i * 3], &positions[order[i] * 3], 3 * sizeof(*sorted));
+		}
+
+		for (int n = 0; n < 200; ++n) {
+			de_ray_t ray;
+			ray.origin = (de_vec3_t) { size * 0.5f, size * 0.5f, size * 0.5f };
+			ray.dir = (de_vec3_t) { rand() / (float)RAND_MAX - 0.5f, rand() / (float)RAND_MAX - 0.5f, rand() / (float)RAND_MAX - 0.5f };
+			de_vec3_scale(&ray.dir, &ray.dir, size);
+			de_bvh_trace_ray(&bvh, &ray);
+			float closest_t = 1.0f;
+			for (uint32_t i = 0; i < triangle_count; ++i) {
+				const de_vec3_t* p = &positions[i * 3];
+				de_vec3_t point;
+				if (de_ray_triangle_intersection(&ray, &p[0], &p[1], &p[2], &point) &&
+					de_vec3_sqr_distance(&point, &ray.origin) <= de_vec3_sqr_len(&ray.dir)) {
+					DE_ASSERT(de_bvh_tests_is_triangle_traced(&bvh, &bvh.trace_buffer, order, i));
+					closest_t = de_minf(closest_t, de_bvh_tests_ray_param(&ray, &point));
+				}
+			}
+
+			/* packet of rays with same origin visits every leaf each ray visits alone */
+			de_ray_t packet[DE_BVH_RAY_PACKET_SIZE];
+			for (int k = 0; k < DE_BVH_RAY_PACKET_SIZE; ++k) {
+				packet[k].origin = ray.origin;
+				packet[k].dir = (de_vec3_t) { ray.dir.x + k, ray.dir.y - k, ray.dir.z };
+			}
+			de_bvh_tests_packet_t packet_trace = { { 0 } };
+			de_bvh_visit_ray_packet(&bvh, packet, DE_BVH_RAY_PACKET_SIZE, de_bvh_tests_packet_visitor, &packet_trace);
+			for (int k = 0; k < DE_BVH_RAY_PACKET_SIZE; ++k) {
+				de_bvh_trace_ray(&bvh, &packet[k]);
+				DE_ASSERT(bvh.trace_buffer.size == packet_trace.leaf_count[k]);
+			}
+
+			/* front-to-back traversal must find same closest hit */
+			de_bvh_tests_closest_t closest = { .ray = &ray, .positions = sorted, .t = 1.0f };
+			de_bvh_visit_ray_front_to_back(&bvh, &ray, &closest.t, de_bvh_tests_closest_visitor, &closest);
+			DE_ASSERT(closest.t == closest_t);
+
+			const de_vec3_t position = { size * (rand() / (float)RAND_MAX), size * (rand() / (float)RAND_MAX), size * (rand() / (float)RAND_MAX) };
+			const float radius = 3.0f;
+			de_bvh_trace_sphere(&bvh, &position, radius);
+			for (uint32_t i = 0; i < triangle_count; ++i) {
+				const de_vec3_t* p = &positions[i * 3];
+				for (int v = 0; v < 3; ++v) {
+					if (de_vec3_sqr_distance(&p[v], &position) <= radius * radius) {
+						DE_ASSERT(de_bvh_tests_is_triangle_traced(&bvh, &bvh.trace_buffer, order, i));
+					}
+				}
+			}
+
+			const de_vec3_t box_min = { position.x - radius, position.y - 2.0f * radius, position.z - radius };
+			const de_vec3_t box_max = { position.x + radius, position.y + radius, position.z + 2.0f * radius };
+			de_bvh_trace_t trace = { .bvh = &bvh, .buffer = &bvh.trace_buffer };
+			bvh.trace_buffer.size = 0;
+			de_bvh_visit_aabb(&bvh, &box_min, &box_max, de_bvh_trace_visitor, &trace);
+			for (uint32_t i = 0; i < triangle_count; ++i) {
+				const de_vec3_t* p = &positions[i * 3];
+				for (int v = 0; v < 3; ++v) {
+					if (p[v].x >= box_min.x && p[v].y >= box_min.y && p[v].z >= box_min.z &&
+						p[v].x <= box_max.x && p[v].y <= box_max.y && p[v].z <= box_max.z) {
+						DE_ASSERT(de_bvh_tests_is_triangle_traced(&bvh, &bvh.trace_buffer, order, i));
+					}
+				}
+			}
+		}
+
+		/* queries with caller-owned buffers from several threads give same results */
+		const size_t query_count = 1000;
+		const size_t thread_count = de_thread_pool_get_thread_count(pool);
+		de_ray_t* rays = de_malloc(query_count * sizeof(*rays));
+		size_t* expected = de_malloc(query_count * sizeof(*expected));
+		for (size_t i = 0; i < query_count; ++i) {
+			rays[i].origin = (de_vec3_t) { size * (rand() / (float)RAND_MAX), size * (rand() / (float)RAND_MAX), size * (rand() / (float)RAND_MAX) };
+			rays[i].dir = (de_vec3_t) { size * (rand() / (float)RAND_MAX - 0.5f), size * (rand() / (float)RAND_MAX - 0.5f), size * (rand() / (float)RAND_MAX - 0.5f) };
+			de_bvh_trace_ray(&bvh, &rays[i]);
+			expected[i] = bvh.trace_buffer.size;
+
+			/* visitor can stop traversal after first leaf */
+			size_t visited = 0;
+			de_bvh_visit_ray(&bvh, &rays[i], de_bvh_tests_first_leaf_visitor, &visited);
+			DE_ASSERT(visited == (expected[i] ? 1 : 0));
+		}
+		de_bvh_trace_buffer_t* buffers = de_malloc(thread_count * sizeof(*buffers));
+		for (size_t i = 0; i < thread_count; ++i) {
+			de_bvh_trace_buffer_init(&buffers[i]);
+		}
+		de_bvh_tests_parallel_t parallel = {
+			.bvh = &bvh,
+			.buffers = buffers,
+			.rays = rays,
+			.expected = expected
+		};
+		de_thread_pool_parallel_for(pool, query_count, 16, de_bvh_tests_parallel_range, &parallel);
+		DE_ASSERT(parallel.mismatches == 0);
+		for (size_t i = 0; i < thread_count; ++i) {
+			de_bvh_trace_buffer_free(&buffers[i]);
+		}
+		de_free(buffers);
+		de_free(expected);
+		de_free(rays);
+
+		de_bvh_free(&bvh);
+		de_free(sorted);
+		de_free(order);
+		de_free(positions);
+	}
+
+	/* benchmark on large triangle soup, octree is built on the same data for comparison */
+	{
+		const size_t triangle_count = 1000000;
+		const float size = 1000.0f;
+		const int query_count = 10000;
+		de_vec3_t* positions = de_malloc(triangle_count * 3 * sizeof(*positions));
+		uint32_t* order = de_malloc(triangle_count * sizeof(*order));
+		de_bvh_tests_make_soup(positions, triangle_count, size);
+
+		de_ray_t* rays = de_malloc(query_count * sizeof(*rays));
+		for (int i = 0; i < query_count; ++i) {
+			rays[i].origin = (de_vec3_t) { size * (rand() / (float)RAND_MAX), size * (rand() / (float)RAND_MAX), size * (rand() / (float)RAND_MAX) };
+			rays[i].dir = (de_vec3_t) { rand() / (float)RAND_MAX - 0.5f, rand() / (float)RAND_MAX - 0.5f, rand() / (float)RAND_MAX - 0.5f };
+			de_vec3_scale(&rays[i].dir, &rays[i].dir, 100.0f);
+		}
+
+		double start_time = de_time_get_seconds();
+		de_bvh_t bvh;
+		de_bvh_build(&bvh, NULL, positions, triangle_count, 3 * sizeof(de_vec3_t), 8, order);
+		const double bvh_serial_build_time = de_time_get_seconds() - start_time;
+		de_bvh_free(&bvh);
+
+		start_time = de_time_get_seconds();
+		de_bvh_build(&bvh, pool, positions, triangle_count, 3 * sizeof(de_vec3_t), 8, order);
+		const double bvh_build_time = de_time_get_seconds() - start_time;
+
+		/* triangles are reordered by leaves after build, as static geometry does */
+		de_vec3_t* sorted = de_malloc(triangle_count * 3 * sizeof(*sorted));
+		for (size_t i = 0; i < triangle_count; ++i) {
+			memcpy(&sorted[i * 3], &positions[order[i] * 3], 3 * sizeof(*sorted));
+		}
+
+		start_time = de_time_get_seconds();
+		size_t bvh_tests = 0;
+		size_t bvh_hits = 0;
+		for (int i = 0; i < query_count; ++i) {
+			de_bvh_trace_ray(&bvh, &rays[i]);
+			for (size_t n = 0; n < bvh.trace_buffer.size; ++n) {
+				const de_bvh_node_t* leaf = &bvh.nodes[bvh.trace_buffer.nodes[n]];
+				for (uint32_t k = leaf->first; k < leaf->first + leaf->count; ++k) {
+					const de_vec3_t* p = &sorted[k * 3];
+					bvh_hits += de_ray_triangle_intersection(&rays[i], &p[0], &p[1], &p[2], NULL);
+					++bvh_tests;
+				}
+			}
+		}
+		const double bvh_ray_time = de_time_get_seconds() - start_time;
+
+		/* long rays through sparse soup mostly miss everything, so front-to-back ordering cannot cull
+		 * anything here and must only not be slower than plain traversal */
+		start_time = de_time_get_seconds();
+		size_t all_hits_tests = 0;
+		for (int i = 0; i < query_count; ++i) {
+			de_ray_t ray = rays[i];
+			de_vec3_scale(&ray.dir, &ray.dir, 50.0f);
+			de_bvh_tests_closest_t closest = { .ray = &ray, .positions = sorted, .t = 1.0f };
+			de_bvh_visit_ray(&bvh, &ray, de_bvh_tests_closest_visitor, &closest);
+			all_hits_tests += closest.test_count;
+		}
+		const double all_hits_ray_time = de_time_get_seconds() - start_time;
+
+		start_time = de_time_get_seconds();
+		size_t closest_tests = 0;
+		size_t closest_hits = 0;
+		for (int i = 0; i < query_count; ++i) {
+			de_ray_t ray = rays[i];
+			de_vec3_scale(&ray.dir, &ray.dir, 50.0f);
+			de_bvh_tests_closest_t closest = { .ray = &ray, .positions = sorted, .t = 1.0f };
+			de_bvh_visit_ray_front_to_back(&bvh, &ray, &closest.t, de_bvh_tests_closest_visitor, &closest);
+			closest_tests += closest.test_count;
+			closest_hits += closest.t < 1.0f;
+		}
+		const double closest_ray_time = de_time_get_seconds() - start_time;
+
+		start_time = de_time_get_seconds();
+		size_t bvh_candidates = 0;
+		for (int i = 0; i < query_count; ++i) {
+			de_bvh_trace_sphere(&bvh, &rays[i].origin, 3.0f);
+			for (size_t n = 0; n < bvh.trace_buffer.size; ++n) {
+				bvh_candidates += bvh.nodes[bvh.trace_buffer.nodes[n]].count;
+			}
+		}
+		const double bvh_sphere_time = de_time_get_seconds() - start_time;
+
+		de_log("bvh benchmark: %d triangles, %d nodes, built in %f s (%f s on %d threads); %d rays in %f s (%d triangle tests, %d hits), %d spheres in %f s (%d candidates)",
+			(int)triangle_count, (int)bvh.node_count, bvh_serial_build_time, bvh_build_time, (int)de_thread_pool_get_thread_count(pool),
+			query_count, bvh_ray_time, (int)bvh_tests, (int)bvh_hits,
+			query_count, bvh_sphere_time, (int)bvh_candidates);
+		de_log("bvh benchmark: %d long rays in soup, all hits in %f s (%d triangle tests), closest hit in %f s (%d triangle tests, %d hits)",
+			query_count, all_hits_ray_time, (int)all_hits_tests, closest_ray_time, (int)closest_tests, (int)closest_hits);
+
+		start_time = de_time_get_seconds();
+		de_octree_t* octree = de_octree_build(positions, triangle_count, 3 * sizeof(de_vec3_t), 64);
+		const double octree_build_time = de_time_get_seconds() - start_time;
+
+		start_time = de_time_get_seconds();
+		size_t octree_tests = 0;
+		size_t octree_hits = 0;
+		for (int i = 0; i < query_count; ++i) {
+			de_octree_trace_ray(octree, &rays[i]);
+			for (int n = 0; n < octree->trace_buffer.size; ++n) {
+				const de_octree_node_t* leaf = octree->trace_buffer.nodes[n];
+				for (int k = 0; k < leaf->index_count; ++k) {
+					const de_vec3_t* p = &positions[leaf->triangle_indices[k] * 3];
+					octree_hits += de_ray_triangle_intersection(&rays[i], &p[0], &p[1], &p[2], NULL);
+					++octree_tests;
+				}
+			}
+		}
+		const double octree_ray_time = de_time_get_seconds() - start_time;
+
+		start_time = de_time_get_seconds();
+		size_t octree_candidates = 0;
+		for (int i = 0; i < query_count; ++i) {
+			de_octree_trace_sphere(octree, &rays[i].origin, 3.0f);
+			for (int n = 0; n < octree->trace_buffer.size; ++n) {
+				octree_candidates += octree->trace_buffer.nodes[n]->index_count;
+			}
+		}
+		const double octree_sphere_time = de_time_get_seconds() - start_time;
+
+		de_log("octree benchmark: %d triangles, built in %f s; %d rays in %f s (%d triangle tests, %d hits), %d spheres in %f s (%d candidates)",
+			(int)triangle_count, octree_build_time, query_count, octree_ray_time, (int)octree_tests, (int)octree_hits,
+			query_count, octree_sphere_time, (int)octree_candidates);
+
+		de_octree_free(octree);
+		de_bvh_free(&bvh);
+		de_free(sorted);
+		de_free(rays);
+		de_free(order);
+		de_free(positions);
+	}
+
+	/* closest hit benchmark on dense occluding scene: stacked layers of triangles crossed from
+	 * above, so every ray hits every layer and only the first one matters */
+	{
+		const int layer_count = 16;
+		const int grid_size = 128;
+		const float cell_size = 0.5f;
+		const float extent = grid_size * cell_size;
+		const size_t triangle_count = (size_t)layer_count * grid_size * grid_size * 2;
+		const int query_count = 100000;
+		de_vec3_t* positions = de_malloc(triangle_count * 3 * sizeof(*positions));
+		uint32_t* order = de_malloc(triangle_count * sizeof(*order));
+		de_vec3_t* p = positions;
+		for (int layer = 0; layer < layer_count; ++layer) {
+			const float y = (float)layer;
+			for (int z = 0; z < grid_size; ++z) {
+				for (int x = 0; x < grid_size; ++x) {
+					const float x0 = x * cell_size, x1 = x0 + cell_size;
+					const float z0 = z * cell_size, z1 = z0 + cell_size;
+					*p++ = (de_vec3_t) { x0, y, z0 };
+					*p++ = (de_vec3_t) { x1, y, z0 };
+					*p++ = (de_vec3_t) { x1, y, z1 };
+					*p++ = (de_vec3_t) { x0, y, z0 };
+					*p++ = (de_vec3_t) { x1, y, z1 };
+					*p++ = (de_vec3_t) { x0, y, z1 };
+				}
+			}
+		}
+
+		de_bvh_t bvh;
+		de_bvh_build(&bvh, pool, positions, triangle_count, 3 * sizeof(de_vec3_t), 8, order);
+		de_vec3_t* sorted = de_malloc(triangle_count * 3 * sizeof(*sorted));
+		for (size_t i = 0; i < triangle_count; ++i) {
+			memcpy(&sorted[i * 3], &positions[order[i] * 3], 3 * sizeof(*sorted));
+		}
+
+		/* slightly slanted rays going down from above of the top layer through the bottom one */
+		de_ray_t* rays = de_malloc(query_count * sizeof(*rays));
+		for (int i = 0; i < query_count; ++i) {
+			const float x = 1.0f + (extent - 2.0f) * (rand() / (float)RAND_MAX);
+			const float z = 1.0f + (extent - 2.0f) * (rand() / (float)RAND_MAX);
+			rays[i].origin = (de_vec3_t) { x, layer_count + 1.0f, z };
+			rays[i].dir = (de_vec3_t) { rand() / (float)RAND_MAX - 0.5f, -(layer_count + 2.0f), rand() / (float)RAND_MAX - 0.5f };
+		}
+
+		double start_time = de_time_get_seconds();
+		size_t all_hits_tests = 0;
+		for (int i = 0; i < query_count; ++i) {
+			de_bvh_tests_closest_t closest = { .ray = &rays[i], .positions = sorted, .t = 1.0f };
+			de_bvh_visit_ray(&bvh, &rays[i], de_bvh_tests_closest_visitor, &closest);
+			all_hits_tests += closest.test_count;
+		}
+		const double all_hits_ray_time = de_time_get_seconds() - start_time;
+
+		start_time = de_time_get_seconds();
+		size_t closest_tests = 0;
+		size_t closest_hits = 0;
+		for (int i = 0; i < query_count; ++i) {
+			de_bvh_tests_closest_t closest = { .ray = &rays[i], .positions = sorted, .t = 1.0f };
+			de_bvh_visit_ray_front_to_back(&bvh, &rays[i], &closest.t, de_bvh_tests_closest_visitor, &closest);
+			closest_tests += closest.test_count;
+			/* top layer must always be the closest one */
+			const float hit_y = rays[i].origin.y + rays[i].dir.y * closest.t;
+			DE_ASSERT(fabsf(hit_y - (layer_count - 1)) < 0.01f);
+			closest_hits += closest.t < 1.0f;
+		}
+		const double closest_ray_time = de_time_get_seconds() - start_time;
+		DE_ASSERT(closest_hits == (size_t)query_count);
+		DE_ASSERT(closest_tests < all_hits_tests);
+
+		de_log("bvh benchmark: %d rays through %d layers (%d triangles), all hits in %f s (%d triangle tests), closest hit in %f s (%d triangle tests, %d hits)",
+			query_count, layer_count, (int)triangle_count, all_hits_ray_time, (int)all_hits_tests,
+			closest_ray_time, (int)closest_tests, (int)closest_hits);
+
+		de_bvh_free(&bvh);
+		de_free(rays);
+		de_free(sorted);
+		de_free(order);
+		de_free(positions);
+	}
+
+	de_thread_pool_free(pool);
+}
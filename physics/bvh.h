@@ -0,0 +1,169 @@
+/* Copyright (c) 2017-2019 Dmitry Stepanov a.k.a mr.DIMAS
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+* OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+/**
+ * Bounding volume hierarchy of triangles.
+ *
+ * Tree is built using binned surface area heuristic (SAH) and stored in one contiguous array of
+ * nodes in depth-first order: first child of inner node is always next node in array, so only
+ * index of second child is stored. Each triangle belongs to exactly one leaf, leaf references range
+ * of triangles, so triangles must be reordered by the owner of triangles in order returned by
+ * @ref de_bvh_build (see de_static_geometry_fill).
+ */
+
+#define DE_BVH_MAX_DEPTH (64)
+
+/** Maximum amount of rays in packet, see @ref de_bvh_visit_ray_packet */
+#define DE_BVH_RAY_PACKET_SIZE (4)
+
+/**
+ * @brief Node of BVH. 32 bytes, two nodes fit in one cache line.
+ */
+typedef struct de_bvh_node_t {
+	de_vec3_t min;
+	uint32_t first; /**< Leaf: index of first triangle. Inner node: index of second child. */
+	de_vec3_t max;
+	uint32_t count; /**< Amount of triangles in leaf, zero for inner nodes. */
+} de_bvh_node_t;
+
+/**
+ * @brief Result of query, can be owned by caller to run queries on same BVH from several threads.
+ */
+typedef struct de_bvh_trace_buffer_t {
+	uint32_t* nodes; /**< Indices of leaf nodes. */
+	size_t size;
+	size_t capacity;
+} de_bvh_trace_buffer_t;
+
+typedef struct de_bvh_t {
+	de_bvh_trace_buffer_t trace_buffer;
+	de_bvh_node_t* nodes;
+	size_t node_count;
+	size_t leaf_count;
+} de_bvh_t;
+
+/**
+ * @brief Builds BVH for a set of triangles. Each triangle is three consecutive positions.
+ * @param pool Thread pool to build independent subtrees in parallel. Can be NULL.
+ * @param src_triangles Pointer to first position of first triangle.
+ * @param triangle_count Count of triangles.
+ * @param pos_stride Offset between triangles in bytes.
+ * @param max_triangles_per_leaf Nodes with more triangles than this value will be split.
+ * @param out_order Array of triangle_count indices. Receives order of triangles in leaves: leaf node
+ * references triangles out_order[first] .. out_order[first + count - 1].
+ */
+void de_bvh_build(de_bvh_t* bvh, de_thread_pool_t* pool, const void* src_triangles, size_t triangle_count, int pos_stride, size_t max_triangles_per_leaf, uint32_t* out_order);
+
+/**
+ * @brief Frees BVH resources. BVH can be built again after this call.
+ */
+void de_bvh_free(de_bvh_t* bvh);
+
+/**
+ * @brief Callback of BVH traversal, called for every leaf which intersects with query volume.
+ * Return false to stop traversal.
+ */
+typedef bool(*de_bvh_leaf_visitor_t)(void* user_data, const de_bvh_node_t* leaf);
+
+/**
+ * @brief Callback of packet traversal. ray_mask has bit i set if i-th ray of packet intersects
+ * with leaf. Return false to stop traversal.
+ */
+typedef bool(*de_bvh_packet_leaf_visitor_t)(void* user_data, const de_bvh_node_t* leaf, uint32_t ray_mask);
+
+/**
+ * @brief Fills trace buffer of BVH with leaves which intersects with sphere. Not thread-safe, see
+ * @ref de_bvh_trace_sphere_ex.
+ */
+void de_bvh_trace_sphere(de_bvh_t* bvh, const de_vec3_t* position, float radius);
+
+/**
+ * @brief Fills trace buffer with leaves which intersects with ray. Ray is treated as segment from
+ * origin to origin + dir, same as in de_ray_aabb_intersection. Not thread-safe, see
+ * @ref de_bvh_trace_ray_ex.
+ */
+void de_bvh_trace_ray(de_bvh_t* bvh, const de_ray_t* ray);
+
+/**
+ * @brief Same as @ref de_bvh_trace_sphere, but writes result into specified buffer instead of
+ * buffer of BVH. Thread-safe as long as BVH is not modified and each thread uses its own buffer.
+ */
+void de_bvh_trace_sphere_ex(const de_bvh_t* bvh, de_bvh_trace_buffer_t* buffer, const de_vec3_t* position, float radius);
+
+/**
+ * @brief Same as @ref de_bvh_trace_ray, but writes result into specified buffer. Thread-safe in
+ * the same way as @ref de_bvh_trace_sphere_ex.
+ */
+void de_bvh_trace_ray_ex(const de_bvh_t* bvh, de_bvh_trace_buffer_t* buffer, const de_ray_t* ray);
+
+/**
+ * @brief Calls visitor for every leaf which intersects with sphere until visitor returns false.
+ * Uses no shared state, so it is thread-safe as long as BVH is not modified.
+ */
+void de_bvh_visit_sphere(const de_bvh_t* bvh, const de_vec3_t* position, float radius, de_bvh_leaf_visitor_t visitor, void* user_data);
+
+/**
+ * @brief Calls visitor for every leaf which intersects with axis-aligned box until visitor returns
+ * false. Thread-safe in the same way as @ref de_bvh_visit_sphere.
+ */
+void de_bvh_visit_aabb(const de_bvh_t* bvh, const de_vec3_t* min, const de_vec3_t* max, de_bvh_leaf_visitor_t visitor, void* user_data);
+
+/**
+ * @brief Calls visitor for every leaf which intersects with ray until visitor returns false.
+ * Thread-safe in the same way as @ref de_bvh_visit_sphere.
+ */
+void de_bvh_visit_ray(const de_bvh_t* bvh, const de_ray_t* ray, de_bvh_leaf_visitor_t visitor, void* user_data);
+
+/**
+ * @brief Calls visitor for leaves which intersect with ray in front-to-back order: nearer child of
+ * each node is visited first. Nodes which ray enters farther than *max_t (ray parameter in [0; 1])
+ * are skipped, visitor is supposed to lower value pointed by max_t as closer hits are found, so
+ * closest hit query stops as soon as remaining nodes are behind best hit. Every triangle belongs to
+ * exactly one leaf, so no triangle is visited twice. Thread-safe in the same way as
+ * @ref de_bvh_visit_sphere.
+ */
+void de_bvh_visit_ray_front_to_back(const de_bvh_t* bvh, const de_ray_t* ray, const float* max_t, de_bvh_leaf_visitor_t visitor, void* user_data);
+
+/**
+ * @brief Traverses BVH with packet of up to DE_BVH_RAY_PACKET_SIZE rays at once. Node is entered
+ * if any ray of packet intersects it, so each node is fetched once per packet instead of once per
+ * ray. Calls visitor for every leaf which intersects with at least one ray. Rays are processed as
+ * structure of arrays in lanes, so compiler can use vector instructions for slab tests. Efficient
+ * only for coherent rays (close origins and directions). Thread-safe in the same way as
+ * @ref de_bvh_visit_sphere.
+ */
+void de_bvh_visit_ray_packet(const de_bvh_t* bvh, const de_ray_t* rays, size_t ray_count, de_bvh_packet_leaf_visitor_t visitor, void* user_data);
+
+/**
+ * @brief Prepares trace buffer. It grows on demand, so one buffer can be used with any BVH.
+ */
+void de_bvh_trace_buffer_init(de_bvh_trace_buffer_t* buffer);
+
+/**
+ * @brief Frees trace buffer resources.
+ */
+void de_bvh_trace_buffer_free(de_bvh_trace_buffer_t* buffer);
+
+/**
+ * @brief Tests. Also measures build and query time on a large triangle soup and prints results
+ * into log.
+ */
+void de_bvh_tests();
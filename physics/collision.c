@@ -38,103 +38,653 @@ bool de_static_geometry_add_triangle(de_static_geometry_t* geom, const de_vec3_t
 	return true;
 }
 
+typedef struct de_static_geometry_fill_t {
+	const de_mesh_t* mesh;
+	const de_mat4_t* transform;
+	size_t* surface_offsets; /**< Index of first triangle of each surface, plus total count at the end. */
+	uint32_t* material_hashes; /**< Material hash of each surface. */
+	de_static_triangle_t* triangles;
+	bool* degenerated;
+	const de_static_triangle_t* src_triangles; /**< Triangles to gather in bvh order. */
+	const uint32_t* order;
+} de_static_geometry_fill_t;
+
+static void de_static_geometry_transform_range(void* user_data, size_t begin, size_t end, size_t thread_index)
+{
+	de_static_geometry_fill_t* fill = user_data;
+	DE_UNUSED(thread_index);
+
+	/* find surface of first triangle, next ones are found by advancing */
+	size_t surface = 0;
+	while (fill->surface_offsets[surface + 1] <= begin) {
+		++surface;
+	}
+
+	for (size_t i = begin; i < end; ++i) {
+		while (fill->surface_offsets[surface + 1] <= i) {
+			++surface;
+		}
+		const de_surface_shared_data_t* data = fill->mesh->surfaces.data[surface]->shared_data;
+		const int* indices = data->indices + (i - fill->surface_offsets[surface]) * 3;
+
+		de_static_triangle_t* triangle = &fill->triangles[i];
+		de_vec3_transform(&triangle->a, &data->positions[indices[0]], fill->transform);
+		de_vec3_transform(&triangle->b, &data->positions[indices[1]], fill->transform);
+		de_vec3_transform(&triangle->c, &data->positions[indices[2]], fill->transform);
+		triangle->material_hash = fill->material_hashes[surface];
+		fill->degenerated[i] = !de_try_get_triangle_normal(&triangle->normal, &triangle->a, &triangle->b, &triangle->c);
+	}
+}
+
+static void de_static_geometry_gather_range(void* user_data, size_t begin, size_t end, size_t thread_index)
+{
+	de_static_geometry_fill_t* fill = user_data;
+	DE_UNUSED(thread_index);
+	for (size_t i = begin; i < end; ++i) {
+		fill->triangles[i] = fill->src_triangles[fill->order[i]];
+	}
+}
+
+/* rebuilds bvh and reorders triangles so each leaf references continuous range of triangles */
+static void de_static_geometry_build_bvh(de_static_geometry_t* geom, de_thread_pool_t* pool)
+{
+	de_bvh_free(&geom->bvh);
+	uint32_t* order = de_malloc(geom->triangles.size * sizeof(*order));
+	de_bvh_build(&geom->bvh, pool, (char*)geom->triangles.data + offsetof(de_static_triangle_t, a), geom->triangles.size, sizeof(de_static_triangle_t), 8, order);
+	de_static_triangle_t* sorted = de_malloc(geom->triangles.size * sizeof(*sorted));
+	de_static_geometry_fill_t fill = {
+		.triangles = sorted,
+		.src_triangles = geom->triangles.data,
+		.order = order
+	};
+	de_thread_pool_parallel_for(pool, geom->triangles.size, 0, de_static_geometry_gather_range, &fill);
+	memcpy(geom->triangles.data, sorted, geom->triangles.size * sizeof(*sorted));
+	de_free(sorted);
+	de_free(order);
+}
+
 void de_static_geometry_fill(de_static_geometry_t* geom, const de_mesh_t* mesh, const de_mat4_t* transform)
 {
 	DE_ASSERT(geom);
 	DE_ASSERT(mesh);
 	DE_ASSERT(transform);
 
+	const double start_time = de_time_get_seconds();
+	de_thread_pool_t* pool = (geom->scene && geom->scene->core) ? de_core_get_thread_pool(geom->scene->core) : NULL;
+
+	de_static_geometry_fill_t fill = {
+		.mesh = mesh,
+		.transform = transform,
+		.surface_offsets = de_malloc((mesh->surfaces.size + 1) * sizeof(*fill.surface_offsets)),
+		.material_hashes = de_malloc((mesh->surfaces.size + 1) * sizeof(*fill.material_hashes))
+	};
+	size_t count = 0;
 	for (size_t i = 0; i < mesh->surfaces.size; ++i) {
 		const de_surface_t* surf = mesh->surfaces.data[i];
-		const de_surface_shared_data_t* data = surf->shared_data;
-		uint32_t material_hash;
 		if (surf->diffuse_map) {
 			de_resource_t* resource = de_resource_from_texture(surf->diffuse_map);
-			material_hash = de_path_hash(&resource->source);
+			fill.material_hashes[i] = de_path_hash(&resource->source);
 		} else {
-			material_hash = 0;
+			fill.material_hashes[i] = 0;
 		}
-		for (size_t k = 0; k < data->index_count; k += 3) {
-			const int a = data->indices[k];
-			const int b = data->indices[k + 1];
-			const int c = data->indices[k + 2];
+		fill.surface_offsets[i] = count;
+		count += surf->shared_data->index_count / 3;
+	}
+	fill.surface_offsets[mesh->surfaces.size] = count;
+
+	/* transform triangles into pre-sized tail of array, then drop degenerated ones */
+	const size_t base = geom->triangles.size;
+	DE_ARRAY_GROW(geom->triangles, count);
+	fill.triangles = geom->triangles.data + base;
+	fill.degenerated = de_malloc(count * sizeof(*fill.degenerated));
+	de_thread_pool_parallel_for(pool, count, 0, de_static_geometry_transform_range, &fill);
 
-			de_vec3_t pa = data->positions[a];
-			de_vec3_transform(&pa, &pa, transform);
+	size_t last = base;
+	for (size_t i = 0; i < count; ++i) {
+		if (!fill.degenerated[i]) {
+			geom->triangles.data[last++] = fill.triangles[i];
+		}
+	}
+	if (last != base + count) {
+		de_log("static geometry: %d degenerated triangles found!", (int)(base + count - last));
+	}
+	geom->triangles.size = last;
+
+	de_static_geometry_build_bvh(geom, pool);
+	de_static_geometry_wake_up_bodies(geom);
+
+	de_free(fill.degenerated);
+	de_free(fill.material_hashes);
+	de_free(fill.surface_offsets);
+
+	de_log("static geometry: %d triangles, %d bvh nodes built in %f seconds",
+		(int)geom->triangles.size, (int)geom->bvh.node_count, de_time_get_seconds() - start_time);
+}
 
-			de_vec3_t pb = data->positions[b];
-			de_vec3_transform(&pb, &pb, transform);
+typedef struct de_body_static_collision_t {
+	de_body_t* body;
+	de_static_geometry_t* geometry;
+	de_vec3_t min; /**< Bounds of body swept from last position to current. */
+	de_vec3_t max;
+	uint32_t step_index;
+	size_t test_count;
+	size_t support_count;
+} de_body_static_collision_t;
 
-			de_vec3_t pc = data->positions[c];
-			de_vec3_transform(&pc, &pc, transform);
+static bool de_triangle_is_outside_aabb(const de_vec3_t* a, const de_vec3_t* b, const de_vec3_t* c, const de_vec3_t* aabb_min, const de_vec3_t* aabb_max)
+{
+	de_vec3_t min = *a, max = *a;
+	de_vec3_min_max(b, &min, &max);
+	de_vec3_min_max(c, &min, &max);
+	return min.x > aabb_max->x || max.x < aabb_min->x ||
+		min.y > aabb_max->y || max.y < aabb_min->y ||
+		min.z > aabb_max->z || max.z < aabb_min->z;
+}
 
-			de_static_geometry_add_triangle(geom, &pa, &pb, &pc, material_hash);
+/**
+ * @brief Pushes body out of triangle given in world space. key identifies triangle in contact cache of
+ * body. Sets pushed flag if body was pushed and returns added contact (NULL if body has too many
+ * contacts), caller fills what contact touches.
+ */
+static de_contact_t* de_body_triangle_collision(de_body_t* body, const de_vec3_t* a, const de_vec3_t* b, const de_vec3_t* c,
+	const void* key, uint32_t step_index, size_t* support_count, bool* pushed)
+{
+	de_convex_shape_t triangle_shape = {
+		.type = DE_CONVEX_SHAPE_TYPE_TRIANGLE,
+		.s.triangle = {
+			.vertices = { *a, *b, *c }
+		}
+	};
+	de_simplex_t simplex = { 0 };
+	de_vec3_t* search_dir = de_body_get_cached_search_dir(body, key, step_index);
+	int gjk_support_count;
+	const bool intersects = de_gjk_is_intersects_ex(&body->shape, &body->position, &triangle_shape, &(de_vec3_t) { 0, 0, 0}, search_dir, &simplex, &gjk_support_count);
+	*support_count += (size_t)gjk_support_count;
+	*pushed = false;
+	if (intersects) {
+		de_vec3_t penetration_vector;
+		de_vec3_t contact_point;
+		if (de_epa_get_penetration_info(&simplex, &body->shape, &body->position, &triangle_shape, &(de_vec3_t) { 0, 0, 0}, &penetration_vector, &contact_point)) {
+			de_vec3_sub(&body->position, &body->position, &penetration_vector);
+			/* Write contact info only if we have contact that really pushes the body */
+			if (de_vec3_sqr_len(&penetration_vector)) {
+				*pushed = true;
+				de_contact_t* contact = de_body_add_contact(body);
+				if (contact) {
+					de_vec3_negate(&contact->normal, &penetration_vector);
+					de_vec3_normalize(&contact->normal, &contact->normal);
+					contact->position = contact_point;
+				}
+				return contact;
+			}
 		}
 	}
+	return NULL;
+}
 
-	geom->octree = de_octree_build((char*)geom->triangles.data + offsetof(de_static_triangle_t, a), geom->triangles.size, sizeof(de_static_triangle_t), 64);
+static bool de_body_static_leaf_collision(void* user_data, const de_bvh_node_t* leaf)
+{
+	de_body_static_collision_t* collision = user_data;
+	de_body_t* body = collision->body;
+	for (uint32_t k = leaf->first; k < leaf->first + leaf->count; ++k) {
+		de_static_triangle_t* triangle = &collision->geometry->triangles.data[k];
+
+		/* leaf may be much larger than body, skip triangles whose bounds do not touch it */
+		if (de_triangle_is_outside_aabb(&triangle->a, &triangle->b, &triangle->c, &collision->min, &collision->max)) {
+			continue;
+		}
+
+		++collision->test_count;
+		bool pushed;
+		de_contact_t* contact = de_body_triangle_collision(body, &triangle->a, &triangle->b, &triangle->c, triangle, collision->step_index, &collision->support_count, &pushed);
+		if (contact) {
+			contact->body = NULL;
+			contact->triangle = triangle;
+			contact->geometry = collision->geometry;
+		}
+	}
+	return true;
 }
 
-void de_physics_step(de_core_t* core, double dt)
+typedef struct de_body_mesh_collision_t {
+	de_body_t* body;
+	const de_body_t* mesh_body;
+	const de_triangle_mesh_shape_t* mesh;
+	de_vec3_t min; /**< Bounds of body in space of mesh. */
+	de_vec3_t max;
+	uint32_t step_index;
+	size_t support_count;
+	bool collided;
+} de_body_mesh_collision_t;
+
+static bool de_body_mesh_leaf_collision(void* user_data, const de_bvh_node_t* leaf)
 {
-	const float dt2 = (float)(dt * dt);
-	for (de_scene_t* scene = core->scenes.head; scene; scene = scene->next) {
-		for(de_body_t* body = scene->bodies.head; body; body = body->next) {
-			/* Drop contact information */
-			body->contact_count = 0;
-			/* Apply gravity */
-			de_vec3_add(&body->acceleration, &body->acceleration, &body->gravity);
-			/* Do Verlet integration */
-			de_body_verlet(body, dt2);
-			/* Solve body-mesh collisions */
-			for (de_static_geometry_t* geom = scene->static_geometries.head; geom; geom = geom->next) {
+	de_body_mesh_collision_t* collision = user_data;
+	const de_vec3_t* mesh_position = &collision->mesh_body->position;
+	for (uint32_t k = leaf->first; k < leaf->first + leaf->count; ++k) {
+		const de_vec3_t* local = &collision->mesh->vertices.data[k * 3];
+		if (de_triangle_is_outside_aabb(&local[0], &local[1], &local[2], &collision->min, &collision->max)) {
+			continue;
+		}
 
-				/* TODO: */
-				const float radius = 3.0f; 
-
-				de_octree_trace_sphere(geom->octree, &body->position, radius);
-				for (int i = 0; i < geom->octree->trace_buffer.size; ++i) {
-					de_octree_node_t* node = geom->octree->trace_buffer.nodes[i];
-					for (int k = 0; k < node->index_count; ++k) {
-						de_static_triangle_t* triangle = &geom->triangles.data[node->triangle_indices[k]];
-						de_convex_shape_t triangle_shape = {
-							.type = DE_CONVEX_SHAPE_TYPE_TRIANGLE,
-							.s.triangle = {
-							    .vertices = { triangle->a, triangle->b, triangle->c }
-						    }
-						};
-						de_simplex_t simplex = { 0 };
-						if (de_gjk_is_intersects(&body->shape, &body->position, &triangle_shape, &(de_vec3_t) { 0, 0, 0}, &simplex)) {
-							de_vec3_t penetration_vector;
-							de_vec3_t contact_point;
-							if (de_epa_get_penetration_info(&simplex, &body->shape, &body->position, &triangle_shape, &(de_vec3_t) { 0, 0, 0}, &penetration_vector, &contact_point)) {
-								de_vec3_sub(&body->position, &body->position, &penetration_vector);
-								/* Write contact info only if we have contact that really pushes the body */
-								if (de_vec3_sqr_len(&penetration_vector)) {								    
-									de_contact_t* contact = de_body_add_contact(body);
-									if (contact) {
-										contact->body = NULL;
-										de_vec3_negate(&contact->normal, &penetration_vector);
-										de_vec3_normalize(&contact->normal, &contact->normal);
-										contact->position = contact_point;
-										contact->triangle = triangle;
-										contact->geometry = geom;
-									}
-								}
-							}
-						}
-					}
+		de_vec3_t a, b, c;
+		de_vec3_add(&a, &local[0], mesh_position);
+		de_vec3_add(&b, &local[1], mesh_position);
+		de_vec3_add(&c, &local[2], mesh_position);
+		bool pushed;
+		de_contact_t* contact = de_body_triangle_collision(collision->body, &a, &b, &c, local, collision->step_index, &collision->support_count, &pushed);
+		collision->collided |= pushed;
+		if (contact) {
+			contact->body = (de_body_t*)collision->mesh_body;
+			contact->triangle = NULL;
+			contact->geometry = NULL;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Collides convex body with triangle mesh body. Mesh is kinematic, so only convex body is pushed.
+ * Bounds of body are moved into space of mesh and only overlapping triangles are fetched from mesh BVH.
+ */
+static bool de_body_mesh_collision(de_body_t* body, const de_body_t* mesh_body, uint32_t step_index, int* support_count)
+{
+	de_body_mesh_collision_t collision = {
+		.body = body,
+		.mesh_body = mesh_body,
+		.mesh = &mesh_body->shape.s.triangle_mesh,
+		.step_index = step_index
+	};
+	de_convex_shape_get_aabb(&body->shape, &body->position, &collision.min, &collision.max);
+	de_vec3_sub(&collision.min, &collision.min, &mesh_body->position);
+	de_vec3_sub(&collision.max, &collision.max, &mesh_body->position);
+	de_bvh_visit_aabb(&collision.mesh->bvh, &collision.min, &collision.max, de_body_mesh_leaf_collision, &collision);
+	*support_count = (int)collision.support_count;
+	return collision.collided;
+}
+
+/**
+ * @brief Closest point of triangle to given point, see "Real-Time Collision Detection" by C. Ericson, 5.1.5.
+ */
+static de_vec3_t de_triangle_closest_point(const de_vec3_t* p, const de_vec3_t* a, const de_vec3_t* b, const de_vec3_t* c)
+{
+	de_vec3_t ab, ac, ap, bp, cp, result;
+	de_vec3_sub(&ab, b, a);
+	de_vec3_sub(&ac, c, a);
+	de_vec3_sub(&ap, p, a);
+
+	/* vertex region of a */
+	const float d1 = de_vec3_dot(&ab, &ap);
+	const float d2 = de_vec3_dot(&ac, &ap);
+	if (d1 <= 0.0f && d2 <= 0.0f) {
+		return *a;
+	}
+
+	/* vertex region of b */
+	de_vec3_sub(&bp, p, b);
+	const float d3 = de_vec3_dot(&ab, &bp);
+	const float d4 = de_vec3_dot(&ac, &bp);
+	if (d3 >= 0.0f && d4 <= d3) {
+		return *b;
+	}
+
+	/* edge region of ab */
+	const float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+		de_vec3_scale(&result, &ab, d1 / (d1 - d3));
+		return *de_vec3_add(&result, &result, a);
+	}
+
+	/* vertex region of c */
+	de_vec3_sub(&cp, p, c);
+	const float d5 = de_vec3_dot(&ab, &cp);
+	const float d6 = de_vec3_dot(&ac, &cp);
+	if (d6 >= 0.0f && d5 <= d6) {
+		return *c;
+	}
+
+	/* edge region of ac */
+	const float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+		de_vec3_scale(&result, &ac, d2 / (d2 - d6));
+		return *de_vec3_add(&result, &result, a);
+	}
+
+	/* edge region of bc */
+	const float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+		de_vec3_t bc;
+		de_vec3_sub(&bc, c, b);
+		de_vec3_scale(&result, &bc, (d4 - d3) / ((d4 - d3) + (d5 - d6)));
+		return *de_vec3_add(&result, &result, b);
+	}
+
+	/* inside face */
+	const float denom = 1.0f / (va + vb + vc);
+	de_vec3_t offset;
+	de_vec3_scale(&result, &ab, vb * denom);
+	de_vec3_scale(&offset, &ac, vc * denom);
+	de_vec3_add(&result, &result, &offset);
+	return *de_vec3_add(&result, &result, a);
+}
+
+typedef struct de_body_sweep_t {
+	de_vec3_t origin; /**< Center of sphere at time 0. */
+	de_vec3_t motion; /**< Displacement of sphere over step. */
+	float length; /**< Length of motion. */
+	float radius;
+	float toi; /**< Earliest time of impact found so far, in [0; 1]. */
+	const de_static_geometry_t* geometry;
+} de_body_sweep_t;
+
+static bool de_body_sweep_leaf(void* user_data, const de_bvh_node_t* leaf)
+{
+	/* Sphere moves on straight line, so distance to triangle is a safe step along motion: conservative
+	 * advancement never jumps over triangle and converges in few iterations unless motion grazes it. */
+	const int max_iterations = 32;
+	const float tolerance = 0.001f;
+	de_body_sweep_t* sweep = user_data;
+	for (uint32_t k = leaf->first; k < leaf->first + leaf->count; ++k) {
+		const de_static_triangle_t* triangle = &sweep->geometry->triangles.data[k];
+		float t = 0.0f;
+		for (int i = 0; i < max_iterations && t < sweep->toi; ++i) {
+			de_vec3_t center, to_triangle;
+			de_vec3_scale(&center, &sweep->motion, t);
+			de_vec3_add(&center, &center, &sweep->origin);
+			const de_vec3_t closest = de_triangle_closest_point(&center, &triangle->a, &triangle->b, &triangle->c);
+			de_vec3_sub(&to_triangle, &closest, &center);
+			const float distance = de_vec3_len(&to_triangle) - sweep->radius;
+			if (distance < tolerance) {
+				/* touching triangle while moving away from it or along it is not an impact */
+				if (de_vec3_dot(&to_triangle, &sweep->motion) > 0.0f) {
+					sweep->toi = t;
 				}
+				break;
 			}
+			t += distance / sweep->length;
+		}
+	}
+	return true;
+}
 
-			/* Solve body-body collisions */
-			for(de_body_t* other = scene->bodies.head; other; other = other->next) {
-				if (other != body) {
-					de_body_body_collision(body, other);
+/**
+ * @brief Continuous collision detection: moves body back to first time of impact of its inscribed sphere
+ * (scaled by DE_BODY_CCD_RADIUS_FRACTION) with static geometry on the way from last position. Discrete
+ * collision resolves contact afterwards. Returns true if body was swept.
+ */
+static bool de_body_sweep_static(de_body_t* body, de_scene_t* scene)
+{
+	de_body_sweep_t sweep = {
+		.origin = body->last_position,
+		.radius = DE_BODY_CCD_RADIUS_FRACTION * de_convex_shape_get_inscribed_radius(&body->shape),
+		.toi = 1.0f
+	};
+	de_vec3_sub(&sweep.motion, &body->position, &body->last_position);
+	sweep.length = de_vec3_len(&sweep.motion);
+	/* slow body can not pass through surface, discrete collision is enough */
+	if (sweep.radius <= 0.0f || sweep.length <= sweep.radius) {
+		return false;
+	}
+
+	de_vec3_t min = body->last_position, max = body->last_position;
+	de_vec3_min_max(&body->position, &min, &max);
+	de_vec3_sub(&min, &min, &(de_vec3_t) { sweep.radius, sweep.radius, sweep.radius });
+	de_vec3_add(&max, &max, &(de_vec3_t) { sweep.radius, sweep.radius, sweep.radius });
+	for (de_static_geometry_t* geom = scene->static_geometries.head; geom; geom = geom->next) {
+		sweep.geometry = geom;
+		de_bvh_visit_aabb(&geom->bvh, &min, &max, de_body_sweep_leaf, &sweep);
+	}
+
+	if (sweep.toi < 1.0f) {
+		de_vec3_scale(&sweep.motion, &sweep.motion, sweep.toi);
+		de_vec3_add(&body->position, &body->last_position, &sweep.motion);
+	}
+	return true;
+}
+
+typedef struct de_physics_step_t {
+	de_scene_t* scene;
+	float dt2;
+	volatile long test_count;
+	volatile long collision_count;
+	volatile long support_count;
+	volatile long ccd_count;
+	size_t batch_begin; /**< Offset of currently resolved batch in array of pairs. */
+} de_physics_step_t;
+
+static void de_physics_static_range(void* user_data, size_t begin, size_t end, size_t thread_index)
+{
+	DE_UNUSED(thread_index);
+	de_physics_step_t* step = user_data;
+	de_scene_t* scene = step->scene;
+	long test_count = 0;
+	long support_count = 0;
+	long ccd_count = 0;
+	for (size_t i = begin; i < end; ++i) {
+		de_body_t* body = scene->physics_bodies.data[i];
+		/* Drop contact information */
+		body->contact_count = 0;
+		/* Triangle mesh is kinematic: it keeps its velocity and does not collide by itself */
+		if (body->shape.type == DE_CONVEX_SHAPE_TYPE_TRIANGLE_MESH) {
+			de_body_verlet(body, step->dt2);
+			continue;
+		}
+		/* Apply gravity */
+		de_vec3_add(&body->acceleration, &body->acceleration, &body->gravity);
+		/* Do Verlet integration */
+		de_body_verlet(body, step->dt2);
+		if (body->ccd && de_body_sweep_static(body, scene)) {
+			++ccd_count;
+		}
+		/* Solve body-mesh collisions. Candidate triangles are gathered by bounds of body swept
+		 * over this step, bounds are taken before any push-out. */
+		de_body_static_collision_t collision = { .body = body, .step_index = scene->physics_step_index };
+		de_vec3_t last_min, last_max;
+		de_convex_shape_get_aabb(&body->shape, &body->position, &collision.min, &collision.max);
+		de_convex_shape_get_aabb(&body->shape, &body->last_position, &last_min, &last_max);
+		de_vec3_min_max(&last_min, &collision.min, &collision.max);
+		de_vec3_min_max(&last_max, &collision.min, &collision.max);
+		for (de_static_geometry_t* geom = scene->static_geometries.head; geom; geom = geom->next) {
+			collision.geometry = geom;
+			de_bvh_visit_aabb(&geom->bvh, &collision.min, &collision.max, de_body_static_leaf_collision, &collision);
+		}
+		test_count += (long)collision.test_count;
+		support_count += (long)collision.support_count;
+	}
+	de_atomic_add(&step->test_count, test_count);
+	de_atomic_add(&step->support_count, support_count);
+	de_atomic_add(&step->ccd_count, ccd_count);
+}
+
+static void de_physics_pair_range(void* user_data, size_t begin, size_t end, size_t thread_index)
+{
+	DE_UNUSED(thread_index);
+	de_physics_step_t* step = user_data;
+	const de_broadphase_pair_t* pairs = step->scene->broadphase.pairs.data + step->batch_begin;
+	long collision_count = 0;
+	long support_count = 0;
+	for (size_t i = begin; i < end; ++i) {
+		de_body_t* a = pairs[i].a;
+		de_body_t* b = pairs[i].b;
+		if (a->sleeping && b->sleeping) {
+			continue;
+		}
+		de_body_t* sleeper = a->sleeping ? a : (b->sleeping ? b : NULL);
+		const de_vec3_t sleeper_position = sleeper ? sleeper->position : (de_vec3_t) { 0 };
+		const int sleeper_contact_count = sleeper ? sleeper->contact_count : 0;
+		/* Each body appears once per batch, so contact caches of bodies of pair are not shared */
+		const uint32_t step_index = step->scene->physics_step_index;
+		const bool a_is_mesh = a->shape.type == DE_CONVEX_SHAPE_TYPE_TRIANGLE_MESH;
+		const bool b_is_mesh = b->shape.type == DE_CONVEX_SHAPE_TYPE_TRIANGLE_MESH;
+		int pair_support_count = 0;
+		bool collided = false;
+		if (a_is_mesh || b_is_mesh) {
+			/* two kinematic meshes do not collide */
+			if (!(a_is_mesh && b_is_mesh)) {
+				collided = de_body_mesh_collision(a_is_mesh ? b : a, a_is_mesh ? a : b, step_index, &pair_support_count);
+			}
+		} else {
+			de_vec3_t* search_dir = de_body_get_cached_search_dir(a, b, step_index);
+			collided = de_body_body_collision(a, b, search_dir, &pair_support_count);
+		}
+		support_count += pair_support_count;
+		if (collided) {
+			++collision_count;
+			if (sleeper) {
+				/* Only moving body wakes sleeper up, resting neighbours do not, otherwise group of
+				 * touching bodies would never fall asleep. Push of sleeper by resting neighbour
+				 * must not give it velocity, and its contacts stay as they were. */
+				const de_body_t* other = sleeper == a ? b : a;
+				if (other->rest_step_count == 0) {
+					de_body_wake_up(sleeper);
+				} else {
+					de_vec3_t push;
+					de_vec3_sub(&push, &sleeper->position, &sleeper_position);
+					de_vec3_add(&sleeper->last_position, &sleeper->last_position, &push);
+					sleeper->contact_count = sleeper_contact_count;
 				}
 			}
 		}
 	}
+	de_atomic_add(&step->collision_count, collision_count);
+	de_atomic_add(&step->support_count, support_count);
+}
+
+void de_physics_step_scene(de_scene_t* scene, de_thread_pool_t* pool, double dt)
+{
+	/* Batches smaller than this are resolved by calling thread, waking up workers costs more */
+	const size_t min_parallel_batch = 64;
+
+	de_physics_step_t step = { .scene = scene, .dt2 = (float)(dt * dt) };
+	de_physics_stats_t* stats = &scene->physics_stats;
+
+	++scene->physics_step_index;
+
+	/* Bodies do not interact with each other while colliding with static geometry. Sleeping bodies
+	 * are skipped, they are only checked by broadphase so awake bodies can collide with them. */
+	double start_time = de_time_get_seconds();
+	DE_ARRAY_CLEAR(scene->physics_bodies);
+	stats->body_count = 0;
+	for (de_body_t* body = scene->bodies.head; body; body = body->next) {
+		++stats->body_count;
+		body->step_start_position = body->position;
+		if (!body->sleeping) {
+			DE_ARRAY_APPEND(scene->physics_bodies, body);
+		}
+	}
+	stats->sleeping_count = stats->body_count - scene->physics_bodies.size;
+	de_thread_pool_parallel_for(pool, scene->physics_bodies.size, 0, de_physics_static_range, &step);
+	stats->static_test_count = (size_t)step.test_count;
+	stats->ccd_count = (size_t)step.ccd_count;
+	stats->static_time = de_time_get_seconds() - start_time;
+
+	/* Solve body-body collisions, each pair of bodies with overlapping bounds is resolved once */
+	start_time = de_time_get_seconds();
+	if (scene->physics_bodies.size) {
+		de_broadphase_find_pairs(&scene->broadphase, scene->bodies.head);
+	} else {
+		/* whole scene is sleeping, nothing can collide */
+		de_broadphase_find_pairs(&scene->broadphase, NULL);
+	}
+	stats->broadphase_time = de_time_get_seconds() - start_time;
+	stats->pair_count = scene->broadphase.pairs.size;
+	stats->batch_count = de_broadphase_get_batch_count(&scene->broadphase);
+
+	/* Pairs of one batch have no bodies in common, batches go in order */
+	start_time = de_time_get_seconds();
+	for (size_t i = 0; i < stats->batch_count; ++i) {
+		step.batch_begin = scene->broadphase.batches.data[i];
+		const size_t count = scene->broadphase.batches.data[i + 1] - step.batch_begin;
+		de_thread_pool_parallel_for(count >= min_parallel_batch ? pool : NULL, count, 0, de_physics_pair_range, &step);
+	}
+	stats->collision_count = (size_t)step.collision_count;
+	stats->narrowphase_time = de_time_get_seconds() - start_time;
+	stats->gjk_support_count = (size_t)step.support_count;
+
+	/* Put bodies which barely moved for a while to sleep */
+	for (size_t i = 0; i < scene->physics_bodies.size; ++i) {
+		de_body_t* body = scene->physics_bodies.data[i];
+		if (body->sleeping) {
+			continue;
+		}
+		if (de_vec3_sqr_distance(&body->position, &body->last_position) < DE_BODY_SLEEP_DISTANCE * DE_BODY_SLEEP_DISTANCE) {
+			if (++body->rest_step_count >= DE_BODY_SLEEP_STEP_COUNT) {
+				body->sleeping = true;
+				body->last_position = body->position;
+			}
+		} else {
+			body->rest_step_count = 0;
+		}
+	}
+}
+
+static void de_scene_wake_up_bodies_in_aabb(de_scene_t* scene, const de_vec3_t* min, const de_vec3_t* max)
+{
+	for (de_body_t* body = scene->bodies.head; body; body = body->next) {
+		if (body->sleeping) {
+			de_vec3_t body_min, body_max;
+			de_convex_shape_get_aabb(&body->shape, &body->position, &body_min, &body_max);
+			if (body_min.x <= max->x && body_max.x >= min->x && body_min.y <= max->y &&
+				body_max.y >= min->y && body_min.z <= max->z && body_max.z >= min->z) {
+				de_body_wake_up(body);
+			}
+		}
+	}
+}
+
+void de_static_geometry_wake_up_bodies(de_static_geometry_t* geom)
+{
+	if (geom->scene && geom->bvh.node_count) {
+		de_scene_wake_up_bodies_in_aabb(geom->scene, &geom->bvh.nodes[0].min, &geom->bvh.nodes[0].max);
+	}
+}
+
+void de_physics_set_fixed_step(de_scene_t* scene, double step, int max_steps_per_frame)
+{
+	DE_ASSERT(scene);
+	DE_ASSERT(step >= 0.0);
+	DE_ASSERT(max_steps_per_frame > 0);
+	de_physics_clock_t* clock = &scene->physics_clock;
+	clock->step = step;
+	clock->max_steps_per_frame = max_steps_per_frame;
+	clock->accumulator = 0.0;
+}
+
+float de_physics_get_interpolation_factor(const de_scene_t* scene)
+{
+	const de_physics_clock_t* clock = &scene->physics_clock;
+	return clock->step > 0.0 ? (float)(clock->accumulator / clock->step) : 1.0f;
+}
+
+int de_physics_update_scene(de_scene_t* scene, de_thread_pool_t* pool, double frame_dt)
+{
+	de_physics_clock_t* clock = &scene->physics_clock;
+	if (clock->step <= 0.0) {
+		/* variable timestep */
+		de_physics_step_scene(scene, pool, frame_dt);
+		clock->last_frame_step_count = 1;
+	} else {
+		clock->accumulator += frame_dt;
+		clock->last_frame_step_count = 0;
+		while (clock->accumulator >= clock->step) {
+			if (clock->last_frame_step_count == clock->max_steps_per_frame) {
+				/* simulation can't keep up, drop the rest instead of doing even more steps next frame */
+				clock->accumulator = fmod(clock->accumulator, clock->step);
+				break;
+			}
+			de_physics_step_scene(scene, pool, clock->step);
+			clock->accumulator -= clock->step;
+			++clock->last_frame_step_count;
+		}
+	}
+	return clock->last_frame_step_count;
+}
+
+void de_physics_step(de_core_t* core, double dt)
+{
+	for (de_scene_t* scene = core->scenes.head; scene; scene = scene->next) {
+		de_physics_update_scene(scene, de_core_get_thread_pool(core), dt);
+	}
 }
 
 static int de_ray_cast_result_distance_comparer(const void* a, const void* b)
@@ -149,11 +699,102 @@ static int de_ray_cast_result_distance_comparer(const void* a, const void* b)
 	return 0;
 }
 
-bool de_ray_cast(de_scene_t* scene, const de_ray_t* ray, de_ray_cast_flags_t flags, de_ray_cast_result_array_t* result_array)
+typedef struct de_ray_cast_static_t {
+	const de_ray_t* ray;
+	de_static_geometry_t* geometry;
+	de_ray_cast_result_array_t* result_array;
+} de_ray_cast_static_t;
+
+static bool de_ray_cast_static_leaf(void* user_data, const de_bvh_node_t* leaf)
 {
-	DE_ARRAY_CLEAR(*result_array);
+	de_ray_cast_static_t* cast = user_data;
+	for (uint32_t k = leaf->first; k < leaf->first + leaf->count; ++k) {
+		de_vec3_t intersection_point;
+		de_static_triangle_t* triangle = &cast->geometry->triangles.data[k];
+		if (de_ray_triangle_intersection(cast->ray, &triangle->a, &triangle->b, &triangle->c, &intersection_point)) {
+			de_ray_cast_result_t* result = DE_ARRAY_GROW(*cast->result_array, 1);
+			result->position = intersection_point;
+			result->normal = triangle->normal;
+			result->body = NULL;
+			result->triangle = triangle;
+			result->static_geometry = cast->geometry;
+			result->sqr_distance = de_vec3_sqr_distance(&intersection_point, &cast->ray->origin);
+		}
+	}
+	return true;
+}
 
-	/* Check bodies */
+/* returns ray parameter of point which lies on ray */
+static float de_ray_cast_get_param(const de_ray_t* ray, const de_vec3_t* point)
+{
+	de_vec3_t d;
+	de_vec3_sub(&d, point, &ray->origin);
+	return de_vec3_dot(&d, &ray->dir) / de_vec3_sqr_len(&ray->dir);
+}
+
+typedef struct de_ray_cast_closest_t {
+	const de_ray_t* ray;
+	de_static_geometry_t* geometry;
+	de_ray_cast_result_t* closest;
+	bool has_hit;
+	float t; /**< Ray parameter of closest hit, traversal skips nodes behind it. */
+} de_ray_cast_closest_t;
+
+static bool de_ray_cast_static_closest_leaf(void* user_data, const de_bvh_node_t* leaf)
+{
+	de_ray_cast_closest_t* cast = user_data;
+	for (uint32_t k = leaf->first; k < leaf->first + leaf->count; ++k) {
+		de_vec3_t intersection_point;
+		de_static_triangle_t* triangle = &cast->geometry->triangles.data[k];
+		if (de_ray_triangle_intersection(cast->ray, &triangle->a, &triangle->b, &triangle->c, &intersection_point)) {
+			const float t = de_ray_cast_get_param(cast->ray, &intersection_point);
+			if (t < cast->t) {
+				cast->t = t;
+				cast->has_hit = true;
+				cast->closest->position = intersection_point;
+				cast->closest->normal = triangle->normal;
+				cast->closest->body = NULL;
+				cast->closest->triangle = triangle;
+				cast->closest->static_geometry = cast->geometry;
+				cast->closest->sqr_distance = de_vec3_sqr_distance(&intersection_point, &cast->ray->origin);
+			}
+		}
+	}
+	return true;
+}
+
+typedef struct de_ray_cast_mesh_t {
+	const de_ray_t* ray; /**< Ray in world space. */
+	const de_ray_t* local_ray; /**< Ray in space of mesh. */
+	de_body_t* body;
+	de_ray_cast_result_array_t* result_array;
+} de_ray_cast_mesh_t;
+
+static bool de_ray_cast_mesh_leaf(void* user_data, const de_bvh_node_t* leaf)
+{
+	de_ray_cast_mesh_t* cast = user_data;
+	const de_triangle_mesh_shape_t* mesh = &cast->body->shape.s.triangle_mesh;
+	for (uint32_t k = leaf->first; k < leaf->first + leaf->count; ++k) {
+		const de_vec3_t* v = &mesh->vertices.data[k * 3];
+		de_vec3_t intersection_point;
+		if (de_ray_triangle_intersection(cast->local_ray, &v[0], &v[1], &v[2], &intersection_point)) {
+			de_ray_cast_result_t* result = DE_ARRAY_GROW(*cast->result_array, 1);
+			de_vec3_add(&result->position, &intersection_point, &cast->body->position);
+			if (!de_try_get_triangle_normal(&result->normal, &v[0], &v[1], &v[2])) {
+				result->normal = (de_vec3_t) { 0, 1, 0 };
+			}
+			result->body = cast->body;
+			result->triangle = NULL;
+			result->static_geometry = NULL;
+			result->sqr_distance = de_vec3_sqr_distance(&result->position, &cast->ray->origin);
+		}
+	}
+	return true;
+}
+
+/* appends hits with bodies of scene to result array */
+static void de_ray_cast_bodies(de_scene_t* scene, const de_ray_t* ray, de_ray_cast_flags_t flags, de_ray_cast_result_array_t* result_array)
+{
 	if (!(flags & DE_RAY_CAST_FLAGS_IGNORE_BODY)) {
 		for(de_body_t* body = scene->bodies.head; body; body = body->next) {
 			switch (body->shape.type) {
@@ -233,9 +874,46 @@ bool de_ray_cast(de_scene_t* scene, const de_ray_t* ray, de_ray_cast_flags_t fla
 					break;
 				}
 				case DE_CONVEX_SHAPE_TYPE_POINT_CLOUD: {
-					/* TODO: Implement this. This requires to build convex hull from point cloud first
-					 * i.e. by gift wrapping algorithm or some other more efficient algorithms -
-					 * https://dccg.upc.edu/people/vera/wp-content/uploads/2014/11/GA2014-ConvexHulls3D-Roger-Hernando.pdf */
+					const de_convex_hull_t* hull = &de_convex_shape_to_point_cloud(&body->shape)->hull;
+
+					/* shapes are not rotated, so ray goes into hull space by translation only */
+					de_ray_t local_ray = *ray;
+					de_vec3_sub(&local_ray.origin, &ray->origin, &body->position);
+
+					float t[2];
+					de_vec3_t normals[2];
+					if (de_convex_hull_ray_intersection(hull, &local_ray, &t[0], &t[1], &normals[0], &normals[1])) {
+						if ((flags & DE_RAY_CAST_FLAGS_IGNORE_BODY_IN_RAY) && t[0] < 0.0f) {
+							continue;
+						}
+						for (size_t i = 0; i < 2; ++i) {
+							/* only points on segment, origin or end of ray may be inside hull */
+							if (t[i] < 0.0f || t[i] > 1.0f) {
+								continue;
+							}
+							de_ray_cast_result_t* result = DE_ARRAY_GROW(*result_array, 1);
+							result->position = de_ray_evaluate(ray, t[i]);
+							result->normal = normals[i];
+							result->body = body;
+							result->triangle = NULL;
+							result->static_geometry = NULL;
+							result->sqr_distance = de_vec3_sqr_distance(&result->position, &ray->origin);
+						}
+					}
+					break;
+				}
+				case DE_CONVEX_SHAPE_TYPE_TRIANGLE_MESH: {
+					/* mesh is hollow, so there is no "inside" for IGNORE_BODY_IN_RAY */
+					de_ray_t local_ray = *ray;
+					de_vec3_sub(&local_ray.origin, &ray->origin, &body->position);
+
+					de_ray_cast_mesh_t cast = {
+						.ray = ray,
+						.local_ray = &local_ray,
+						.body = body,
+						.result_array = result_array
+					};
+					de_bvh_visit_ray(&de_convex_shape_to_triangle_mesh(&body->shape)->bvh, &local_ray, de_ray_cast_mesh_leaf, &cast);
 					break;
 				}
 				default: {
@@ -244,27 +922,48 @@ bool de_ray_cast(de_scene_t* scene, const de_ray_t* ray, de_ray_cast_flags_t fla
 			}
 		}
 	}
+}
+
+bool de_ray_cast(de_scene_t* scene, const de_ray_t* ray, de_ray_cast_flags_t flags, de_ray_cast_result_array_t* result_array)
+{
+	DE_ARRAY_CLEAR(*result_array);
+
+	/* Check bodies */
+	de_ray_cast_bodies(scene, ray, flags, result_array);
+
+	if (flags & DE_RAY_CAST_FLAGS_CLOSEST_ONLY) {
+		/* Keep closest hit with body, it limits search in static geometries */
+		de_ray_cast_result_t closest;
+		de_ray_cast_closest_t cast = { .ray = ray, .closest = &closest, .t = 1.0f };
+		for (size_t i = 0; i < result_array->size; ++i) {
+			/* sphere and capsule hits may lie behind origin or beyond end of ray */
+			const float t = de_ray_cast_get_param(ray, &result_array->data[i].position);
+			if (t >= 0.0f && t <= cast.t) {
+				closest = result_array->data[i];
+				cast.t = t;
+				cast.has_hit = true;
+			}
+		}
+
+		if (!(flags & DE_RAY_CAST_FLAGS_IGNORE_STATIC_GEOMETRY)) {
+			for (de_static_geometry_t* geom = scene->static_geometries.head; geom; geom = geom->next) {
+				cast.geometry = geom;
+				de_bvh_visit_ray_front_to_back(&geom->bvh, ray, &cast.t, de_ray_cast_static_closest_leaf, &cast);
+			}
+		}
+
+		DE_ARRAY_CLEAR(*result_array);
+		if (cast.has_hit) {
+			DE_ARRAY_APPEND(*result_array, closest);
+		}
+		return cast.has_hit;
+	}
 
 	/* Check static geometries */
 	if (!(flags & DE_RAY_CAST_FLAGS_IGNORE_STATIC_GEOMETRY)) {
 		for(de_static_geometry_t* geom = scene->static_geometries.head; geom; geom = geom->next) {
-			de_octree_trace_ray(geom->octree, ray);
-			for (int i = 0; i < geom->octree->trace_buffer.size; ++i) {
-				de_octree_node_t* node = geom->octree->trace_buffer.nodes[i];
-				for (int k = 0; k < node->index_count; ++k) {
-					de_vec3_t intersection_point;
-					de_static_triangle_t* triangle = &geom->triangles.data[node->triangle_indices[k]];
-					if (de_ray_triangle_intersection(ray, &triangle->a, &triangle->b, &triangle->c, &intersection_point)) {
-						de_ray_cast_result_t* result = DE_ARRAY_GROW(*result_array, 1);
-						result->position = intersection_point;
-						result->normal = triangle->normal;
-						result->body = NULL;
-						result->triangle = triangle;
-						result->static_geometry = geom;
-						result->sqr_distance = de_vec3_sqr_distance(&intersection_point, &ray->origin);
-					}
-				}
-			}
+			de_ray_cast_static_t cast = { .ray = ray, .geometry = geom, .result_array = result_array };
+			de_bvh_visit_ray(&geom->bvh, ray, de_ray_cast_static_leaf, &cast);
 		}
 	}
 
@@ -274,3 +973,891 @@ bool de_ray_cast(de_scene_t* scene, const de_ray_t* ray, de_ray_cast_flags_t fla
 
 	return result_array->size > 0;
 }
+
+typedef struct de_ray_cast_packet_t {
+	const de_ray_t* rays;
+	de_ray_cast_result_array_t* results;
+	de_static_geometry_t* geometry;
+} de_ray_cast_packet_t;
+
+/**
+ * Tests every triangle of leaf with every ray of packet. Terms which depend only on triangle are
+ * computed once per packet, then all lanes are processed without branches, so compiler can use
+ * vector instructions. Math is the same as in de_ray_triangle_intersection, except that plane normal
+ * is taken from static triangle.
+ */
+static bool de_ray_cast_static_packet_leaf(void* user_data, const de_bvh_node_t* leaf, uint32_t ray_mask)
+{
+	de_ray_cast_packet_t* packet = user_data;
+	const de_ray_t* rays = packet->rays;
+
+	float origin_x[DE_BVH_RAY_PACKET_SIZE], origin_y[DE_BVH_RAY_PACKET_SIZE], origin_z[DE_BVH_RAY_PACKET_SIZE];
+	float dir_x[DE_BVH_RAY_PACKET_SIZE], dir_y[DE_BVH_RAY_PACKET_SIZE], dir_z[DE_BVH_RAY_PACKET_SIZE];
+	for (int i = 0; i < DE_BVH_RAY_PACKET_SIZE; ++i) {
+		const de_ray_t* ray = &rays[(ray_mask & (1u << i)) ? i : 0];
+		origin_x[i] = ray->origin.x;
+		origin_y[i] = ray->origin.y;
+		origin_z[i] = ray->origin.z;
+		dir_x[i] = ray->dir.x;
+		dir_y[i] = ray->dir.y;
+		dir_z[i] = ray->dir.z;
+	}
+
+	for (uint32_t k = leaf->first; k < leaf->first + leaf->count; ++k) {
+		de_static_triangle_t* triangle = &packet->geometry->triangles.data[k];
+		const de_vec3_t* a = &triangle->a;
+		const de_vec3_t* n = &triangle->normal;
+
+		de_vec3_t ba, ca;
+		de_vec3_sub(&ba, &triangle->b, a);
+		de_vec3_sub(&ca, &triangle->c, a);
+		const float d = -de_vec3_dot(a, n);
+		const float ba_dot_ba = de_vec3_dot(&ba, &ba);
+		const float ca_dot_ba = de_vec3_dot(&ca, &ba);
+		const float ca_dot_ca = de_vec3_dot(&ca, &ca);
+		const float inv_denom = 1.0f / (ca_dot_ca * ba_dot_ba - ca_dot_ba * ca_dot_ba);
+
+		float point_x[DE_BVH_RAY_PACKET_SIZE], point_y[DE_BVH_RAY_PACKET_SIZE], point_z[DE_BVH_RAY_PACKET_SIZE];
+		int hit[DE_BVH_RAY_PACKET_SIZE];
+		for (int i = 0; i < DE_BVH_RAY_PACKET_SIZE; ++i) {
+			/* ray-plane intersection */
+			const float u = -(origin_x[i] * n->x + origin_y[i] * n->y + origin_z[i] * n->z + d);
+			const float v = dir_x[i] * n->x + dir_y[i] * n->y + dir_z[i] * n->z;
+			const float t = u / v;
+			point_x[i] = dir_x[i] * t + origin_x[i];
+			point_y[i] = dir_y[i] * t + origin_y[i];
+			point_z[i] = dir_z[i] * t + origin_z[i];
+
+			/* barycentric coordinates of point */
+			const float vp_x = point_x[i] - a->x;
+			const float vp_y = point_y[i] - a->y;
+			const float vp_z = point_z[i] - a->z;
+			const float dot02 = ca.x * vp_x + ca.y * vp_y + ca.z * vp_z;
+			const float dot12 = ba.x * vp_x + ba.y * vp_y + ba.z * vp_z;
+			const float bu = (ba_dot_ba * dot02 - ca_dot_ba * dot12) * inv_denom;
+			const float bv = (ca_dot_ca * dot12 - ca_dot_ba * dot02) * inv_denom;
+
+			hit[i] = (t >= 0.0f) & (bu >= 0.0f) & (bv >= 0.0f) & (bu + bv < 1.0f);
+		}
+
+		for (int i = 0; i < DE_BVH_RAY_PACKET_SIZE; ++i) {
+			if (hit[i] && (ray_mask & (1u << i))) {
+				de_ray_cast_result_t* result = DE_ARRAY_GROW(packet->results[i], 1);
+				result->position = (de_vec3_t) { point_x[i], point_y[i], point_z[i] };
+				result->normal = triangle->normal;
+				result->body = NULL;
+				result->triangle = triangle;
+				result->static_geometry = packet->geometry;
+				result->sqr_distance = de_vec3_sqr_distance(&result->position, &rays[i].origin);
+			}
+		}
+	}
+	return true;
+}
+
+typedef struct de_ray_cast_batch_t {
+	de_scene_t* scene;
+	const de_ray_t* rays;
+	size_t count;
+	de_ray_cast_flags_t flags;
+	de_ray_cast_result_array_t* results;
+	volatile long hit_count;
+} de_ray_cast_batch_t;
+
+static void de_ray_cast_batch_range(void* user_data, size_t begin, size_t end, size_t thread_index)
+{
+	de_ray_cast_batch_t* batch = user_data;
+	DE_UNUSED(thread_index);
+	long hit_count = 0;
+	for (size_t p = begin; p < end; ++p) {
+		const size_t first = p * DE_BVH_RAY_PACKET_SIZE;
+		const size_t count = batch->count - first < DE_BVH_RAY_PACKET_SIZE ? batch->count - first : DE_BVH_RAY_PACKET_SIZE;
+		const de_ray_t* rays = batch->rays + first;
+		de_ray_cast_result_array_t* results = batch->results + first;
+
+		/* closest hit of single ray is found faster by front-to-back traversal than by packet */
+		if (batch->flags & DE_RAY_CAST_FLAGS_CLOSEST_ONLY) {
+			for (size_t i = 0; i < count; ++i) {
+				hit_count += de_ray_cast(batch->scene, &rays[i], batch->flags, &results[i]);
+			}
+			continue;
+		}
+
+		for (size_t i = 0; i < count; ++i) {
+			DE_ARRAY_CLEAR(results[i]);
+			de_ray_cast_bodies(batch->scene, &rays[i], batch->flags, &results[i]);
+		}
+		if (!(batch->flags & DE_RAY_CAST_FLAGS_IGNORE_STATIC_GEOMETRY)) {
+			for (de_static_geometry_t* geom = batch->scene->static_geometries.head; geom; geom = geom->next) {
+				de_ray_cast_packet_t packet = { .rays = rays, .results = results, .geometry = geom };
+				de_bvh_visit_ray_packet(&geom->bvh, rays, count, de_ray_cast_static_packet_leaf, &packet);
+			}
+		}
+		for (size_t i = 0; i < count; ++i) {
+			if (batch->flags & DE_RAY_CAST_FLAGS_SORT_RESULTS) {
+				DE_ARRAY_QSORT(results[i], de_ray_cast_result_distance_comparer);
+			}
+			hit_count += results[i].size > 0;
+		}
+	}
+	de_atomic_add(&batch->hit_count, hit_count);
+}
+
+static size_t de_ray_cast_batch_ex(de_scene_t* scene, de_thread_pool_t* pool, const de_ray_t* rays, size_t count, de_ray_cast_flags_t flags, de_ray_cast_result_array_t* results)
+{
+	de_ray_cast_batch_t batch = {
+		.scene = scene,
+		.rays = rays,
+		.count = count,
+		.flags = flags,
+		.results = results
+	};
+	const size_t packet_count = (count + DE_BVH_RAY_PACKET_SIZE - 1) / DE_BVH_RAY_PACKET_SIZE;
+	de_thread_pool_parallel_for(pool, packet_count, 0, de_ray_cast_batch_range, &batch);
+	return (size_t)batch.hit_count;
+}
+
+size_t de_ray_cast_batch(de_scene_t* scene, const de_ray_t* rays, size_t count, de_ray_cast_flags_t flags, de_ray_cast_result_array_t* results)
+{
+	de_thread_pool_t* pool = scene->core ? de_core_get_thread_pool(scene->core) : NULL;
+	return de_ray_cast_batch_ex(scene, pool, rays, count, flags, results);
+}
+
+typedef struct de_shape_cast_t {
+	const de_convex_shape_t* shape;
+	de_vec3_t from;
+	de_vec3_t motion;
+	de_vec3_t min; /**< Bounds of shape swept from start to end of motion. */
+	de_vec3_t max;
+	de_ray_cast_flags_t flags;
+	float max_toi; /**< Hits after this time are not needed, lowered by closest-only query. */
+	de_shape_cast_result_array_t* result_array;
+	de_static_geometry_t* geometry; /**< Static geometry which is being traversed. */
+	de_body_t* body; /**< Body with triangle mesh which is being traversed. */
+} de_shape_cast_t;
+
+static int de_shape_cast_result_toi_comparer(const void* a, const void* b)
+{
+	const de_shape_cast_result_t* result_a = a;
+	const de_shape_cast_result_t* result_b = b;
+	if (result_a->toi > result_b->toi) {
+		return 1;
+	} else if (result_a->toi < result_b->toi) {
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief Conservative advancement of cast shape towards target: shape moves by distance to target
+ * divided by approach speed along closest direction, so it never jumps over target and converges in
+ * few iterations. Distance along straight motion between convex shapes is convex function of time,
+ * so target can't be hit once shape moves away from it. Returns true and writes time of impact,
+ * normal and contact point if shape touches target before max_toi. Shape which intersects target
+ * gets zero normal, caller decides which way to push it.
+ */
+static bool de_shape_cast_convex(const de_shape_cast_t* cast, const de_convex_shape_t* target, const de_vec3_t* target_position,
+	float* toi, de_vec3_t* normal, de_vec3_t* point)
+{
+	const int max_iterations = 32;
+	const float tolerance = 0.001f;
+	float t = 0.0f;
+	for (int i = 0; i < max_iterations; ++i) {
+		de_vec3_t position, direction;
+		de_vec3_scale(&position, &cast->motion, t);
+		de_vec3_add(&position, &position, &cast->from);
+		float distance;
+		if (!de_gjk_get_distance(cast->shape, &position, target, target_position, &distance, &direction, point)) {
+			*toi = t;
+			*normal = (de_vec3_t) { 0, 0, 0 };
+			*point = position;
+			return true;
+		}
+		const float approach = de_vec3_dot(&cast->motion, &direction);
+		if (approach <= 0.0f) {
+			/* moving away from target or along it */
+			return false;
+		}
+		if (distance < tolerance) {
+			*toi = t;
+			de_vec3_negate(normal, &direction);
+			return true;
+		}
+		/* stop a bit before surface, touching shapes are reported as intersecting by GJK */
+		t += (distance - 0.5f * tolerance) / approach;
+		if (t >= cast->max_toi) {
+			return false;
+		}
+	}
+	return false;
+}
+
+static void de_shape_cast_add_result(de_shape_cast_t* cast, float toi, const de_vec3_t* normal, const de_vec3_t* point,
+	de_body_t* body, de_static_triangle_t* triangle, de_static_geometry_t* geometry)
+{
+	de_shape_cast_result_t* result;
+	if (cast->flags & DE_RAY_CAST_FLAGS_CLOSEST_ONLY) {
+		/* hit is always closer than previous one, farther hits are rejected by max_toi */
+		result = cast->result_array->size ? &cast->result_array->data[0] : DE_ARRAY_GROW(*cast->result_array, 1);
+		cast->max_toi = toi;
+	} else {
+		result = DE_ARRAY_GROW(*cast->result_array, 1);
+	}
+	result->toi = toi;
+	result->position = *point;
+	result->normal = *normal;
+	result->body = body;
+	result->triangle = triangle;
+	result->static_geometry = geometry;
+}
+
+/* casts shape against triangle given in world space */
+static void de_shape_cast_triangle(de_shape_cast_t* cast, const de_vec3_t* a, const de_vec3_t* b, const de_vec3_t* c,
+	de_body_t* body, de_static_triangle_t* triangle)
+{
+	if (de_triangle_is_outside_aabb(a, b, c, &cast->min, &cast->max)) {
+		return;
+	}
+	const de_convex_shape_t triangle_shape = {
+		.type = DE_CONVEX_SHAPE_TYPE_TRIANGLE,
+		.s.triangle = {
+			.vertices = { *a, *b, *c }
+		}
+	};
+	float toi;
+	de_vec3_t normal, point;
+	if (de_shape_cast_convex(cast, &triangle_shape, &(de_vec3_t) { 0, 0, 0 }, &toi, &normal, &point)) {
+		if (de_vec3_equals(&normal, &(de_vec3_t) { 0, 0, 0 })) {
+			/* shape starts inside triangle, push it against motion */
+			if (!de_try_get_triangle_normal(&normal, a, b, c)) {
+				normal = (de_vec3_t) { 0, 1, 0 };
+			}
+			if (de_vec3_dot(&normal, &cast->motion) > 0.0f) {
+				de_vec3_negate(&normal, &normal);
+			}
+		}
+		de_shape_cast_add_result(cast, toi, &normal, &point, body, triangle, triangle ? cast->geometry : NULL);
+	}
+}
+
+static bool de_shape_cast_static_leaf(void* user_data, const de_bvh_node_t* leaf)
+{
+	de_shape_cast_t* cast = user_data;
+	for (uint32_t k = leaf->first; k < leaf->first + leaf->count; ++k) {
+		de_static_triangle_t* triangle = &cast->geometry->triangles.data[k];
+		de_shape_cast_triangle(cast, &triangle->a, &triangle->b, &triangle->c, NULL, triangle);
+	}
+	return true;
+}
+
+static bool de_shape_cast_mesh_leaf(void* user_data, const de_bvh_node_t* leaf)
+{
+	de_shape_cast_t* cast = user_data;
+	const de_vec3_t* mesh_position = &cast->body->position;
+	const de_triangle_mesh_shape_t* mesh = &cast->body->shape.s.triangle_mesh;
+	for (uint32_t k = leaf->first; k < leaf->first + leaf->count; ++k) {
+		const de_vec3_t* local = &mesh->vertices.data[k * 3];
+		de_vec3_t a, b, c;
+		de_vec3_add(&a, &local[0], mesh_position);
+		de_vec3_add(&b, &local[1], mesh_position);
+		de_vec3_add(&c, &local[2], mesh_position);
+		de_shape_cast_triangle(cast, &a, &b, &c, cast->body, NULL);
+	}
+	return true;
+}
+
+static void de_shape_cast_body(de_shape_cast_t* cast, de_body_t* body)
+{
+	de_vec3_t min, max;
+	de_convex_shape_get_aabb(&body->shape, &body->position, &min, &max);
+	if (min.x > cast->max.x || max.x < cast->min.x || min.y > cast->max.y ||
+		max.y < cast->min.y || min.z > cast->max.z || max.z < cast->min.z) {
+		return;
+	}
+
+	if (body->shape.type == DE_CONVEX_SHAPE_TYPE_TRIANGLE_MESH) {
+		de_vec3_sub(&min, &cast->min, &body->position);
+		de_vec3_sub(&max, &cast->max, &body->position);
+		cast->body = body;
+		de_bvh_visit_aabb(&body->shape.s.triangle_mesh.bvh, &min, &max, de_shape_cast_mesh_leaf, cast);
+		return;
+	}
+
+	float toi;
+	de_vec3_t normal, point;
+	if (de_shape_cast_convex(cast, &body->shape, &body->position, &toi, &normal, &point)) {
+		if (de_vec3_equals(&normal, &(de_vec3_t) { 0, 0, 0 })) {
+			if (toi == 0.0f && (cast->flags & DE_RAY_CAST_FLAGS_IGNORE_BODY_IN_RAY)) {
+				/* i.e. body which casts its own shape */
+				return;
+			}
+			/* shape starts inside body, push it away from body */
+			de_vec3_sub(&normal, &cast->from, &body->position);
+			if (!de_vec3_try_normalize(&normal, &normal)) {
+				normal = (de_vec3_t) { 0, 1, 0 };
+			}
+		}
+		de_shape_cast_add_result(cast, toi, &normal, &point, body, NULL, NULL);
+	}
+}
+
+bool de_shape_cast(de_scene_t* scene, const de_convex_shape_t* shape, const de_vec3_t* from, const de_vec3_t* to,
+	de_ray_cast_flags_t flags, de_shape_cast_result_array_t* result_array)
+{
+	DE_ARRAY_CLEAR(*result_array);
+
+	de_shape_cast_t cast = {
+		.shape = shape,
+		.from = *from,
+		.flags = flags,
+		.max_toi = 1.0f,
+		.result_array = result_array
+	};
+	de_vec3_sub(&cast.motion, to, from);
+	de_vec3_t end_min, end_max;
+	de_convex_shape_get_aabb(shape, from, &cast.min, &cast.max);
+	de_convex_shape_get_aabb(shape, to, &end_min, &end_max);
+	de_vec3_min_max(&end_min, &cast.min, &cast.max);
+	de_vec3_min_max(&end_max, &cast.min, &cast.max);
+
+	if (!(flags & DE_RAY_CAST_FLAGS_IGNORE_STATIC_GEOMETRY)) {
+		for (de_static_geometry_t* geom = scene->static_geometries.head; geom; geom = geom->next) {
+			cast.geometry = geom;
+			de_bvh_visit_aabb(&geom->bvh, &cast.min, &cast.max, de_shape_cast_static_leaf, &cast);
+		}
+	}
+
+	if (!(flags & DE_RAY_CAST_FLAGS_IGNORE_BODY)) {
+		for (de_body_t* body = scene->bodies.head; body; body = body->next) {
+			de_shape_cast_body(&cast, body);
+		}
+	}
+
+	if (flags & DE_RAY_CAST_FLAGS_SORT_RESULTS) {
+		DE_ARRAY_QSORT(*result_array, de_shape_cast_result_toi_comparer);
+	}
+
+	return result_array->size > 0;
+}
+
+static de_scene_t* de_physics_test_scene_create(const de_vec3_t* positions, size_t body_count)
+{
+	de_scene_t* scene = DE_NEW(de_scene_t);
+	de_broadphase_init(&scene->broadphase);
+
+	/* floor made of grid of triangles */
+	de_static_geometry_t* floor = de_scene_create_static_geometry(scene);
+	const int cells = 128;
+	const float cell_size = 1.0f;
+	const float origin = -32.0f;
+	for (int z = 0; z < cells; ++z) {
+		for (int x = 0; x < cells; ++x) {
+			const de_vec3_t a = { origin + x * cell_size, 0.0f, origin + z * cell_size };
+			const de_vec3_t b = { origin + (x + 1) * cell_size, 0.0f, origin + z * cell_size };
+			const de_vec3_t c = { origin + (x + 1) * cell_size, 0.0f, origin + (z + 1) * cell_size };
+			const de_vec3_t d = { origin + x * cell_size, 0.0f, origin + (z + 1) * cell_size };
+			de_static_geometry_add_triangle(floor, &a, &c, &b, 0);
+			de_static_geometry_add_triangle(floor, &a, &d, &c, 0);
+		}
+	}
+	de_static_geometry_build_bvh(floor, NULL);
+
+	for (size_t i = 0; i < body_count; ++i) {
+		de_body_t* body = de_body_create(scene, de_convex_shape_create_capsule(DE_AXIS_Y, 0.3f, 1.0f));
+		de_body_set_position(body, &positions[i]);
+	}
+
+	return scene;
+}
+
+static void de_physics_test_scene_free(de_scene_t* scene)
+{
+	while (scene->bodies.head) {
+		de_body_free(scene->bodies.head);
+	}
+	while (scene->static_geometries.head) {
+		de_scene_free_static_geometry(scene, scene->static_geometries.head);
+	}
+	de_broadphase_free(&scene->broadphase);
+	DE_ARRAY_FREE(scene->physics_bodies);
+	de_free(scene);
+}
+
+void de_physics_tests()
+{
+	const size_t body_count = 4000;
+	const int step_count = 60;
+	const double dt = 1.0 / 60.0;
+	de_thread_pool_t* pool = de_thread_pool_create(3);
+
+	/* capsules dropped into a crowd above the floor, so there are a lot of body-body contacts */
+	de_vec3_t* positions = de_malloc(body_count * sizeof(*positions));
+	for (size_t i = 0; i < body_count; ++i) {
+		positions[i] = (de_vec3_t) {
+			2.0f + 60.0f * (rand() / (float)RAND_MAX),
+			1.0f + 4.0f * (rand() / (float)RAND_MAX),
+			2.0f + 60.0f * (rand() / (float)RAND_MAX)
+		};
+	}
+
+	de_scene_t* serial = de_physics_test_scene_create(positions, body_count);
+	de_scene_t* parallel = de_physics_test_scene_create(positions, body_count);
+
+	double serial_time = 0.0, parallel_time = 0.0;
+	size_t pair_count = 0, batch_count = 0, collision_count = 0;
+	for (int i = 0; i < step_count; ++i) {
+		double start_time = de_time_get_seconds();
+		de_physics_step_scene(serial, NULL, dt);
+		serial_time += de_time_get_seconds() - start_time;
+
+		start_time = de_time_get_seconds();
+		de_physics_step_scene(parallel, pool, dt);
+		parallel_time += de_time_get_seconds() - start_time;
+
+		/* results must be exactly the same, not just close */
+		DE_ASSERT(serial->physics_stats.static_test_count == parallel->physics_stats.static_test_count);
+		DE_ASSERT(serial->physics_stats.pair_count == parallel->physics_stats.pair_count);
+		DE_ASSERT(serial->physics_stats.collision_count == parallel->physics_stats.collision_count);
+		for (de_body_t *a = serial->bodies.head, *b = parallel->bodies.head; a && b; a = a->next, b = b->next) {
+			DE_ASSERT(memcmp(&a->position, &b->position, sizeof(a->position)) == 0);
+			DE_ASSERT(memcmp(&a->last_position, &b->last_position, sizeof(a->last_position)) == 0);
+			DE_ASSERT(a->contact_count == b->contact_count);
+			DE_ASSERT(a->sleeping == b->sleeping);
+		}
+
+		pair_count += serial->physics_stats.pair_count;
+		batch_count += serial->physics_stats.batch_count;
+		collision_count += serial->physics_stats.collision_count;
+	}
+
+	/* bodies must stay above the floor */
+	for (de_body_t* body = serial->bodies.head; body; body = body->next) {
+		DE_ASSERT(body->position.y > 0.0f);
+	}
+
+	de_log("physics benchmark: %d bodies, %d steps, avg %d pairs in %d batches, %d collisions; serial %f s, %d threads %f s",
+		(int)body_count, step_count, (int)(pair_count / step_count), (int)(batch_count / step_count), (int)(collision_count / step_count),
+		serial_time, (int)de_thread_pool_get_thread_count(pool), parallel_time);
+
+	/* closest-only ray cast gives same hit as first of sorted results within ray segment */
+	de_ray_cast_result_array_t all_hits, closest_hit;
+	DE_ARRAY_INIT(all_hits);
+	DE_ARRAY_INIT(closest_hit);
+	for (int i = 0; i < 1000; ++i) {
+		de_ray_t ray;
+		ray.origin = (de_vec3_t) { 64.0f * (rand() / (float)RAND_MAX), 10.0f, 64.0f * (rand() / (float)RAND_MAX) };
+		ray.dir = (de_vec3_t) { 20.0f * (rand() / (float)RAND_MAX - 0.5f), -20.0f * (rand() / (float)RAND_MAX), 20.0f * (rand() / (float)RAND_MAX - 0.5f) };
+		de_ray_cast(serial, &ray, DE_RAY_CAST_FLAGS_IGNORE_BODY | DE_RAY_CAST_FLAGS_SORT_RESULTS, &all_hits);
+		de_ray_cast(serial, &ray, DE_RAY_CAST_FLAGS_IGNORE_BODY | DE_RAY_CAST_FLAGS_CLOSEST_ONLY, &closest_hit);
+		if (all_hits.size && all_hits.data[0].sqr_distance <= de_vec3_sqr_len(&ray.dir)) {
+			DE_ASSERT(closest_hit.size == 1);
+			DE_ASSERT(closest_hit.data[0].sqr_distance == all_hits.data[0].sqr_distance);
+		} else {
+			DE_ASSERT(closest_hit.size == 0);
+		}
+	}
+
+	/* body hits behind origin of ray must not hide static geometry in front of it */
+	de_body_t* behind = de_body_create(serial, de_convex_shape_create_sphere(1.0f));
+	de_body_set_position(behind, &(de_vec3_t) { -15.5f, 8.0f, -15.3f });
+	const de_ray_t down = { .origin = { -15.5f, 5.0f, -15.3f }, .dir = { 0.0f, -10.0f, 0.0f } };
+	DE_ASSERT(de_ray_cast(serial, &down, DE_RAY_CAST_FLAGS_CLOSEST_ONLY, &closest_hit));
+	DE_ASSERT(closest_hit.size == 1);
+	DE_ASSERT(closest_hit.data[0].body == NULL && closest_hit.data[0].static_geometry != NULL);
+	DE_ASSERT(fabsf(closest_hit.data[0].position.y) < 1e-4f);
+	de_ray_cast(serial, &down, DE_RAY_CAST_FLAGS_SORT_RESULTS, &all_hits);
+	DE_ASSERT(all_hits.size >= 3 && all_hits.data[0].body == behind && all_hits.data[1].body == behind && all_hits.data[2].body == NULL);
+	de_body_free(behind);
+
+	DE_ARRAY_FREE(all_hits);
+	DE_ARRAY_FREE(closest_hit);
+
+	/* batched ray casts: coherent fans of rays as for visibility checks of agents, compared with
+	 * ray casts one by one. Bodies are ignored, they are checked by the same code in both cases. */
+	const de_ray_cast_flags_t batch_flags = DE_RAY_CAST_FLAGS_IGNORE_BODY | DE_RAY_CAST_FLAGS_SORT_RESULTS;
+	const size_t ray_count = 16384;
+	const size_t fan_size = 64;
+	de_ray_t* rays = de_malloc(ray_count * sizeof(*rays));
+	for (size_t i = 0; i < ray_count; i += fan_size) {
+		const de_vec3_t eye = { 64.0f * (rand() / (float)RAND_MAX), 1.7f, 64.0f * (rand() / (float)RAND_MAX) };
+		const float yaw = 2.0f * (float)M_PI * (rand() / (float)RAND_MAX);
+		for (size_t k = 0; k < fan_size; ++k) {
+			const float angle = yaw + 0.01f * k;
+			rays[i + k].origin = eye;
+			rays[i + k].dir = (de_vec3_t) { 30.0f * cosf(angle), -2.0f + 0.05f * (k % 8), 30.0f * sinf(angle) };
+		}
+	}
+	de_ray_cast_result_array_t* expected = de_calloc(ray_count, sizeof(*expected));
+	de_ray_cast_result_array_t* results = de_calloc(ray_count, sizeof(*results));
+	double start_time = de_time_get_seconds();
+	size_t expected_hits = 0;
+	for (size_t i = 0; i < ray_count; ++i) {
+		expected_hits += de_ray_cast(serial, &rays[i], batch_flags, &expected[i]);
+	}
+	const double single_time = de_time_get_seconds() - start_time;
+
+	start_time = de_time_get_seconds();
+	size_t batch_hits = de_ray_cast_batch_ex(serial, NULL, rays, ray_count, batch_flags, results);
+	const double batch_time = de_time_get_seconds() - start_time;
+	DE_ASSERT(batch_hits == expected_hits);
+	for (size_t i = 0; i < ray_count; ++i) {
+		DE_ASSERT(results[i].size == expected[i].size);
+		for (size_t k = 0; k < results[i].size; ++k) {
+			/* order of hits at same distance (i.e. on shared edge) is not defined */
+			bool found = false;
+			for (size_t j = 0; j < expected[i].size && !found; ++j) {
+				found = results[i].data[k].triangle == expected[i].data[j].triangle &&
+					results[i].data[k].body == expected[i].data[j].body &&
+					de_vec3_sqr_distance(&results[i].data[k].position, &expected[i].data[j].position) < 1e-6f;
+			}
+			DE_ASSERT(found);
+		}
+	}
+
+	start_time = de_time_get_seconds();
+	batch_hits = de_ray_cast_batch_ex(serial, pool, rays, ray_count, batch_flags, results);
+	const double parallel_batch_time = de_time_get_seconds() - start_time;
+	DE_ASSERT(batch_hits == expected_hits);
+
+	de_log("ray cast benchmark: %d rays, %d with hits; one by one %f s, batch %f s, batch on %d threads %f s",
+		(int)ray_count, (int)expected_hits, single_time, batch_time, (int)de_thread_pool_get_thread_count(pool), parallel_batch_time);
+
+	for (size_t i = 0; i < ray_count; ++i) {
+		DE_ARRAY_FREE(expected[i]);
+		DE_ARRAY_FREE(results[i]);
+	}
+	de_free(expected);
+	de_free(results);
+	de_free(rays);
+
+	de_physics_test_scene_free(serial);
+	de_physics_test_scene_free(parallel);
+	de_free(positions);
+
+	/* bodies resting on the floor fall asleep, moving body wakes sleeping body up on contact */
+	{
+		const de_vec3_t resting_positions[] = { { 10.7f, 0.85f, 10.2f }, { 20.7f, 0.85f, 20.2f } };
+		de_scene_t* scene = de_physics_test_scene_create(resting_positions, 2);
+		de_body_t* first = scene->bodies.head;
+		de_body_t* second = first->next;
+		for (int i = 0; i < 3 * DE_BODY_SLEEP_STEP_COUNT; ++i) {
+			de_physics_step_scene(scene, NULL, dt);
+		}
+		DE_ASSERT(de_body_is_sleeping(first) && de_body_is_sleeping(second));
+		DE_ASSERT(scene->physics_stats.sleeping_count == 2);
+		DE_ASSERT(first->contact_count > 0);
+		const de_vec3_t sleep_position = first->position;
+		de_physics_step_scene(scene, NULL, dt);
+		DE_ASSERT(scene->physics_stats.static_test_count == 0);
+		DE_ASSERT(memcmp(&sleep_position, &first->position, sizeof(sleep_position)) == 0);
+
+		/* zero velocity does not wake body up, position change does */
+		de_body_set_velocity(second, &(de_vec3_t) { 0, 0, 0 });
+		DE_ASSERT(de_body_is_sleeping(second));
+		de_body_set_position(second, &(de_vec3_t) { 20.7f, 1.5f, 20.2f });
+		DE_ASSERT(!de_body_is_sleeping(second));
+
+		/* body dropped on top of sleeping body */
+		de_body_t* falling = de_body_create(scene, de_convex_shape_create_capsule(DE_AXIS_Y, 0.3f, 1.0f));
+		de_body_set_position(falling, &(de_vec3_t) { 10.8f, 3.5f, 10.2f });
+		bool woken = false;
+		for (int i = 0; i < 60 && !woken; ++i) {
+			de_physics_step_scene(scene, NULL, dt);
+			woken = !de_body_is_sleeping(first);
+		}
+		DE_ASSERT(woken);
+
+		de_physics_test_scene_free(scene);
+	}
+
+	/* idle world: every body is asleep */
+	{
+		const size_t idle_count = 10000;
+		de_vec3_t* idle_positions = de_malloc(idle_count * sizeof(*idle_positions));
+		for (size_t i = 0; i < idle_count; ++i) {
+			idle_positions[i] = (de_vec3_t) { (float)(i % 100) * 0.9f - 30.0f, 1.0f, (float)(i / 100) * 0.9f - 30.0f };
+		}
+		de_scene_t* scene = de_physics_test_scene_create(idle_positions, idle_count);
+		for (de_body_t* body = scene->bodies.head; body; body = body->next) {
+			body->sleeping = true;
+		}
+		double start_time = de_time_get_seconds();
+		de_physics_step_scene(scene, NULL, dt);
+		const double idle_time = de_time_get_seconds() - start_time;
+		DE_ASSERT(scene->physics_stats.sleeping_count == idle_count);
+		for (de_body_t* body = scene->bodies.head; body; body = body->next) {
+			body->sleeping = false;
+		}
+		start_time = de_time_get_seconds();
+		de_physics_step_scene(scene, NULL, dt);
+		const double awake_time = de_time_get_seconds() - start_time;
+		de_log("physics benchmark: %d bodies, step of sleeping world %f s, awake world %f s", (int)idle_count, idle_time, awake_time);
+		de_physics_test_scene_free(scene);
+		de_free(idle_positions);
+	}
+
+	/* warm-started GJK: same scene with contact caches cleared before each step. Trajectories may differ
+	 * slightly since EPA starts from different simplex, so only totals are compared. */
+	{
+		const size_t cache_body_count = 2500;
+		de_vec3_t* cache_positions = de_malloc(cache_body_count * sizeof(*cache_positions));
+		for (size_t i = 0; i < cache_body_count; ++i) {
+			cache_positions[i] = (de_vec3_t) { (float)(i % 50) * 0.9f - 20.0f, 1.0f, (float)(i / 50) * 0.9f - 20.0f };
+		}
+		de_scene_t* warm = de_physics_test_scene_create(cache_positions, cache_body_count);
+		de_scene_t* cold = de_physics_test_scene_create(cache_positions, cache_body_count);
+		size_t warm_support_count = 0, cold_support_count = 0;
+		double warm_time = 0, cold_time = 0;
+		for (int i = 0; i < 40; ++i) {
+			for (de_body_t* body = cold->bodies.head; body; body = body->next) {
+				memset(body->contact_cache, 0, sizeof(body->contact_cache));
+			}
+			de_physics_step_scene(warm, NULL, dt);
+			de_physics_step_scene(cold, NULL, dt);
+			warm_support_count += warm->physics_stats.gjk_support_count;
+			cold_support_count += cold->physics_stats.gjk_support_count;
+			warm_time += warm->physics_stats.static_time;
+			cold_time += cold->physics_stats.static_time;
+		}
+		DE_ASSERT(warm_support_count < cold_support_count);
+		for (de_body_t* body = warm->bodies.head; body; body = body->next) {
+			DE_ASSERT(body->position.y > 0.0f);
+		}
+		de_log("contact cache benchmark: %d bodies, gjk support points with cache %d, without %d; static stage %f s vs %f s",
+			(int)cache_body_count, (int)warm_support_count, (int)cold_support_count, warm_time, cold_time);
+		de_physics_test_scene_free(warm);
+		de_physics_test_scene_free(cold);
+		de_free(cache_positions);
+	}
+
+	/* fast bodies thrown at thin wall, only body with CCD stays in front of it */
+	{
+		const de_vec3_t thrown_positions[] = { { 1.3f, 0.85f, 0.6f }, { 1.3f, 0.85f, 6.6f } };
+		de_scene_t* scene = de_physics_test_scene_create(thrown_positions, 2);
+		de_static_geometry_t* wall = de_scene_create_static_geometry(scene);
+		const float wall_x = 5.0f;
+		const de_vec3_t a = { wall_x, 0.0f, -5.0f }, b = { wall_x, 3.0f, -5.0f };
+		const de_vec3_t c = { wall_x, 3.0f, 15.0f }, d = { wall_x, 0.0f, 15.0f };
+		de_static_geometry_add_triangle(wall, &a, &b, &c, 0);
+		de_static_geometry_add_triangle(wall, &a, &c, &d, 0);
+		de_static_geometry_build_bvh(wall, NULL);
+		de_body_t* ccd_body = scene->bodies.head;
+		de_body_t* body = ccd_body->next;
+		de_body_set_ccd_enabled(ccd_body, true);
+		DE_ASSERT(de_body_is_ccd_enabled(ccd_body) && !de_body_is_ccd_enabled(body));
+		size_t ccd_count = 0;
+		for (int i = 0; i < 20; ++i) {
+			de_body_set_x_velocity(ccd_body, 0.7f);
+			de_body_set_x_velocity(body, 0.7f);
+			de_physics_step_scene(scene, NULL, dt);
+			ccd_count += scene->physics_stats.ccd_count;
+		}
+		DE_ASSERT(ccd_count > 0);
+		DE_ASSERT(ccd_body->position.x < wall_x);
+		DE_ASSERT(body->position.x > wall_x);
+		de_physics_test_scene_free(scene);
+	}
+
+	/* point cloud body uses its hull for collisions and ray casts */
+	{
+		de_scene_t* scene = de_physics_test_scene_create(NULL, 0);
+		de_point_cloud_point_array_t points;
+		DE_ARRAY_INIT(points);
+		for (int i = 0; i < 8; ++i) {
+			const de_vec3_t corner = { (i & 1) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f };
+			DE_ARRAY_APPEND(points, corner);
+		}
+		for (int i = 0; i < 100; ++i) {
+			const de_vec3_t inner = { 0.8f * (rand() / (float)RAND_MAX - 0.5f), 0.8f * (rand() / (float)RAND_MAX - 0.5f), 0.8f * (rand() / (float)RAND_MAX - 0.5f) };
+			DE_ARRAY_APPEND(points, inner);
+		}
+		de_body_t* body = de_body_create(scene, de_convex_shape_create_point_cloud(points));
+		DE_ASSERT(body->shape.type == DE_CONVEX_SHAPE_TYPE_POINT_CLOUD);
+		DE_ASSERT(body->shape.s.point_cloud.hull.vertices.size == 8);
+		de_body_set_position(body, &(de_vec3_t) { 0.3f, 2.0f, 0.6f });
+		for (int i = 0; i < 120; ++i) {
+			de_physics_step_scene(scene, NULL, dt);
+		}
+		DE_ASSERT(body->position.y > 0.45f && body->position.y < 0.55f);
+
+		de_ray_cast_result_array_t hits;
+		DE_ARRAY_INIT(hits);
+		const de_ray_t ray = { { body->position.x, 5.0f, body->position.z }, { 0.0f, -10.0f, 0.0f } };
+		DE_ASSERT(de_ray_cast(scene, &ray, DE_RAY_CAST_FLAGS_SORT_RESULTS, &hits));
+		DE_ASSERT(hits.data[0].body == body);
+		DE_ASSERT(fabsf(hits.data[0].position.y - (body->position.y + 0.5f)) < 1e-4f);
+		DE_ASSERT(fabsf(hits.data[0].normal.y - 1.0f) < 1e-4f);
+		DE_ARRAY_FREE(hits);
+
+		de_physics_test_scene_free(scene);
+	}
+
+	/* elevator made of triangle mesh carries body up, mesh moves without BVH rebuild */
+	{
+		const de_vec3_t rider_positions[] = { { 10.0f, 3.5f, 10.0f } };
+		de_scene_t* scene = de_physics_test_scene_create(rider_positions, 1);
+		de_body_t* rider = scene->bodies.head;
+		/* open box: floor and four walls */
+		const de_vec3_t corners[8] = {
+			{ -1.0f, 0.0f, -1.0f }, { 1.0f, 0.0f, -1.0f }, { 1.0f, 0.0f, 1.0f }, { -1.0f, 0.0f, 1.0f },
+			{ -1.0f, 2.0f, -1.0f }, { 1.0f, 2.0f, -1.0f }, { 1.0f, 2.0f, 1.0f }, { -1.0f, 2.0f, 1.0f },
+		};
+		const int quads[5][4] = { { 0, 1, 2, 3 }, { 0, 1, 5, 4 }, { 1, 2, 6, 5 }, { 2, 3, 7, 6 }, { 3, 0, 4, 7 } };
+		de_point_cloud_point_array_t vertices;
+		DE_ARRAY_INIT(vertices);
+		for (size_t i = 0; i < DE_ARRAY_SIZE(quads); ++i) {
+			const int* q = quads[i];
+			const int indices[6] = { q[0], q[1], q[2], q[0], q[2], q[3] };
+			for (size_t k = 0; k < DE_ARRAY_SIZE(indices); ++k) {
+				DE_ARRAY_APPEND(vertices, corners[indices[k]]);
+			}
+		}
+		de_body_t* elevator = de_body_create(scene, de_convex_shape_create_triangle_mesh(vertices));
+		const de_triangle_mesh_shape_t* mesh = de_convex_shape_to_triangle_mesh(&elevator->shape);
+		DE_ASSERT(mesh->vertices.size == 30 && mesh->bvh.node_count > 0);
+		de_body_set_position(elevator, &(de_vec3_t) { 10.0f, 2.0f, 10.0f });
+
+		/* mesh is kinematic, it does not fall */
+		for (int i = 0; i < 60; ++i) {
+			de_physics_step_scene(scene, NULL, dt);
+		}
+		DE_ASSERT(elevator->position.y == 2.0f);
+		DE_ASSERT(fabsf(rider->position.y - 2.8f) < 0.05f);
+		DE_ASSERT(rider->contact_count > 0 && rider->contacts[0].body == elevator);
+
+		const de_vec3_t lift_velocity = { 0.0f, 0.02f, 0.0f };
+		for (int i = 0; i < 100; ++i) {
+			de_body_set_velocity(elevator, &lift_velocity);
+			de_physics_step_scene(scene, NULL, dt);
+			DE_ASSERT(fabsf(rider->position.x - 10.0f) < 0.7f && fabsf(rider->position.z - 10.0f) < 0.7f);
+		}
+		DE_ASSERT(elevator->position.y > 3.9f);
+		DE_ASSERT(fabsf(rider->position.y - (elevator->position.y + 0.8f)) < 0.05f);
+
+		de_ray_cast_result_array_t hits;
+		DE_ARRAY_INIT(hits);
+		const de_ray_t ray = { { 10.5f, 20.0f, 10.5f }, { 0.0f, -30.0f, 0.0f } };
+		DE_ASSERT(de_ray_cast(scene, &ray, DE_RAY_CAST_FLAGS_SORT_RESULTS, &hits));
+		DE_ASSERT(hits.data[0].body == elevator);
+		DE_ASSERT(fabsf(hits.data[0].position.y - elevator->position.y) < 1e-4f);
+		DE_ASSERT(fabsf(fabsf(hits.data[0].normal.y) - 1.0f) < 1e-4f);
+		DE_ARRAY_FREE(hits);
+
+		de_physics_test_scene_free(scene);
+	}
+
+	/* shape casts find first contact of moving shape */
+	{
+		const de_vec3_t target_positions[] = { { 5.0f, 3.0f, 0.0f } };
+		de_scene_t* scene = de_physics_test_scene_create(target_positions, 1);
+		de_body_t* target = scene->bodies.head;
+		const de_convex_shape_t capsule = de_convex_shape_create_capsule(DE_AXIS_Y, 0.3f, 1.0f);
+		const de_convex_shape_t sphere = de_convex_shape_create_sphere(0.5f);
+		de_shape_cast_result_array_t hits, all_hits;
+		DE_ARRAY_INIT(hits);
+		DE_ARRAY_INIT(all_hits);
+
+		/* capsule dropped onto floor stops when its bottom (center - 0.8) touches it */
+		const de_vec3_t above = { 0.3f, 5.0f, 0.6f }, below = { 0.3f, -5.0f, 0.6f };
+		DE_ASSERT(de_shape_cast(scene, &capsule, &above, &below, DE_RAY_CAST_FLAGS_CLOSEST_ONLY, &hits));
+		DE_ASSERT(hits.size == 1 && hits.data[0].triangle && !hits.data[0].body);
+		DE_ASSERT(fabsf(hits.data[0].toi - 0.42f) < 0.001f);
+		DE_ASSERT(fabsf(hits.data[0].normal.y - 1.0f) < 0.001f);
+		DE_ASSERT(fabsf(hits.data[0].position.y) < 0.001f);
+		DE_ASSERT(de_shape_cast(scene, &capsule, &above, &below, DE_RAY_CAST_FLAGS_SORT_RESULTS, &all_hits));
+		for (size_t i = 1; i < all_hits.size; ++i) {
+			DE_ASSERT(all_hits.data[i - 1].toi <= all_hits.data[i].toi);
+		}
+		DE_ASSERT(all_hits.data[0].toi == hits.data[0].toi);
+
+		/* sphere thrown at capsule body */
+		const de_vec3_t left = { 0.0f, 3.0f, 0.0f }, right = { 10.0f, 3.0f, 0.0f };
+		DE_ASSERT(de_shape_cast(scene, &sphere, &left, &right, DE_RAY_CAST_FLAGS_IGNORE_STATIC_GEOMETRY | DE_RAY_CAST_FLAGS_CLOSEST_ONLY, &hits));
+		DE_ASSERT(hits.data[0].body == target);
+		DE_ASSERT(fabsf(hits.data[0].toi - 0.42f) < 0.001f);
+		DE_ASSERT(fabsf(hits.data[0].normal.x + 1.0f) < 0.001f);
+		DE_ASSERT(!de_shape_cast(scene, &sphere, &right, &(de_vec3_t) { 20.0f, 3.0f, 0.0f }, 0, &hits));
+
+		/* body casting its own shape ignores itself only when asked to */
+		const de_vec3_t down = { 5.0f, -3.0f, 0.0f };
+		DE_ASSERT(de_shape_cast(scene, &target->shape, &target->position, &down, DE_RAY_CAST_FLAGS_CLOSEST_ONLY, &hits));
+		DE_ASSERT(hits.data[0].body == target && hits.data[0].toi == 0.0f);
+		DE_ASSERT(de_shape_cast(scene, &target->shape, &target->position, &down, DE_RAY_CAST_FLAGS_CLOSEST_ONLY | DE_RAY_CAST_FLAGS_IGNORE_BODY_IN_RAY, &hits));
+		DE_ASSERT(hits.data[0].triangle && fabsf(hits.data[0].toi - (3.0f - 0.8f) / 6.0f) < 0.001f);
+
+		/* one capsule cast against grid of rays covering capsule footprint */
+		const int cast_count = 1000;
+		const int rays_per_cast = 25;
+		double start_time = de_time_get_seconds();
+		for (int i = 0; i < cast_count; ++i) {
+			const de_vec3_t from = { (float)(i % 50) - 20.0f, 5.0f, (float)(i / 50) - 10.0f };
+			const de_vec3_t to = { from.x, -5.0f, from.z };
+			de_shape_cast(scene, &capsule, &from, &to, DE_RAY_CAST_FLAGS_CLOSEST_ONLY | DE_RAY_CAST_FLAGS_IGNORE_BODY, &hits);
+			DE_ASSERT(hits.size == 1);
+		}
+		const double cast_time = de_time_get_seconds() - start_time;
+		de_ray_cast_result_array_t ray_hits;
+		DE_ARRAY_INIT(ray_hits);
+		start_time = de_time_get_seconds();
+		for (int i = 0; i < cast_count; ++i) {
+			for (int k = 0; k < rays_per_cast; ++k) {
+				const de_ray_t ray = {
+					{ (float)(i % 50) - 20.0f + 0.15f * (k % 5 - 2), 5.0f, (float)(i / 50) - 10.0f + 0.15f * (k / 5 - 2) },
+					{ 0.0f, -10.0f, 0.0f }
+				};
+				de_ray_cast(scene, &ray, DE_RAY_CAST_FLAGS_CLOSEST_ONLY | DE_RAY_CAST_FLAGS_IGNORE_BODY, &ray_hits);
+			}
+		}
+		const double ray_time = de_time_get_seconds() - start_time;
+		de_log("shape cast benchmark: %d capsule casts %f s, %d rays per cast %f s", cast_count, cast_time, rays_per_cast, ray_time);
+		DE_ARRAY_FREE(ray_hits);
+
+		DE_ARRAY_FREE(hits);
+		DE_ARRAY_FREE(all_hits);
+		de_physics_test_scene_free(scene);
+	}
+
+	/* fixed timestep: same simulation regardless of frame rate, steps per frame are capped */
+	{
+		const de_vec3_t falling_positions[] = { { 0.3f, 5.0f, 0.6f } };
+		de_scene_t* fast_frames = de_physics_test_scene_create(falling_positions, 1);
+		de_scene_t* slow_frames = de_physics_test_scene_create(falling_positions, 1);
+		const double step = 1.0 / 64.0;
+		de_physics_set_fixed_step(fast_frames, step, 4);
+		de_physics_set_fixed_step(slow_frames, step, 4);
+		int fast_step_count = 0, slow_step_count = 0;
+		for (int i = 0; i < 128; ++i) {
+			fast_step_count += de_physics_update_scene(fast_frames, NULL, 1.0 / 128.0);
+		}
+		for (int i = 0; i < 32; ++i) {
+			slow_step_count += de_physics_update_scene(slow_frames, NULL, 1.0 / 32.0);
+		}
+		DE_ASSERT(fast_step_count == 64 && slow_step_count == 64);
+		const de_body_t* fast_body = fast_frames->bodies.head;
+		const de_body_t* slow_body = slow_frames->bodies.head;
+		DE_ASSERT(memcmp(&fast_body->position, &slow_body->position, sizeof(fast_body->position)) == 0);
+
+		/* half of step left in accumulator, rendered position is halfway between two last steps */
+		de_physics_update_scene(fast_frames, NULL, 1.5 * step);
+		DE_ASSERT(fabsf(de_physics_get_interpolation_factor(fast_frames) - 0.5f) < 1e-4f);
+		de_vec3_t rendered, expected;
+		de_body_get_interpolated_position(fast_body, de_physics_get_interpolation_factor(fast_frames), &rendered);
+		de_vec3_lerp(&expected, &fast_body->step_start_position, &fast_body->position, 0.5f);
+		DE_ASSERT(de_vec3_sqr_distance(&rendered, &expected) < 1e-8f);
+
+		/* long hitch does not cause burst of steps */
+		DE_ASSERT(de_physics_update_scene(slow_frames, NULL, 1.0) == 4);
+		DE_ASSERT(slow_frames->physics_clock.accumulator < step);
+
+		/* disabled scheduler steps once per frame and renders current position */
+		de_physics_set_fixed_step(slow_frames, 0.0, 1);
+		DE_ASSERT(de_physics_update_scene(slow_frames, NULL, 0.1) == 1);
+		DE_ASSERT(de_physics_get_interpolation_factor(slow_frames) == 1.0f);
+		de_body_get_interpolated_position(slow_body, 1.0f, &rendered);
+		DE_ASSERT(memcmp(&rendered, &slow_body->position, sizeof(rendered)) == 0);
+
+		de_physics_test_scene_free(fast_frames);
+		de_physics_test_scene_free(slow_frames);
+	}
+	de_thread_pool_free(pool);
+}
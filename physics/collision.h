@@ -36,6 +36,13 @@ typedef enum de_ray_cast_flags_t {
 	DE_RAY_CAST_FLAGS_IGNORE_STATIC_GEOMETRY = DE_BIT(1),
 	DE_RAY_CAST_FLAGS_SORT_RESULTS = DE_BIT(2), /**< Results will be sorted from closest to farthest (closest will be first in array) */
 	DE_RAY_CAST_FLAGS_IGNORE_BODY_IN_RAY = DE_BIT(3), /**< Bodies that contain ray origin will be ignored. Useful option if you need to cast a ray from some body, i.e. player. */
+	/**
+	 * Only closest hit will be written into result array. Much faster than DE_RAY_CAST_FLAGS_SORT_RESULTS
+	 * when only first hit is needed (hitscan, line of sight, etc.), because static geometry is traversed
+	 * front-to-back and search stops when remaining nodes are behind closest hit. Hits with static
+	 * geometry are searched only within ray segment (from origin to origin + dir).
+	 */
+	DE_RAY_CAST_FLAGS_CLOSEST_ONLY = DE_BIT(4),
 } de_ray_cast_flags_t;
 
 typedef struct de_ray_cast_result_t {
@@ -52,6 +59,20 @@ typedef struct de_ray_cast_result_t {
  */
 typedef DE_ARRAY_DECLARE(de_ray_cast_result_t, de_ray_cast_result_array_t);
 
+/**
+ * @brief Result of shape cast, see @ref de_shape_cast.
+ */
+typedef struct de_shape_cast_result_t {
+	float toi; /**< Time of impact in [0; 1]: shape touches hit entity at from + (to - from) * toi. */
+	de_vec3_t position; /**< Global position of contact point on surface of hit entity. */
+	de_vec3_t normal; /**< Unit normal of surface at contact point, points towards cast shape. */
+	de_static_triangle_t* triangle; /**< Pointer to triangle of static geometry that was hit. */
+	de_static_geometry_t* static_geometry; /**< Pointer to static geometry that was hit. */
+	de_body_t* body; /**< Pointer to body that was hit. */
+} de_shape_cast_result_t;
+
+typedef DE_ARRAY_DECLARE(de_shape_cast_result_t, de_shape_cast_result_array_t);
+
 /**
 * @class de_static_geometry_t
 * @brief Static collision geometry
@@ -62,8 +83,8 @@ typedef DE_ARRAY_DECLARE(de_ray_cast_result_t, de_ray_cast_result_array_t);
 struct de_static_geometry_t {
 	DE_LINKED_LIST_ITEM(struct de_static_geometry_t);
 	de_scene_t* scene;
-	de_octree_t* octree;
-	DE_ARRAY_DECLARE(de_static_triangle_t, triangles); /**< Array of de_static_triangle_t. All geometry stored here */
+	de_bvh_t bvh;
+	DE_ARRAY_DECLARE(de_static_triangle_t, triangles); /**< Array of de_static_triangle_t. All geometry stored here, sorted by leaves of bvh */
 };
 
 /**
@@ -82,12 +103,83 @@ bool de_static_geometry_add_triangle(de_static_geometry_t* geom, const de_vec3_t
 /**
  * @brief Performs ray cast and fills array with intersection result for every picked entity.
  * Flags can be used to choose types of entities that should participate in ray cast. 
- * Returns true if there was any hit. To get closest hit make sure to set DE_RAY_CAST_FLAGS_SORT_RESULTS
- * flag and closest will be first result in list.
+ * Returns true if there was any hit. To get closest hit use DE_RAY_CAST_FLAGS_CLOSEST_ONLY flag, or
+ * set DE_RAY_CAST_FLAGS_SORT_RESULTS flag and closest will be first result in list. Does not modify scene, so ray casts can be done from
+ * several threads simultaneously as long as each uses its own result array and scene is not modified.
  */
 bool de_ray_cast(de_scene_t* scene, const de_ray_t* ray, de_ray_cast_flags_t flags, de_ray_cast_result_array_t* result_array);
 
 /**
-* @brief Calculates physics for one frame
+ * @brief Performs count ray casts at once, i-th ray writes its hits into results[i] (result arrays
+ * must be initialized by caller and can be reused between batches). Rays are split into packets of
+ * DE_BVH_RAY_PACKET_SIZE consecutive rays which traverse static geometry together, packets are
+ * distributed between threads of core thread pool. Rays of a packet should be coherent (close
+ * origins and directions, i.e. visibility checks from one agent), otherwise packets give nothing.
+ * Results are the same as from calling @ref de_ray_cast for every ray, except order of hits at
+ * equal distance. Like @ref de_ray_cast, can be called from several threads simultaneously as long as
+ * each uses its own result arrays and scene is not modified. Returns amount of rays with at least
+ * one hit.
+ */
+size_t de_ray_cast_batch(de_scene_t* scene, const de_ray_t* rays, size_t count, de_ray_cast_flags_t flags, de_ray_cast_result_array_t* results);
+
+/**
+ * @brief Moves shape along straight line from one point to another and fills array with first
+ * contact with every entity on the way (one result per triangle of static geometry or triangle mesh,
+ * one per convex body). Uses GJK distance queries with conservative advancement, candidate triangles
+ * are gathered from BVH by bounds of swept shape, so one cast is much cheaper than set of rays
+ * approximating shape. Ray cast flags have the same meaning: DE_RAY_CAST_FLAGS_CLOSEST_ONLY keeps
+ * only earliest hit and skips farther candidates early, DE_RAY_CAST_FLAGS_SORT_RESULTS sorts by
+ * time of impact, DE_RAY_CAST_FLAGS_IGNORE_BODY_IN_RAY ignores bodies which intersect shape at
+ * start (i.e. body which casts its own shape). Entities intersecting shape at start are reported
+ * with zero time of impact. Thread-safe in the same way as @ref de_ray_cast. Returns true if there
+ * was any hit.
+ */
+bool de_shape_cast(de_scene_t* scene, const de_convex_shape_t* shape, const de_vec3_t* from, const de_vec3_t* to,
+	de_ray_cast_flags_t flags, de_shape_cast_result_array_t* result_array);
+
+/**
+ * @brief Wakes up sleeping bodies which are inside bounds of static geometry. Called automatically
+ * when static geometry is filled or freed. Triangles added by de_static_geometry_add_triangle do not
+ * participate in collisions until geometry is rebuilt, so adding them does not wake bodies up.
+ */
+void de_static_geometry_wake_up_bodies(de_static_geometry_t* geom);
+
+/**
+* @brief Calculates physics for one frame of every scene, see @ref de_physics_update_scene.
 */
 void de_physics_step(de_core_t* core, double dt);
+
+/**
+ * @brief Makes physics of scene run with fixed timestep regardless of frame rate: frame time is
+ * accumulated and simulated in steps of given duration, at most max_steps_per_frame per frame. Node
+ * transforms are interpolated between two last steps, see @ref de_physics_get_interpolation_factor.
+ * Zero step disables scheduler: one step per frame with frame time (default).
+ */
+void de_physics_set_fixed_step(de_scene_t* scene, double step, int max_steps_per_frame);
+
+/**
+ * @brief Returns fraction of fixed step accumulated but not yet simulated, in [0; 1). Rendered
+ * position of body is interpolated with this factor between position before last step and current
+ * position. Always 1 when fixed timestep is disabled.
+ */
+float de_physics_get_interpolation_factor(const de_scene_t* scene);
+
+/**
+ * @brief Advances physics of scene by frame time according to its clock (see
+ * @ref de_physics_set_fixed_step). Returns amount of steps done.
+ */
+int de_physics_update_scene(de_scene_t* scene, de_thread_pool_t* pool, double frame_dt);
+
+/**
+ * @brief Calculates physics of single scene for one frame using threads of specified pool (can be
+ * NULL). Bodies are collided with static geometry in parallel, body-body pairs are resolved in
+ * batches of independent pairs (see @ref de_broadphase_t), so results are exactly the same for
+ * any amount of threads.
+ */
+void de_physics_step_scene(de_scene_t* scene, de_thread_pool_t* pool, double dt);
+
+/**
+ * @brief Tests. Compares serial and parallel physics steps, checks ray casts and prints timings of
+ * both into log.
+ */
+void de_physics_tests();
@@ -0,0 +1,651 @@
+/* Copyright (c) 2017-2019 Dmitry Stepanov a.k.a mr.DIMAS
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+* OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+
+typedef struct de_quickhull_face_t {
+	uint32_t v[3]; /**< Indices of points, counter-clockwise when looking from outside. */
+	uint32_t neighbours[3]; /**< neighbours[k] is face across edge v[k] -> v[(k + 1) % 3]. */
+	double normal[3]; /**< Plane is kept in double precision, normals of sliver faces are way off in float. */
+	double distance;
+	bool alive;
+	bool visible; /**< Scratch: face is visible from point being added. */
+} de_quickhull_face_t;
+
+/**
+ * @brief Temporary state of hull construction.
+ */
+typedef struct de_quickhull_t {
+	const de_vec3_t* points;
+	double epsilon; /**< Points closer than this to face plane are considered to be on plane. */
+	DE_ARRAY_DECLARE(de_quickhull_face_t, faces); /**< Dead faces stay in array until hull is done. */
+	DE_ARRAY_DECLARE(uint32_t, outside_points); /**< Points which are still above some face. */
+	DE_ARRAY_DECLARE(uint32_t, outside_faces); /**< Face for each point of outside_points. */
+	DE_ARRAY_DECLARE(uint32_t, visible_faces);
+	DE_ARRAY_DECLARE(uint32_t, horizon); /**< Pairs (face, edge) of visible faces which border invisible faces. */
+	DE_ARRAY_DECLARE(uint32_t, new_faces);
+} de_quickhull_t;
+
+static double de_quickhull_face_distance(const de_quickhull_face_t* face, const de_vec3_t* point)
+{
+	return face->normal[0] * point->x + face->normal[1] * point->y + face->normal[2] * point->z - face->distance;
+}
+
+static uint32_t de_quickhull_add_face(de_quickhull_t* qh, uint32_t a, uint32_t b, uint32_t c)
+{
+	de_quickhull_face_t* face = DE_ARRAY_GROW(qh->faces, 1);
+	face->v[0] = a;
+	face->v[1] = b;
+	face->v[2] = c;
+	face->alive = true;
+	face->visible = false;
+
+	const de_vec3_t* pa = &qh->points[a];
+	const de_vec3_t* pb = &qh->points[b];
+	const de_vec3_t* pc = &qh->points[c];
+	const double ab[3] = { (double)pb->x - pa->x, (double)pb->y - pa->y, (double)pb->z - pa->z };
+	const double ac[3] = { (double)pc->x - pa->x, (double)pc->y - pa->y, (double)pc->z - pa->z };
+	double* n = face->normal;
+	n[0] = ab[1] * ac[2] - ab[2] * ac[1];
+	n[1] = ab[2] * ac[0] - ab[0] * ac[2];
+	n[2] = ab[0] * ac[1] - ab[1] * ac[0];
+	const double len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+	if (len > 0.0) {
+		n[0] /= len;
+		n[1] /= len;
+		n[2] /= len;
+	}
+	/* degenerate face has zero normal, it does not see any point and is removed with neighbours */
+	face->distance = n[0] * pa->x + n[1] * pa->y + n[2] * pa->z;
+
+	return (uint32_t)(qh->faces.size - 1);
+}
+
+/**
+ * @brief Assigns point to face it is farthest above. Returns false if point is not above any of faces.
+ */
+static bool de_quickhull_assign_point(de_quickhull_t* qh, uint32_t point, const uint32_t* faces, size_t face_count)
+{
+	double max_distance = qh->epsilon;
+	uint32_t best_face = UINT32_MAX;
+	for (size_t i = 0; i < face_count; ++i) {
+		const double distance = de_quickhull_face_distance(&qh->faces.data[faces[i]], &qh->points[point]);
+		if (distance > max_distance) {
+			max_distance = distance;
+			best_face = faces[i];
+		}
+	}
+	if (best_face == UINT32_MAX) {
+		return false;
+	}
+	DE_ARRAY_APPEND(qh->outside_points, point);
+	DE_ARRAY_APPEND(qh->outside_faces, best_face);
+	return true;
+}
+
+static int de_quickhull_find_edge(const de_quickhull_face_t* face, uint32_t a, uint32_t b)
+{
+	for (int k = 0; k < 3; ++k) {
+		if (face->v[k] == a && face->v[(k + 1) % 3] == b) {
+			return k;
+		}
+	}
+	return -1;
+}
+
+/**
+ * @brief Builds initial tetrahedron of extreme points. Returns false if points do not span volume.
+ */
+static bool de_quickhull_init(de_quickhull_t* qh, size_t count)
+{
+	const de_vec3_t* points = qh->points;
+
+	/* extreme points along axes */
+	uint32_t extremes[6] = { 0 };
+	for (uint32_t i = 1; i < count; ++i) {
+		for (int axis = 0; axis < 3; ++axis) {
+			const float value = ((const float*)&points[i])[axis];
+			if (value < ((const float*)&points[extremes[axis * 2]])[axis]) {
+				extremes[axis * 2] = i;
+			}
+			if (value > ((const float*)&points[extremes[axis * 2 + 1]])[axis]) {
+				extremes[axis * 2 + 1] = i;
+			}
+		}
+	}
+
+	/* Tolerance relative to size of cloud, absolute one would not work for both tiny and huge clouds.
+	 * Planes are computed in double from exact float input, so tolerance only covers double rounding.
+	 * Float sized tolerance drops points which are slightly outside of sliver faces, and those add up
+	 * to visible holes on thin or distant clouds. */
+	double max_coord_sum = 0.0;
+	for (int axis = 0; axis < 3; ++axis) {
+		const float min = fabsf(((const float*)&points[extremes[axis * 2]])[axis]);
+		const float max = fabsf(((const float*)&points[extremes[axis * 2 + 1]])[axis]);
+		max_coord_sum += min > max ? min : max;
+	}
+	qh->epsilon = 3.0 * DBL_EPSILON * max_coord_sum;
+	/* but cloud which is flat up to float precision has no volume */
+	const float flat_tolerance = 3.0f * FLT_EPSILON * (float)max_coord_sum;
+
+	/* two most distant extreme points */
+	uint32_t v0 = 0, v1 = 0;
+	float max_sqr_distance = 0.0f;
+	for (int i = 0; i < 6; ++i) {
+		for (int j = i + 1; j < 6; ++j) {
+			const float sqr_distance = de_vec3_sqr_distance(&points[extremes[i]], &points[extremes[j]]);
+			if (sqr_distance > max_sqr_distance) {
+				max_sqr_distance = sqr_distance;
+				v0 = extremes[i];
+				v1 = extremes[j];
+			}
+		}
+	}
+	if (max_sqr_distance <= flat_tolerance * flat_tolerance) {
+		return false;
+	}
+
+	/* farthest point from line */
+	de_vec3_t line_dir;
+	de_vec3_sub(&line_dir, &points[v1], &points[v0]);
+	de_vec3_normalize(&line_dir, &line_dir);
+	uint32_t v2 = 0;
+	max_sqr_distance = 0.0f;
+	for (uint32_t i = 0; i < count; ++i) {
+		de_vec3_t d, perp;
+		de_vec3_sub(&d, &points[i], &points[v0]);
+		de_vec3_cross(&perp, &d, &line_dir);
+		const float sqr_distance = de_vec3_sqr_len(&perp);
+		if (sqr_distance > max_sqr_distance) {
+			max_sqr_distance = sqr_distance;
+			v2 = i;
+		}
+	}
+	if (max_sqr_distance <= flat_tolerance * flat_tolerance) {
+		return false;
+	}
+
+	/* farthest point from plane */
+	de_vec3_t ab, ac, normal;
+	de_vec3_sub(&ab, &points[v1], &points[v0]);
+	de_vec3_sub(&ac, &points[v2], &points[v0]);
+	de_vec3_cross(&normal, &ab, &ac);
+	de_vec3_normalize(&normal, &normal);
+	uint32_t v3 = 0;
+	float max_distance = 0.0f;
+	for (uint32_t i = 0; i < count; ++i) {
+		de_vec3_t d;
+		de_vec3_sub(&d, &points[i], &points[v0]);
+		const float distance = fabsf(de_vec3_dot(&d, &normal));
+		if (distance > max_distance) {
+			max_distance = distance;
+			v3 = i;
+		}
+	}
+	if (max_distance <= flat_tolerance) {
+		return false;
+	}
+
+	/* orient tetrahedron so its faces look outside */
+	de_vec3_t d;
+	de_vec3_sub(&d, &points[v3], &points[v0]);
+	if (de_vec3_dot(&d, &normal) > 0.0f) {
+		const uint32_t temp = v1;
+		v1 = v2;
+		v2 = temp;
+	}
+	/* base v0 v1 v2 looks away from v3, side faces share edges with it */
+	const uint32_t f0 = de_quickhull_add_face(qh, v0, v1, v2);
+	const uint32_t f1 = de_quickhull_add_face(qh, v1, v0, v3);
+	const uint32_t f2 = de_quickhull_add_face(qh, v2, v1, v3);
+	const uint32_t f3 = de_quickhull_add_face(qh, v0, v2, v3);
+	const uint32_t tetrahedron[4] = { f0, f1, f2, f3 };
+	for (int i = 0; i < 4; ++i) {
+		de_quickhull_face_t* face = &qh->faces.data[tetrahedron[i]];
+		for (int k = 0; k < 3; ++k) {
+			for (int j = 0; j < 4; ++j) {
+				if (j != i && de_quickhull_find_edge(&qh->faces.data[tetrahedron[j]], face->v[(k + 1) % 3], face->v[k]) >= 0) {
+					face->neighbours[k] = tetrahedron[j];
+				}
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < count; ++i) {
+		if (i != v0 && i != v1 && i != v2 && i != v3) {
+			de_quickhull_assign_point(qh, i, tetrahedron, 4);
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Adds point to hull: removes faces visible from it and connects horizon to it.
+ */
+static void de_quickhull_add_point(de_quickhull_t* qh, uint32_t point, uint32_t start_face)
+{
+	const de_vec3_t* position = &qh->points[point];
+
+	/* Flood visible faces from face point is above. Going over neighbours keeps visible region
+	 * connected, so horizon is one closed loop even if rounding errors make some distant face look
+	 * visible too. */
+	DE_ARRAY_CLEAR(qh->visible_faces);
+	DE_ARRAY_CLEAR(qh->horizon);
+	qh->faces.data[start_face].visible = true;
+	DE_ARRAY_APPEND(qh->visible_faces, start_face);
+	for (size_t i = 0; i < qh->visible_faces.size; ++i) {
+		const uint32_t face_index = qh->visible_faces.data[i];
+		for (int k = 0; k < 3; ++k) {
+			const uint32_t neighbour_index = qh->faces.data[face_index].neighbours[k];
+			de_quickhull_face_t* neighbour = &qh->faces.data[neighbour_index];
+			if (neighbour->visible) {
+				continue;
+			}
+			if (de_quickhull_face_distance(neighbour, position) > qh->epsilon) {
+				neighbour->visible = true;
+				DE_ARRAY_APPEND(qh->visible_faces, neighbour_index);
+			} else {
+				DE_ARRAY_APPEND(qh->horizon, face_index);
+				DE_ARRAY_APPEND(qh->horizon, (uint32_t)k);
+			}
+		}
+	}
+
+	/* Cone of new faces: one face per horizon edge. Faces array may grow, so no pointers are kept. */
+	DE_ARRAY_CLEAR(qh->new_faces);
+	for (size_t i = 0; i < qh->horizon.size; i += 2) {
+		const uint32_t visible_index = qh->horizon.data[i];
+		const int k = (int)qh->horizon.data[i + 1];
+		const uint32_t a = qh->faces.data[visible_index].v[k];
+		const uint32_t b = qh->faces.data[visible_index].v[(k + 1) % 3];
+		const uint32_t outer_index = qh->faces.data[visible_index].neighbours[k];
+
+		const uint32_t new_index = de_quickhull_add_face(qh, a, b, point);
+		DE_ARRAY_APPEND(qh->new_faces, new_index);
+
+		de_quickhull_face_t* outer = &qh->faces.data[outer_index];
+		const int outer_edge = de_quickhull_find_edge(outer, b, a);
+		DE_ASSERT(outer_edge >= 0);
+		outer->neighbours[outer_edge] = new_index;
+		qh->faces.data[new_index].neighbours[0] = outer_index;
+	}
+
+	/* Link new faces with each other: edge b -> point of face (a, b) borders face which starts at b */
+	for (size_t i = 0; i < qh->new_faces.size; ++i) {
+		de_quickhull_face_t* face = &qh->faces.data[qh->new_faces.data[i]];
+		for (size_t j = 0; j < qh->new_faces.size; ++j) {
+			const de_quickhull_face_t* other = &qh->faces.data[qh->new_faces.data[j]];
+			if (other->v[0] == face->v[1]) {
+				face->neighbours[1] = qh->new_faces.data[j];
+			}
+			if (other->v[1] == face->v[0]) {
+				face->neighbours[2] = qh->new_faces.data[j];
+			}
+		}
+	}
+
+	for (size_t i = 0; i < qh->visible_faces.size; ++i) {
+		qh->faces.data[qh->visible_faces.data[i]].alive = false;
+	}
+
+	/* Points above removed faces are reassigned to new faces or dropped as inner points */
+	size_t kept = 0;
+	const size_t outside_count = qh->outside_points.size;
+	for (size_t i = 0; i < outside_count; ++i) {
+		const uint32_t outside_point = qh->outside_points.data[i];
+		const uint32_t outside_face = qh->outside_faces.data[i];
+		if (outside_point == point) {
+			continue;
+		}
+		if (qh->faces.data[outside_face].alive) {
+			qh->outside_points.data[kept] = outside_point;
+			qh->outside_faces.data[kept] = outside_face;
+			++kept;
+		} else {
+			double max_distance = qh->epsilon;
+			uint32_t best_face = UINT32_MAX;
+			for (size_t j = 0; j < qh->new_faces.size; ++j) {
+				const double distance = de_quickhull_face_distance(&qh->faces.data[qh->new_faces.data[j]], &qh->points[outside_point]);
+				if (distance > max_distance) {
+					max_distance = distance;
+					best_face = qh->new_faces.data[j];
+				}
+			}
+			if (best_face != UINT32_MAX) {
+				qh->outside_points.data[kept] = outside_point;
+				qh->outside_faces.data[kept] = best_face;
+				++kept;
+			}
+		}
+	}
+	qh->outside_points.size = kept;
+	qh->outside_faces.size = kept;
+}
+
+static void de_convex_hull_finalize(de_convex_hull_t* hull, const de_quickhull_t* qh, size_t count)
+{
+	/* keep only points referenced by faces */
+	uint32_t* remap = de_malloc(count * sizeof(*remap));
+	for (size_t i = 0; i < count; ++i) {
+		remap[i] = UINT32_MAX;
+	}
+	for (size_t i = 0; i < qh->faces.size; ++i) {
+		const de_quickhull_face_t* face = &qh->faces.data[i];
+		if (!face->alive) {
+			continue;
+		}
+		for (int k = 0; k < 3; ++k) {
+			if (remap[face->v[k]] == UINT32_MAX) {
+				remap[face->v[k]] = (uint32_t)hull->vertices.size;
+				DE_ARRAY_APPEND(hull->vertices, qh->points[face->v[k]]);
+			}
+		}
+		de_convex_hull_face_t* hull_face = DE_ARRAY_GROW(hull->faces, 1);
+		hull_face->a = remap[face->v[0]];
+		hull_face->b = remap[face->v[1]];
+		hull_face->c = remap[face->v[2]];
+		hull_face->normal = (de_vec3_t) { (float)face->normal[0], (float)face->normal[1], (float)face->normal[2] };
+		hull_face->distance = (float)face->distance;
+	}
+	de_free(remap);
+
+	/* Every directed edge a -> b belongs to exactly one face of closed hull, so b is listed once
+	 * among neighbours of a. */
+	DE_ARRAY_GROW(hull->neighbour_offsets, hull->vertices.size + 1);
+	memset(hull->neighbour_offsets.data, 0, hull->neighbour_offsets.size * sizeof(uint32_t));
+	for (size_t i = 0; i < hull->faces.size; ++i) {
+		const de_convex_hull_face_t* face = &hull->faces.data[i];
+		++hull->neighbour_offsets.data[face->a + 1];
+		++hull->neighbour_offsets.data[face->b + 1];
+		++hull->neighbour_offsets.data[face->c + 1];
+	}
+	for (size_t i = 1; i < hull->neighbour_offsets.size; ++i) {
+		hull->neighbour_offsets.data[i] += hull->neighbour_offsets.data[i - 1];
+	}
+	DE_ARRAY_GROW(hull->neighbours, hull->faces.size * 3);
+	uint32_t* cursors = de_malloc(hull->vertices.size * sizeof(*cursors));
+	memcpy(cursors, hull->neighbour_offsets.data, hull->vertices.size * sizeof(*cursors));
+	for (size_t i = 0; i < hull->faces.size; ++i) {
+		const de_convex_hull_face_t* face = &hull->faces.data[i];
+		hull->neighbours.data[cursors[face->a]++] = face->b;
+		hull->neighbours.data[cursors[face->b]++] = face->c;
+		hull->neighbours.data[cursors[face->c]++] = face->a;
+	}
+	de_free(cursors);
+
+	for (int i = 0; i < 6; ++i) {
+		hull->extreme_vertices[i] = 0;
+	}
+	for (uint32_t i = 1; i < hull->vertices.size; ++i) {
+		for (int axis = 0; axis < 3; ++axis) {
+			const float value = ((const float*)&hull->vertices.data[i])[axis];
+			if (value < ((const float*)&hull->vertices.data[hull->extreme_vertices[axis * 2]])[axis]) {
+				hull->extreme_vertices[axis * 2] = i;
+			}
+			if (value > ((const float*)&hull->vertices.data[hull->extreme_vertices[axis * 2 + 1]])[axis]) {
+				hull->extreme_vertices[axis * 2 + 1] = i;
+			}
+		}
+	}
+}
+
+bool de_convex_hull_build(de_convex_hull_t* hull, const de_vec3_t* points, size_t count)
+{
+	DE_ARRAY_CLEAR(hull->vertices);
+	DE_ARRAY_CLEAR(hull->faces);
+	DE_ARRAY_CLEAR(hull->neighbour_offsets);
+	DE_ARRAY_CLEAR(hull->neighbours);
+
+	if (count < 4) {
+		return false;
+	}
+
+	de_quickhull_t qh = { .points = points };
+	bool result = de_quickhull_init(&qh, count);
+	if (result) {
+		while (qh.outside_points.size) {
+			/* farthest point above face of first outside point */
+			const uint32_t face_index = qh.outside_faces.data[0];
+			const de_quickhull_face_t* face = &qh.faces.data[face_index];
+			uint32_t point = qh.outside_points.data[0];
+			double max_distance = de_quickhull_face_distance(face, &points[point]);
+			for (size_t i = 1; i < qh.outside_points.size; ++i) {
+				if (qh.outside_faces.data[i] == face_index) {
+					const double distance = de_quickhull_face_distance(face, &points[qh.outside_points.data[i]]);
+					if (distance > max_distance) {
+						max_distance = distance;
+						point = qh.outside_points.data[i];
+					}
+				}
+			}
+			de_quickhull_add_point(&qh, point, face_index);
+		}
+		de_convex_hull_finalize(hull, &qh, count);
+	}
+
+	DE_ARRAY_FREE(qh.faces);
+	DE_ARRAY_FREE(qh.outside_points);
+	DE_ARRAY_FREE(qh.outside_faces);
+	DE_ARRAY_FREE(qh.visible_faces);
+	DE_ARRAY_FREE(qh.horizon);
+	DE_ARRAY_FREE(qh.new_faces);
+
+	return result;
+}
+
+void de_convex_hull_free(de_convex_hull_t* hull)
+{
+	DE_ARRAY_FREE(hull->vertices);
+	DE_ARRAY_FREE(hull->faces);
+	DE_ARRAY_FREE(hull->neighbour_offsets);
+	DE_ARRAY_FREE(hull->neighbours);
+}
+
+de_vec3_t de_convex_hull_get_farthest_point(const de_convex_hull_t* hull, const de_vec3_t* dir)
+{
+	DE_ASSERT(hull->vertices.size);
+
+	uint32_t best = hull->extreme_vertices[0];
+	float best_dot = de_vec3_dot(&hull->vertices.data[best], dir);
+	for (int i = 1; i < 6; ++i) {
+		const float dot = de_vec3_dot(&hull->vertices.data[hull->extreme_vertices[i]], dir);
+		if (dot > best_dot) {
+			best_dot = dot;
+			best = hull->extreme_vertices[i];
+		}
+	}
+
+	/* Steepest ascent over edges, stops at vertex with no better neighbour. Comparison is strict,
+	 * so walk can not cycle over vertices with equal projection. */
+	for (;;) {
+		const uint32_t current = best;
+		for (uint32_t i = hull->neighbour_offsets.data[current]; i < hull->neighbour_offsets.data[current + 1]; ++i) {
+			const uint32_t neighbour = hull->neighbours.data[i];
+			const float dot = de_vec3_dot(&hull->vertices.data[neighbour], dir);
+			if (dot > best_dot) {
+				best_dot = dot;
+				best = neighbour;
+			}
+		}
+		if (best == current) {
+			break;
+		}
+	}
+
+	return hull->vertices.data[best];
+}
+
+bool de_convex_hull_ray_intersection(const de_convex_hull_t* hull, const de_ray_t* ray, float* t_enter, float* t_exit, de_vec3_t* enter_normal, de_vec3_t* exit_normal)
+{
+	/* Hull is intersection of half-spaces behind its faces, so ray is clipped by every face plane */
+	float enter = -FLT_MAX, exit = FLT_MAX;
+	size_t enter_face = 0, exit_face = 0;
+	for (size_t i = 0; i < hull->faces.size; ++i) {
+		const de_convex_hull_face_t* face = &hull->faces.data[i];
+		const float denom = de_vec3_dot(&face->normal, &ray->dir);
+		const float dist = face->distance - de_vec3_dot(&face->normal, &ray->origin);
+		if (denom == 0.0f) {
+			/* parallel to face and in front of it */
+			if (dist < 0.0f) {
+				return false;
+			}
+		} else {
+			const float t = dist / denom;
+			if (denom < 0.0f) {
+				if (t > enter) {
+					enter = t;
+					enter_face = i;
+				}
+			} else if (t < exit) {
+				exit = t;
+				exit_face = i;
+			}
+		}
+		if (enter > exit) {
+			return false;
+		}
+	}
+
+	if (enter > 1.0f || exit < 0.0f || !hull->faces.size) {
+		return false;
+	}
+
+	*t_enter = enter;
+	*t_exit = exit;
+	*enter_normal = hull->faces.data[enter_face].normal;
+	*exit_normal = hull->faces.data[exit_face].normal;
+	return true;
+}
+
+static void de_convex_hull_tests_random_ball(de_vec3_t* points, size_t count, float radius)
+{
+	for (size_t i = 0; i < count; ++i) {
+		de_vec3_t p;
+		do {
+			p = (de_vec3_t) { 2.0f * rand() / (float)RAND_MAX - 1.0f, 2.0f * rand() / (float)RAND_MAX - 1.0f, 2.0f * rand() / (float)RAND_MAX - 1.0f };
+		} while (de_vec3_sqr_len(&p) > 1.0f);
+		de_vec3_scale(&points[i], &p, radius);
+	}
+}
+
+void de_convex_hull_tests()
+{
+	de_convex_hull_t hull = { 0 };
+
+	/* cube with points inside: only corners remain */
+	{
+		de_vec3_t points[8 + 64];
+		for (int i = 0; i < 8; ++i) {
+			points[i] = (de_vec3_t) { (i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f };
+		}
+		de_convex_hull_tests_random_ball(points + 8, 64, 0.9f);
+		DE_ASSERT(de_convex_hull_build(&hull, points, DE_ARRAY_SIZE(points)));
+		DE_ASSERT(hull.vertices.size == 8);
+		DE_ASSERT(hull.faces.size == 12);
+
+		const de_vec3_t farthest = de_convex_hull_get_farthest_point(&hull, &(de_vec3_t) { 0.1f, -1.0f, 0.2f });
+		DE_ASSERT(farthest.x == 1.0f && farthest.y == -1.0f && farthest.z == 1.0f);
+
+		float t_enter, t_exit;
+		de_vec3_t enter_normal, exit_normal;
+		const de_ray_t ray = { { 0.5f, 0.5f, -10.0f }, { 0.0f, 0.0f, 20.0f } };
+		DE_ASSERT(de_convex_hull_ray_intersection(&hull, &ray, &t_enter, &t_exit, &enter_normal, &exit_normal));
+		DE_ASSERT(fabsf(t_enter - 9.0f / 20.0f) < 1e-5f && fabsf(t_exit - 11.0f / 20.0f) < 1e-5f);
+		DE_ASSERT(fabsf(enter_normal.z + 1.0f) < 1e-5f && fabsf(exit_normal.z - 1.0f) < 1e-5f);
+		const de_ray_t short_ray = { { 0.5f, 0.5f, -10.0f }, { 0.0f, 0.0f, 5.0f } };
+		DE_ASSERT(!de_convex_hull_ray_intersection(&hull, &short_ray, &t_enter, &t_exit, &enter_normal, &exit_normal));
+		const de_ray_t miss_ray = { { 1.5f, 0.5f, -10.0f }, { 0.0f, 0.0f, 20.0f } };
+		DE_ASSERT(!de_convex_hull_ray_intersection(&hull, &miss_ray, &t_enter, &t_exit, &enter_normal, &exit_normal));
+	}
+
+	/* flat cloud has no volume */
+	{
+		de_vec3_t points[32];
+		for (int i = 0; i < 32; ++i) {
+			points[i] = (de_vec3_t) { rand() / (float)RAND_MAX, 2.0f, rand() / (float)RAND_MAX };
+		}
+		DE_ASSERT(!de_convex_hull_build(&hull, points, DE_ARRAY_SIZE(points)));
+		DE_ASSERT(hull.vertices.size == 0);
+	}
+
+	/* thin slab far from origin: sliver faces along its rim must not leave points outside */
+	{
+		de_vec3_t points[2000];
+		for (size_t i = 0; i < DE_ARRAY_SIZE(points); ++i) {
+			points[i] = (de_vec3_t) { 1000.0f + 100.0f * rand() / (float)RAND_MAX, 0.01f * rand() / (float)RAND_MAX, 100.0f * rand() / (float)RAND_MAX };
+		}
+		DE_ASSERT(de_convex_hull_build(&hull, points, DE_ARRAY_SIZE(points)));
+		for (size_t i = 0; i < DE_ARRAY_SIZE(points); ++i) {
+			for (size_t j = 0; j < hull.faces.size; ++j) {
+				const de_convex_hull_face_t* face = &hull.faces.data[j];
+				DE_ASSERT(de_vec3_dot(&face->normal, &points[i]) - face->distance < 1e-3f);
+			}
+		}
+	}
+
+	/* dense cloud: hull contains every point, is closed, hill climbing agrees with linear scan */
+	const size_t count = 20000;
+	de_vec3_t* points = de_malloc(count * sizeof(*points));
+	de_convex_hull_tests_random_ball(points, count, 2.0f);
+	double start_time = de_time_get_seconds();
+	DE_ASSERT(de_convex_hull_build(&hull, points, count));
+	const double build_time = de_time_get_seconds() - start_time;
+
+	for (size_t i = 0; i < count; ++i) {
+		for (size_t j = 0; j < hull.faces.size; ++j) {
+			const de_convex_hull_face_t* face = &hull.faces.data[j];
+			DE_ASSERT(de_vec3_dot(&face->normal, &points[i]) - face->distance < 1e-4f);
+		}
+	}
+	/* Euler formula for closed convex polyhedron: V - E + F = 2, each edge is listed twice */
+	DE_ASSERT((int)hull.vertices.size - (int)hull.neighbours.size / 2 + (int)hull.faces.size == 2);
+
+	const size_t query_count = 100000;
+	de_vec3_t* dirs = de_malloc(query_count * sizeof(*dirs));
+	for (size_t i = 0; i < query_count; ++i) {
+		dirs[i] = (de_vec3_t) { rand() / (float)RAND_MAX - 0.5f, rand() / (float)RAND_MAX - 0.5f, rand() / (float)RAND_MAX - 0.5f };
+	}
+	volatile float sink = 0.0f; /* keeps queries from being optimized out */
+	start_time = de_time_get_seconds();
+	for (size_t i = 0; i < query_count; ++i) {
+		const de_vec3_t p = de_convex_hull_get_farthest_point(&hull, &dirs[i]);
+		sink += p.x;
+	}
+	const double hill_time = de_time_get_seconds() - start_time;
+	start_time = de_time_get_seconds();
+	for (size_t i = 0; i < query_count; ++i) {
+		const de_vec3_t p = de_point_cloud_get_farthest_point(points, (int)count, &dirs[i]);
+		sink += p.x;
+	}
+	const double linear_time = de_time_get_seconds() - start_time;
+	for (size_t i = 0; i < 1000; ++i) {
+		const de_vec3_t hill = de_convex_hull_get_farthest_point(&hull, &dirs[i]);
+		const de_vec3_t linear = de_point_cloud_get_farthest_point(points, (int)count, &dirs[i]);
+		DE_ASSERT(de_vec3_dot(&linear, &dirs[i]) - de_vec3_dot(&hill, &dirs[i]) < 1e-5f);
+	}
+
+	de_log("convex hull benchmark: %d points, hull of %d vertices and %d faces built in %f s; %d support queries: hill climbing %f s, linear scan %f s",
+		(int)count, (int)hull.vertices.size, (int)hull.faces.size, build_time, (int)query_count, hill_time, linear_time);
+
+	de_free(dirs);
+	de_free(points);
+	de_convex_hull_free(&hull);
+}
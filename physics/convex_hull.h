@@ -0,0 +1,74 @@
+/* Copyright (c) 2017-2019 Dmitry Stepanov a.k.a mr.DIMAS
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+* LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+* OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+/**
+ * Convex hull of point cloud.
+ *
+ * Built by quickhull: start from tetrahedron of extreme points, then repeatedly take farthest point
+ * outside of some face, remove all faces visible from it and connect horizon edges to the point.
+ * Hull keeps triangle faces with their planes (for ray casts) and adjacency of vertices (for support
+ * mapping by hill climbing, which visits few vertices instead of every point of cloud).
+ */
+
+typedef struct de_convex_hull_face_t {
+	uint32_t a, b, c; /**< Indices of vertices, counter-clockwise when looking from outside. */
+	de_vec3_t normal; /**< Outward normal. */
+	float distance; /**< dot(normal, p) = distance for every point p of face plane. */
+} de_convex_hull_face_t;
+
+typedef struct de_convex_hull_t {
+	DE_ARRAY_DECLARE(de_vec3_t, vertices);
+	DE_ARRAY_DECLARE(de_convex_hull_face_t, faces);
+	/** Neighbours of vertex i are neighbours[neighbour_offsets[i]] .. neighbours[neighbour_offsets[i + 1] - 1] */
+	DE_ARRAY_DECLARE(uint32_t, neighbour_offsets);
+	DE_ARRAY_DECLARE(uint32_t, neighbours);
+	uint32_t extreme_vertices[6]; /**< Vertices with min and max x, y, z - starting points of hill climbing. */
+} de_convex_hull_t;
+
+/**
+ * @brief Builds convex hull of points. Returns false and leaves hull empty if points do not span
+ * volume (less than four points, all points on one plane or line).
+ */
+bool de_convex_hull_build(de_convex_hull_t* hull, const de_vec3_t* points, size_t count);
+
+/**
+ * @brief Frees hull resources. Hull can be built again after this call.
+ */
+void de_convex_hull_free(de_convex_hull_t* hull);
+
+/**
+ * @brief Returns vertex of hull farthest in given direction. Hill climbs over vertex adjacency
+ * starting from best of extreme vertices, every local maximum on convex hull is global.
+ */
+de_vec3_t de_convex_hull_get_farthest_point(const de_convex_hull_t* hull, const de_vec3_t* dir);
+
+/**
+ * @brief Intersects ray (in hull space) with hull. Ray is treated as segment from origin to
+ * origin + dir. Writes ray parameters of entry and exit points (entry is negative if origin is inside
+ * of hull, exit is greater than one if end of segment is inside) and normals of faces where ray enters
+ * and exits hull. Returns false if segment misses hull.
+ */
+bool de_convex_hull_ray_intersection(const de_convex_hull_t* hull, const de_ray_t* ray, float* t_enter, float* t_exit, de_vec3_t* enter_normal, de_vec3_t* exit_normal);
+
+/**
+ * @brief Tests. Also compares hill climbing with linear scan of points and prints results into log.
+ */
+void de_convex_hull_tests();
@@ -30,6 +30,8 @@
  */
 
 #define DE_GJK_MAX_ITERATIONS 64	
+#define DE_GJK_DISTANCE_TOLERANCE 0.00001f
+#define DE_GJK_DISTANCE_REL_TOLERANCE 0.0001f
 
 #define DE_EPA_TOLERANCE 0.0001
 #define DE_EPA_MAX_ITERATIONS 64	
@@ -173,26 +175,32 @@ static bool de_gjk_update_tetrahedron_simplex(de_simplex_t* simplex, de_vec3_t *
 	return true;
 }
 
-bool de_gjk_is_intersects(de_convex_shape_t* shape1, const de_vec3_t* shape1_position,
-	de_convex_shape_t* shape2, const de_vec3_t* shape2_position, de_simplex_t* out_simplex)
+/**
+ * @brief GJK itself. search_dir is initial search direction, receives last search direction: if shapes
+ * do not intersect it is separating axis, which is good initial direction for next query on same pair.
+ * When warm_start is true first support point is tested against initial direction, so separation along
+ * cached axis is found with only one support point.
+ */
+static bool de_gjk_solve(const de_convex_shape_t* shape1, const de_vec3_t* shape1_position,
+	const de_convex_shape_t* shape2, const de_vec3_t* shape2_position, de_vec3_t* search_dir, bool warm_start,
+	de_simplex_t* out_simplex, int* out_support_count)
 {
-	/* This is good enough heuristic to choose initial search direction */
-	de_vec3_t search_dir;
-	de_vec3_sub(&search_dir, shape1_position, shape2_position);
+	/* Get initial point for simplex */
+	de_simplex_t simplex;
+	de_gjk_support(&simplex.c, shape1, shape1_position, shape2, shape2_position, search_dir);
+	*out_support_count = 1;
 
-	if (de_vec3_equals(&search_dir, &(de_vec3_t) { 0, 0, 0})) {
-		search_dir.x = 1;
+	if (warm_start && !de_vec3_same_direction(&simplex.c.minkowski_dif, search_dir)) {
+		return false;
 	}
 
-	/* Get initial point for simplex */
-	de_simplex_t simplex;
-	de_gjk_support(&simplex.c, shape1, shape1_position, shape2, shape2_position, &search_dir);
-	de_vec3_negate(&search_dir, &simplex.c.minkowski_dif); //search in direction of origin
+	de_vec3_negate(search_dir, &simplex.c.minkowski_dif); //search in direction of origin
 
 	/* Get second point for a line segment simplex */
-	de_gjk_support(&simplex.b, shape1, shape1_position, shape2, shape2_position, &search_dir);
+	de_gjk_support(&simplex.b, shape1, shape1_position, shape2, shape2_position, search_dir);
+	++*out_support_count;
 
-	if (!de_vec3_same_direction(&simplex.b.minkowski_dif, &search_dir)) {
+	if (!de_vec3_same_direction(&simplex.b.minkowski_dif, search_dir)) {
 		return false;
 	}
 
@@ -206,29 +214,30 @@ bool de_gjk_is_intersects(de_convex_shape_t* shape1, const de_vec3_t* shape1_pos
 	de_vec3_cross(&cb_x_minus_b, &cb, &minus_b);
 
 	/* Search perpendicular to line segment towards origin */
-	de_vec3_cross(&search_dir, &cb_x_minus_b, &cb); 
+	de_vec3_cross(search_dir, &cb_x_minus_b, &cb); 
     /* Origin is on this line segment - fix search direction. */
-	if (de_vec3_equals(&search_dir, &(de_vec3_t) { 0, 0, 0 })) {
+	if (de_vec3_equals(search_dir, &(de_vec3_t) { 0, 0, 0 })) {
         /* perpendicular with x-axis */
-		de_vec3_cross(&search_dir, &cb, &(de_vec3_t) { 1, 0, 0 }); 
-		if (de_vec3_equals(&search_dir, &(de_vec3_t) { 0, 0, 0 })) {
+		de_vec3_cross(search_dir, &cb, &(de_vec3_t) { 1, 0, 0 }); 
+		if (de_vec3_equals(search_dir, &(de_vec3_t) { 0, 0, 0 })) {
 			/* perpendicular with z-axis */
-			de_vec3_cross(&search_dir, &cb, &(de_vec3_t) { 0, 0, -1 }); 
+			de_vec3_cross(search_dir, &cb, &(de_vec3_t) { 0, 0, -1 }); 
 		}
 	}
 
 	simplex.rank = 2;
 	for (int iterations = 0; iterations < DE_GJK_MAX_ITERATIONS; iterations++) {
-		de_gjk_support(&simplex.a, shape1, shape1_position, shape2, shape2_position, &search_dir);
+		de_gjk_support(&simplex.a, shape1, shape1_position, shape2, shape2_position, search_dir);
+		++*out_support_count;
 
-		if (!de_vec3_same_direction(&simplex.a.minkowski_dif, &search_dir)) {
+		if (!de_vec3_same_direction(&simplex.a.minkowski_dif, search_dir)) {
 			return false;
 		}
 
 		simplex.rank++;
 		if (simplex.rank == 3) {
-			de_gjk_update_triangle_simplex(&simplex, &search_dir);
-		} else if (de_gjk_update_tetrahedron_simplex(&simplex, &search_dir)) {
+			de_gjk_update_triangle_simplex(&simplex, search_dir);
+		} else if (de_gjk_update_tetrahedron_simplex(&simplex, search_dir)) {
 			if (out_simplex) {
 				*out_simplex = simplex;
 			}
@@ -240,6 +249,251 @@ bool de_gjk_is_intersects(de_convex_shape_t* shape1, const de_vec3_t* shape1_pos
 	return false;
 }
 
+/**
+ * @brief This is good enough heuristic to choose initial search direction when nothing is known about pair.
+ */
+static de_vec3_t de_gjk_get_initial_search_dir(const de_vec3_t* shape1_position, const de_vec3_t* shape2_position)
+{
+	de_vec3_t search_dir;
+	de_vec3_sub(&search_dir, shape1_position, shape2_position);
+
+	if (de_vec3_equals(&search_dir, &(de_vec3_t) { 0, 0, 0})) {
+		search_dir.x = 1;
+	}
+
+	return search_dir;
+}
+
+bool de_gjk_is_intersects(de_convex_shape_t* shape1, const de_vec3_t* shape1_position,
+	de_convex_shape_t* shape2, const de_vec3_t* shape2_position, de_simplex_t* out_simplex)
+{
+	de_vec3_t search_dir = de_gjk_get_initial_search_dir(shape1_position, shape2_position);
+	int support_count;
+	return de_gjk_solve(shape1, shape1_position, shape2, shape2_position, &search_dir, false, out_simplex, &support_count);
+}
+
+bool de_gjk_is_intersects_ex(de_convex_shape_t* shape1, const de_vec3_t* shape1_position,
+	de_convex_shape_t* shape2, const de_vec3_t* shape2_position, de_vec3_t* cached_search_dir,
+	de_simplex_t* out_simplex, int* out_support_count)
+{
+	const bool warm_start = !de_vec3_equals(cached_search_dir, &(de_vec3_t) { 0, 0, 0 });
+	de_vec3_t search_dir = warm_start ? *cached_search_dir : de_gjk_get_initial_search_dir(shape1_position, shape2_position);
+	int support_count;
+	const bool result = de_gjk_solve(shape1, shape1_position, shape2, shape2_position, &search_dir, warm_start, out_simplex, &support_count);
+	/* Only separating axis is worth to be cached, search for intersection starts over */
+	*cached_search_dir = result ? (de_vec3_t) { 0, 0, 0 } : search_dir;
+	if (out_support_count) {
+		*out_support_count = support_count;
+	}
+	return result;
+}
+
+/* Simplex of distance query, its point closest to origin is sum of lambda[i] * v[i].minkowski_dif */
+typedef struct de_gjk_distance_simplex_t {
+	de_minkowski_vertex_t v[4];
+	float lambda[4];
+	int rank;
+} de_gjk_distance_simplex_t;
+
+static void de_gjk_distance_simplex_keep(de_gjk_distance_simplex_t* simplex, int i0, float l0, int i1, float l1, int i2, float l2)
+{
+	const de_minkowski_vertex_t v[3] = { simplex->v[i0], simplex->v[i1 < 0 ? 0 : i1], simplex->v[i2 < 0 ? 0 : i2] };
+	simplex->v[0] = v[0];
+	simplex->v[1] = v[1];
+	simplex->v[2] = v[2];
+	simplex->lambda[0] = l0;
+	simplex->lambda[1] = l1;
+	simplex->lambda[2] = l2;
+	simplex->rank = i1 < 0 ? 1 : (i2 < 0 ? 2 : 3);
+}
+
+/* reduces segment v[0] v[1] to its feature closest to origin */
+static void de_gjk_distance_reduce_segment(de_gjk_distance_simplex_t* simplex)
+{
+	const de_vec3_t* a = &simplex->v[0].minkowski_dif;
+	const de_vec3_t* b = &simplex->v[1].minkowski_dif;
+	de_vec3_t ab;
+	de_vec3_sub(&ab, b, a);
+	const float sqr_len = de_vec3_sqr_len(&ab);
+	const float t = sqr_len > 0.0f ? -de_vec3_dot(a, &ab) / sqr_len : 0.0f;
+	if (t <= 0.0f) {
+		de_gjk_distance_simplex_keep(simplex, 0, 1.0f, -1, 0.0f, -1, 0.0f);
+	} else if (t >= 1.0f) {
+		de_gjk_distance_simplex_keep(simplex, 1, 1.0f, -1, 0.0f, -1, 0.0f);
+	} else {
+		de_gjk_distance_simplex_keep(simplex, 0, 1.0f - t, 1, t, -1, 0.0f);
+	}
+}
+
+/* reduces triangle v[0] v[1] v[2] to its feature closest to origin, see "Real-Time Collision Detection"
+ * by Christer Ericson, 5.1.5 */
+static void de_gjk_distance_reduce_triangle(de_gjk_distance_simplex_t* simplex)
+{
+	const de_vec3_t* a = &simplex->v[0].minkowski_dif;
+	const de_vec3_t* b = &simplex->v[1].minkowski_dif;
+	const de_vec3_t* c = &simplex->v[2].minkowski_dif;
+	de_vec3_t ab, ac, ao, bo, co;
+	de_vec3_sub(&ab, b, a);
+	de_vec3_sub(&ac, c, a);
+	de_vec3_negate(&ao, a);
+	de_vec3_negate(&bo, b);
+	de_vec3_negate(&co, c);
+
+	const float d1 = de_vec3_dot(&ab, &ao);
+	const float d2 = de_vec3_dot(&ac, &ao);
+	if (d1 <= 0.0f && d2 <= 0.0f) {
+		de_gjk_distance_simplex_keep(simplex, 0, 1.0f, -1, 0.0f, -1, 0.0f);
+		return;
+	}
+	const float d3 = de_vec3_dot(&ab, &bo);
+	const float d4 = de_vec3_dot(&ac, &bo);
+	if (d3 >= 0.0f && d4 <= d3) {
+		de_gjk_distance_simplex_keep(simplex, 1, 1.0f, -1, 0.0f, -1, 0.0f);
+		return;
+	}
+	const float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+		const float v = d1 / (d1 - d3);
+		de_gjk_distance_simplex_keep(simplex, 0, 1.0f - v, 1, v, -1, 0.0f);
+		return;
+	}
+	const float d5 = de_vec3_dot(&ab, &co);
+	const float d6 = de_vec3_dot(&ac, &co);
+	if (d6 >= 0.0f && d5 <= d6) {
+		de_gjk_distance_simplex_keep(simplex, 2, 1.0f, -1, 0.0f, -1, 0.0f);
+		return;
+	}
+	const float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+		const float w = d2 / (d2 - d6);
+		de_gjk_distance_simplex_keep(simplex, 0, 1.0f - w, 2, w, -1, 0.0f);
+		return;
+	}
+	const float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+		const float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+		de_gjk_distance_simplex_keep(simplex, 1, 1.0f - w, 2, w, -1, 0.0f);
+		return;
+	}
+	const float sum = va + vb + vc;
+	if (sum <= 0.0f) {
+		/* degenerate triangle */
+		de_gjk_distance_reduce_segment(simplex);
+		return;
+	}
+	const float v = vb / sum;
+	const float w = vc / sum;
+	de_gjk_distance_simplex_keep(simplex, 0, 1.0f - v - w, 1, v, 2, w);
+}
+
+/* reduces tetrahedron to its face feature closest to origin, returns false if origin is inside */
+static bool de_gjk_distance_reduce_tetrahedron(de_gjk_distance_simplex_t* simplex)
+{
+	static const int faces[4][4] = { { 0, 1, 2, 3 }, { 0, 2, 3, 1 }, { 0, 3, 1, 2 }, { 1, 3, 2, 0 } };
+	de_gjk_distance_simplex_t best = { .rank = 0 };
+	float best_sqr_distance = FLT_MAX;
+	for (int i = 0; i < 4; ++i) {
+		const de_vec3_t* a = &simplex->v[faces[i][0]].minkowski_dif;
+		const de_vec3_t* b = &simplex->v[faces[i][1]].minkowski_dif;
+		const de_vec3_t* c = &simplex->v[faces[i][2]].minkowski_dif;
+		const de_vec3_t* d = &simplex->v[faces[i][3]].minkowski_dif;
+		de_vec3_t ab, ac, n, ad, ao;
+		de_vec3_sub(&ab, b, a);
+		de_vec3_sub(&ac, c, a);
+		de_vec3_cross(&n, &ab, &ac);
+		de_vec3_sub(&ad, d, a);
+		de_vec3_negate(&ao, a);
+		/* face can contain closest point only if origin and opposite vertex are on different sides */
+		if (de_vec3_dot(&ao, &n) * de_vec3_dot(&ad, &n) > 0.0f) {
+			continue;
+		}
+		de_gjk_distance_simplex_t face = {
+			.v = { simplex->v[faces[i][0]], simplex->v[faces[i][1]], simplex->v[faces[i][2]] },
+		};
+		de_gjk_distance_reduce_triangle(&face);
+		de_vec3_t closest = { 0, 0, 0 };
+		for (int k = 0; k < face.rank; ++k) {
+			de_vec3_t weighted;
+			de_vec3_scale(&weighted, &face.v[k].minkowski_dif, face.lambda[k]);
+			de_vec3_add(&closest, &closest, &weighted);
+		}
+		const float sqr_distance = de_vec3_sqr_len(&closest);
+		if (sqr_distance < best_sqr_distance) {
+			best_sqr_distance = sqr_distance;
+			best = face;
+		}
+	}
+	if (!best.rank) {
+		return false;
+	}
+	*simplex = best;
+	return true;
+}
+
+bool de_gjk_get_distance(const de_convex_shape_t* shape1, const de_vec3_t* shape1_position,
+	const de_convex_shape_t* shape2, const de_vec3_t* shape2_position, float* distance,
+	de_vec3_t* direction, de_vec3_t* closest_point)
+{
+	de_gjk_distance_simplex_t simplex = { .lambda = { 1.0f }, .rank = 1 };
+	de_vec3_t search_dir = de_gjk_get_initial_search_dir(shape2_position, shape1_position);
+	de_gjk_support(&simplex.v[0], shape1, shape1_position, shape2, shape2_position, &search_dir);
+	de_vec3_t closest = simplex.v[0].minkowski_dif;
+	float sqr_distance = de_vec3_sqr_len(&closest);
+
+	for (int iterations = 0; iterations < DE_GJK_MAX_ITERATIONS; ++iterations) {
+		if (sqr_distance <= DE_GJK_DISTANCE_TOLERANCE * DE_GJK_DISTANCE_TOLERANCE) {
+			return false;
+		}
+
+		de_vec3_negate(&search_dir, &closest);
+		de_minkowski_vertex_t w;
+		de_gjk_support(&w, shape1, shape1_position, shape2, shape2_position, &search_dir);
+
+		/* New support point is not closer to origin than current closest point - converged. Needs
+		 * relative tolerance, curved shapes are approached asymptotically. */
+		if (sqr_distance - de_vec3_dot(&closest, &w.minkowski_dif) <= DE_GJK_DISTANCE_REL_TOLERANCE * sqr_distance) {
+			break;
+		}
+
+		const de_gjk_distance_simplex_t last_simplex = simplex;
+		simplex.v[simplex.rank++] = w;
+		if (simplex.rank == 2) {
+			de_gjk_distance_reduce_segment(&simplex);
+		} else if (simplex.rank == 3) {
+			de_gjk_distance_reduce_triangle(&simplex);
+		} else if (!de_gjk_distance_reduce_tetrahedron(&simplex)) {
+			return false;
+		}
+
+		de_vec3_t new_closest = { 0, 0, 0 };
+		for (int k = 0; k < simplex.rank; ++k) {
+			de_vec3_t weighted;
+			de_vec3_scale(&weighted, &simplex.v[k].minkowski_dif, simplex.lambda[k]);
+			de_vec3_add(&new_closest, &new_closest, &weighted);
+		}
+		const float new_sqr_distance = de_vec3_sqr_len(&new_closest);
+		if (new_sqr_distance >= sqr_distance) {
+			/* no progress because of round-off errors, previous simplex is as good as it gets */
+			simplex = last_simplex;
+			break;
+		}
+		closest = new_closest;
+		sqr_distance = new_sqr_distance;
+	}
+
+	*distance = sqrtf(sqr_distance);
+	de_vec3_scale(direction, &closest, -1.0f / *distance);
+	/* point of shape B is point of shape A minus minkowski difference */
+	*closest_point = (de_vec3_t) { 0, 0, 0 };
+	for (int k = 0; k < simplex.rank; ++k) {
+		de_vec3_t b;
+		de_vec3_sub(&b, &simplex.v[k].shape_a_world_space, &simplex.v[k].minkowski_dif);
+		de_vec3_scale(&b, &b, simplex.lambda[k]);
+		de_vec3_add(closest_point, closest_point, &b);
+	}
+	return true;
+}
+
 static bool de_polytope_edge_eq_ccw(const de_polytope_edge_t* a, const de_polytope_edge_t* b)
 {
 	return de_vec3_equals(&a->end.minkowski_dif, &b->begin.minkowski_dif)
@@ -493,7 +747,10 @@ bool de_epa_get_penetration_info(de_simplex_t* simplex, de_convex_shape_t* shape
 			de_vec3_sub(&begin_to_point, &loose_edge->begin.minkowski_dif, &new_point.minkowski_dif);
 
 			de_vec3_cross(&new_triangle->normal, &edge_vector, &begin_to_point);
-			de_vec3_normalize(&new_triangle->normal, &new_triangle->normal);
+			if (!de_vec3_try_normalize(&new_triangle->normal, &new_triangle->normal)) {
+				/* New point lies on line of edge, such triangle has no area and adds nothing */
+				continue;
+			}
 			
 			/* Check for wrong normal to maintain CCW winding */
 			const float bias = 2 * FLT_EPSILON;
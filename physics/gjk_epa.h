@@ -45,5 +45,24 @@ typedef struct de_simplex_t {
 bool de_gjk_is_intersects(de_convex_shape_t* shape1, const de_vec3_t* shape1_position,
 	de_convex_shape_t* shape2, const de_vec3_t* shape2_position, de_simplex_t* out_simplex);
 
+/**
+ * @brief Same as de_gjk_is_intersects, but warm-started: cached_search_dir is initial search direction
+ * (zero - use default heuristic) and receives separating axis if shapes do not intersect (zero otherwise).
+ * Pair which stays separated is rejected with one support point next time. out_support_count (can be
+ * NULL) receives amount of support points evaluated.
+ */
+bool de_gjk_is_intersects_ex(de_convex_shape_t* shape1, const de_vec3_t* shape1_position,
+	de_convex_shape_t* shape2, const de_vec3_t* shape2_position, de_vec3_t* cached_search_dir,
+	de_simplex_t* out_simplex, int* out_support_count);
+
+/**
+ * @brief Distance query: finds closest points of separated shapes. Returns false if shapes intersect
+ * (or touch). Otherwise writes distance between shapes, unit direction from shape1 to shape2 along
+ * shortest distance and point of shape2 closest to shape1.
+ */
+bool de_gjk_get_distance(const de_convex_shape_t* shape1, const de_vec3_t* shape1_position,
+	const de_convex_shape_t* shape2, const de_vec3_t* shape2_position, float* distance,
+	de_vec3_t* direction, de_vec3_t* closest_point);
+
 bool de_epa_get_penetration_info(de_simplex_t* simplex, de_convex_shape_t* shape1, const de_vec3_t* shape1_position,
 	de_convex_shape_t* shape2, const de_vec3_t* shape2_position, de_vec3_t* penetration_vector, de_vec3_t* contact_point);
\ No newline at end of file
@@ -20,7 +20,10 @@
 * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
 
 #include "physics/octree.c"
+#include "physics/bvh.c"
+#include "physics/convex_hull.c"
 #include "physics/shape.c"
 #include "physics/body.c"
+#include "physics/broadphase.c"
 #include "physics/collision.c"
 #include "physics/gjk_epa.c"
\ No newline at end of file
@@ -22,6 +22,14 @@
 #define DE_MAX_CONTACTS (8)
 #define DE_AIR_FRICTION (0.01f)
 #define DE_DEFAULT_GRAVITY (de_vec3_t) { 0.0f, -9.81f, 0.0f }
+/* Body falls asleep when its displacement per step stays below this distance for DE_BODY_SLEEP_STEP_COUNT steps */
+#define DE_BODY_SLEEP_DISTANCE (0.001f)
+#define DE_BODY_SLEEP_STEP_COUNT (60)
+/* Amount of pairs of body with triangles and other bodies whose GJK search directions are kept between steps */
+#define DE_BODY_CONTACT_CACHE_SIZE (16)
+/* Radius of sphere swept by CCD relative to radius of sphere inscribed in shape. Smaller sphere does not
+ * touch surfaces body rests on, so only penetration deeper than discrete collision can resolve stops body */
+#define DE_BODY_CCD_RADIUS_FRACTION (0.5f)
 
 /**
 * @class de_contact_t
@@ -35,8 +43,38 @@ typedef struct de_contact_t {
 	de_static_geometry_t* geometry;
 } de_contact_t;
 
+/**
+ * @brief Statistics of last physics step of scene.
+ */
+typedef struct de_physics_stats_t {
+	size_t body_count;
+	size_t sleeping_count; /**< Bodies which were skipped by integration and collision with static geometry. */
+	size_t static_test_count; /**< Narrowphase tests of bodies with triangles of static geometry. */
+	size_t ccd_count; /**< Bodies swept by continuous collision detection, see de_body_set_ccd_enabled. */
+	size_t pair_count; /**< Unique pairs of bodies with overlapping bounds found by broadphase. */
+	size_t collision_count; /**< Pairs that actually collided in narrowphase. */
+	size_t batch_count; /**< Batches of independent pairs resolved one after another. */
+	size_t gjk_support_count; /**< Support points evaluated by GJK in all narrowphase tests, see de_contact_cache_entry_t. */
+	double static_time; /**< Time of integration and collision with static geometry in seconds. */
+	double broadphase_time; /**< Time in seconds. */
+	double narrowphase_time; /**< Time of body-body narrowphase in seconds. */
+} de_physics_stats_t;
+
+/**
+ * @brief Fixed timestep scheduler of scene physics, see de_physics_set_fixed_step.
+ */
+typedef struct de_physics_clock_t {
+	double step; /**< Duration of one physics step in seconds. Zero - one step per frame with frame delta. */
+	int max_steps_per_frame; /**< Time which needs more steps is dropped, so slow frames do not snowball. */
+	double accumulator; /**< Time not yet simulated, always less than step. */
+	int last_frame_step_count; /**< Amount of steps done during last frame. */
+} de_physics_clock_t;
+
 #include "physics/octree.h"
+#include "physics/bvh.h"
+#include "physics/convex_hull.h"
 #include "physics/shape.h"
 #include "physics/body.h"
+#include "physics/broadphase.h"
 #include "physics/collision.h"
 #include "physics/gjk_epa.h"
\ No newline at end of file
@@ -64,7 +64,19 @@ de_vec3_t de_convex_shape_get_farthest_point(const de_convex_shape_t* shape, con
 		case DE_CONVEX_SHAPE_TYPE_POINT_CLOUD: {
 			const de_point_cloud_shape_t* point_cloud = &shape->s.point_cloud;
 
-			farthest = de_point_cloud_get_farthest_point(point_cloud->points.data, point_cloud->points.size, dir);
+			if (point_cloud->hull.vertices.size) {
+				farthest = de_convex_hull_get_farthest_point(&point_cloud->hull, dir);
+			} else {
+				farthest = de_point_cloud_get_farthest_point(point_cloud->points.data, point_cloud->points.size, dir);
+			}
+
+			break;
+		}
+		case DE_CONVEX_SHAPE_TYPE_TRIANGLE_MESH: {
+			/* only used for bounds and ray cast, narrowphase works with separate triangles */
+			const de_triangle_mesh_shape_t* mesh = &shape->s.triangle_mesh;
+
+			farthest = de_point_cloud_get_farthest_point(mesh->vertices.data, mesh->vertices.size, dir);
 
 			break;
 		}
@@ -127,6 +139,46 @@ de_vec3_t de_convex_shape_get_farthest_point(const de_convex_shape_t* shape, con
 	return farthest;
 }
 
+void de_convex_shape_get_aabb(const de_convex_shape_t* shape, const de_vec3_t* position, de_vec3_t* min, de_vec3_t* max)
+{
+	if (shape->type == DE_CONVEX_SHAPE_TYPE_SPHERE) {
+		const float radius = shape->s.sphere.radius;
+		*min = (de_vec3_t) { position->x - radius, position->y - radius, position->z - radius };
+		*max = (de_vec3_t) { position->x + radius, position->y + radius, position->z + radius };
+	} else if (shape->type == DE_CONVEX_SHAPE_TYPE_TRIANGLE_MESH && shape->s.triangle_mesh.bvh.node_count) {
+		/* root of bvh already bounds whole mesh */
+		const de_bvh_node_t* root = &shape->s.triangle_mesh.bvh.nodes[0];
+		de_vec3_add(min, &root->min, position);
+		de_vec3_add(max, &root->max, position);
+	} else {
+		/* support points along each axis give exact bounds of any convex shape */
+		min->x = de_convex_shape_get_farthest_point(shape, position, &(de_vec3_t) { -1.0f, 0.0f, 0.0f }).x;
+		min->y = de_convex_shape_get_farthest_point(shape, position, &(de_vec3_t) { 0.0f, -1.0f, 0.0f }).y;
+		min->z = de_convex_shape_get_farthest_point(shape, position, &(de_vec3_t) { 0.0f, 0.0f, -1.0f }).z;
+		max->x = de_convex_shape_get_farthest_point(shape, position, &(de_vec3_t) { 1.0f, 0.0f, 0.0f }).x;
+		max->y = de_convex_shape_get_farthest_point(shape, position, &(de_vec3_t) { 0.0f, 1.0f, 0.0f }).y;
+		max->z = de_convex_shape_get_farthest_point(shape, position, &(de_vec3_t) { 0.0f, 0.0f, 1.0f }).z;
+	}
+}
+
+float de_convex_shape_get_inscribed_radius(const de_convex_shape_t* shape)
+{
+	switch (shape->type) {
+		case DE_CONVEX_SHAPE_TYPE_SPHERE:
+			return shape->s.sphere.radius;
+		case DE_CONVEX_SHAPE_TYPE_CAPSULE:
+			return shape->s.capsule.radius;
+		case DE_CONVEX_SHAPE_TYPE_BOX: {
+			const de_vec3_t* e = &shape->s.box.half_extents;
+			const float yz = e->y < e->z ? e->y : e->z;
+			return e->x < yz ? e->x : yz;
+		}
+		default:
+			/* triangles and point clouds may not even contain their origin */
+			return 0.0f;
+	}
+}
+
 static void de_capsule_shape_set_dimensions(de_capsule_shape_t* capsule, de_axis_t axis, float radius, float height)
 {
 	switch (axis) {
@@ -182,19 +234,78 @@ de_convex_shape_t de_convex_shape_create_sphere(float radius)
 
 de_convex_shape_t de_convex_shape_create_point_cloud(de_point_cloud_point_array_t points)
 {
-	const de_convex_shape_t shape = {
-		.type = DE_CONVEX_SHAPE_TYPE_SPHERE,
+	de_convex_shape_t shape = {
+		.type = DE_CONVEX_SHAPE_TYPE_POINT_CLOUD,
 		.s.point_cloud = (de_point_cloud_shape_t) { .points = points }
 	};
 
+	de_convex_hull_build(&shape.s.point_cloud.hull, points.data, points.size);
+
 	return shape;
 }
 
+/* rebuilds bvh and reorders vertices so each leaf references continuous range of triangles */
+static void de_triangle_mesh_shape_build(de_triangle_mesh_shape_t* mesh)
+{
+	const size_t triangle_count = mesh->vertices.size / 3;
+	de_bvh_free(&mesh->bvh);
+	if (!triangle_count) {
+		return;
+	}
+	uint32_t* order = de_malloc(triangle_count * sizeof(*order));
+	de_bvh_build(&mesh->bvh, NULL, mesh->vertices.data, triangle_count, 3 * sizeof(de_vec3_t), 8, order);
+	de_vec3_t* vertices = de_malloc(triangle_count * 3 * sizeof(*vertices));
+	for (size_t i = 0; i < triangle_count; ++i) {
+		memcpy(&vertices[i * 3], &mesh->vertices.data[order[i] * 3], 3 * sizeof(*vertices));
+	}
+	memcpy(mesh->vertices.data, vertices, triangle_count * 3 * sizeof(*vertices));
+	de_free(vertices);
+	de_free(order);
+}
+
+de_convex_shape_t de_convex_shape_create_triangle_mesh(de_point_cloud_point_array_t vertices)
+{
+	DE_ASSERT(vertices.size % 3 == 0);
+
+	de_convex_shape_t shape = {
+		.type = DE_CONVEX_SHAPE_TYPE_TRIANGLE_MESH,
+		.s.triangle_mesh = (de_triangle_mesh_shape_t) { .vertices = vertices }
+	};
+
+	de_triangle_mesh_shape_build(&shape.s.triangle_mesh);
+
+	return shape;
+}
+
+de_convex_shape_t de_convex_shape_copy(const de_convex_shape_t* shape)
+{
+	if (shape->type == DE_CONVEX_SHAPE_TYPE_POINT_CLOUD) {
+		/* Point cloud is special becuase it contains heap-allocated memory which we
+		 * must copy, not share between multiple shapes to prevent double free. */
+		de_point_cloud_point_array_t points;
+		DE_ARRAY_INIT(points);
+		DE_ARRAY_COPY(shape->s.point_cloud.points, points);
+		return de_convex_shape_create_point_cloud(points);
+	} else if (shape->type == DE_CONVEX_SHAPE_TYPE_TRIANGLE_MESH) {
+		de_point_cloud_point_array_t vertices;
+		DE_ARRAY_INIT(vertices);
+		DE_ARRAY_COPY(shape->s.triangle_mesh.vertices, vertices);
+		return de_convex_shape_create_triangle_mesh(vertices);
+	}
+	/* In other cases we can make byte-to-byte copy */
+	return *shape;
+}
+
 void de_convex_shape_free(de_convex_shape_t* shape)
 {
 	if (shape->type == DE_CONVEX_SHAPE_TYPE_POINT_CLOUD) {
 		de_point_cloud_shape_t* point_cloud = &shape->s.point_cloud;
 		DE_ARRAY_FREE(point_cloud->points);
+		de_convex_hull_free(&point_cloud->hull);
+	} else if (shape->type == DE_CONVEX_SHAPE_TYPE_TRIANGLE_MESH) {
+		de_triangle_mesh_shape_t* mesh = &shape->s.triangle_mesh;
+		DE_ARRAY_FREE(mesh->vertices);
+		de_bvh_free(&mesh->bvh);
 	}
 }
 
@@ -237,6 +348,21 @@ bool de_convex_shape_visit(de_object_visitor_t* visitor, de_convex_shape_t* shap
 		case DE_CONVEX_SHAPE_TYPE_POINT_CLOUD: {
 			de_point_cloud_shape_t* point_cloud = &shape->s.point_cloud;
 			result &= DE_OBJECT_VISITOR_VISIT_PRIMITIVE_ARRAY(visitor, "Points", point_cloud->points);
+
+			/* Rebuild hull on read. */
+			if (visitor->is_reading) {
+				de_convex_hull_build(&point_cloud->hull, point_cloud->points.data, point_cloud->points.size);
+			}
+			break;
+		}
+		case DE_CONVEX_SHAPE_TYPE_TRIANGLE_MESH: {
+			de_triangle_mesh_shape_t* mesh = &shape->s.triangle_mesh;
+			result &= DE_OBJECT_VISITOR_VISIT_PRIMITIVE_ARRAY(visitor, "Vertices", mesh->vertices);
+
+			/* Rebuild BVH on read. */
+			if (visitor->is_reading) {
+				de_triangle_mesh_shape_build(mesh);
+			}
 			break;
 		}
 		default:
@@ -348,4 +474,10 @@ de_point_cloud_shape_t* de_convex_shape_to_point_cloud(de_convex_shape_t* convex
 {
 	DE_ASSERT(convex_shape->type == DE_CONVEX_SHAPE_TYPE_POINT_CLOUD);
 	return &convex_shape->s.point_cloud;
+}
+
+de_triangle_mesh_shape_t* de_convex_shape_to_triangle_mesh(de_convex_shape_t* convex_shape)
+{
+	DE_ASSERT(convex_shape->type == DE_CONVEX_SHAPE_TYPE_TRIANGLE_MESH);
+	return &convex_shape->s.triangle_mesh;
 }
\ No newline at end of file
@@ -28,7 +28,8 @@ typedef enum de_convex_shape_type_t {
 	DE_CONVEX_SHAPE_TYPE_SPHERE,
 	DE_CONVEX_SHAPE_TYPE_CAPSULE,
 	DE_CONVEX_SHAPE_TYPE_TRIANGLE,	
-	DE_CONVEX_SHAPE_TYPE_POINT_CLOUD
+	DE_CONVEX_SHAPE_TYPE_POINT_CLOUD,
+	DE_CONVEX_SHAPE_TYPE_TRIANGLE_MESH
 } de_convex_shape_type_t;
 
 typedef struct de_sphere_shape_t {
@@ -47,8 +48,21 @@ typedef DE_ARRAY_DECLARE(de_vec3_t, de_point_cloud_point_array_t);
 
 typedef struct de_point_cloud_shape_t {
 	de_point_cloud_point_array_t points;
+	/* Non-serializable. Built from points in runtime, empty if points do not span volume. */
+	de_convex_hull_t hull;
 } de_point_cloud_shape_t;
 
+/**
+ * @brief Triangle mesh of kinematic body (moving platform, elevator, etc.). Not convex, so it can't be
+ * used in GJK directly: each triangle of mesh collides with other body separately. Triangles are
+ * stored in local space of body together with BVH, so moving body does not require BVH rebuild.
+ */
+typedef struct de_triangle_mesh_shape_t {
+	de_point_cloud_point_array_t vertices; /**< Three vertices per triangle, in order of BVH leaves. */
+	/* Non-serializable. Built from vertices in runtime. */
+	de_bvh_t bvh;
+} de_triangle_mesh_shape_t;
+
 typedef enum de_axis_t {
 	DE_AXIS_X = 0,
 	DE_AXIS_Y = 1,
@@ -76,6 +90,7 @@ typedef struct de_convex_shape_t {
 		de_capsule_shape_t capsule;
 		de_triangle_shape_t triangle;
 		de_point_cloud_shape_t point_cloud;
+		de_triangle_mesh_shape_t triangle_mesh;
 	} s;
 } de_convex_shape_t;
 
@@ -96,11 +111,35 @@ de_convex_shape_t de_convex_shape_create_sphere(float radius);
  */
 de_convex_shape_t de_convex_shape_create_point_cloud(de_point_cloud_point_array_t points);
 
+/**
+ * @brief Creates triangle mesh shape, each three vertices form triangle in local space of body. Takes
+ * ownership of vertices array! Vertices are reordered to match order of BVH leaves. Body with such
+ * shape is kinematic: it is not affected by gravity and static geometry, other bodies are pushed
+ * out of it, but it is never pushed by them.
+ */
+de_convex_shape_t de_convex_shape_create_triangle_mesh(de_point_cloud_point_array_t vertices);
+
+/**
+ * @brief Makes deep copy of shape, point cloud and triangle mesh get their own arrays.
+ */
+de_convex_shape_t de_convex_shape_copy(const de_convex_shape_t* shape);
+
 /**
  * @brief Returns farthest point in given direction. 
  */
 de_vec3_t de_convex_shape_get_farthest_point(const de_convex_shape_t* shape, const de_vec3_t* position, const de_vec3_t* dir);
 
+/**
+ * @brief Calculates axis-aligned bounding box of shape at given position.
+ */
+void de_convex_shape_get_aabb(const de_convex_shape_t* shape, const de_vec3_t* position, de_vec3_t* min, de_vec3_t* max);
+
+/**
+ * @brief Returns radius of sphere centered at shape origin which lies completely inside shape. Zero for
+ * triangles, point clouds and triangle meshes.
+ */
+float de_convex_shape_get_inscribed_radius(const de_convex_shape_t* shape);
+
 float de_capsule_shape_get_radius(const de_capsule_shape_t* capsule);
 
 void de_capsule_shape_set_radius(de_capsule_shape_t* capsule, float radius);
@@ -123,6 +162,8 @@ de_sphere_shape_t* de_convex_shape_to_sphere(de_convex_shape_t* convex_shape);
 
 de_point_cloud_shape_t* de_convex_shape_to_point_cloud(de_convex_shape_t* convex_shape);
 
+de_triangle_mesh_shape_t* de_convex_shape_to_triangle_mesh(de_convex_shape_t* convex_shape);
+
 void de_convex_shape_free(de_convex_shape_t* shape);
 
 bool de_convex_shape_visit(de_object_visitor_t* visitor, de_convex_shape_t* shape);
@@ -262,11 +262,9 @@ void de_animation_add_track(de_animation_t* anim, de_animation_track_t* track)
 	DE_ARRAY_APPEND(anim->tracks, track);
 }
 
-void de_animation_update(de_animation_t* anim, float dt)
-{	
-	float nextTimePos = anim->time_position + dt * anim->speed;
-
-	for (size_t i = 0; i < anim->tracks.size; ++i) {
+void de_animation_sample_tracks(de_animation_t* anim, size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; ++i) {
 		de_animation_track_t* track;
 		de_keyframe_t keyframe;
 		de_node_t* node;
@@ -292,8 +290,13 @@ void de_animation_update(de_animation_t* anim, float dt)
 		node->scale.y *= keyframe.scale.y;
 		node->scale.z *= keyframe.scale.z;
 
-		node->transform_flags |= DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE;
+		de_node_set_transform_flags(node, DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE);
 	}
+}
+
+void de_animation_advance(de_animation_t* anim, float dt)
+{
+	float nextTimePos = anim->time_position + dt * anim->speed;
 
 	de_animation_set_time_position(anim, nextTimePos);
 
@@ -311,6 +314,12 @@ void de_animation_update(de_animation_t* anim, float dt)
 	}
 }
 
+void de_animation_update(de_animation_t* anim, float dt)
+{	
+	de_animation_sample_tracks(anim, 0, anim->tracks.size);
+	de_animation_advance(anim, dt);
+}
+
 void de_animation_set_time_position(de_animation_t* anim, float time)
 {
 	if (anim->flags & DE_ANIMATION_FLAG_LOOPED) {
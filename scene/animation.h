@@ -137,6 +137,18 @@ de_animation_t* de_animation_copy(de_animation_t* anim, de_scene_t* dest_scene);
  */
 void de_animation_update(de_animation_t* anim, float dt);
 
+/**
+ * @brief Internal. Accumulates keyframes of tracks in range [begin; end) at current time position
+ * into their nodes. Every track of animation animates its own node, so different ranges can be
+ * sampled in parallel.
+ */
+void de_animation_sample_tracks(de_animation_t* anim, size_t begin, size_t end);
+
+/**
+ * @brief Internal. Advances time position and fading of animation. Called after tracks are sampled.
+ */
+void de_animation_advance(de_animation_t* anim, float dt);
+
 /**
  * @brief Sets current time position of animation.
  */
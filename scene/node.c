@@ -145,6 +145,7 @@ de_node_t* de_node_create(de_scene_t* scene, de_node_type_t type)
 	node->dispatch_table = de_node_get_dispatch_table_by_type(type);
 	node->type = type;
 	node->scene = scene;
+	node->transform_slot = DE_NODE_NO_SLOT;
 	de_node_invalidate_transforms(node);
 	de_mat4_identity(&node->global_matrix);
 	de_mat4_identity(&node->local_matrix);
@@ -186,6 +187,7 @@ static de_node_t* de_node_copy_internal(de_scene_t* dest_scene, de_node_t* node)
 	copy->scaling_offset = node->scaling_offset;
 	copy->scaling_pivot = node->scaling_pivot;
 	copy->bounding_box = node->bounding_box;
+	copy->transform_slot = DE_NODE_NO_SLOT;
 	de_node_invalidate_transforms(copy);
 	copy->parent = NULL;
 	copy->local_visibility = node->local_visibility;
@@ -272,6 +274,8 @@ void de_node_resolve(de_node_t* node)
 		if (!info->custom_scaling_pivot) {
 			node->scaling_pivot = original->scaling_pivot;
 		}
+
+		de_node_invalidate_transforms(node);
 	}
 
 	/* Type-specific resolve */
@@ -297,7 +301,10 @@ void de_node_attach(de_node_t* node, de_node_t* parent)
 	de_node_detach(node);
 	DE_ARRAY_APPEND(parent->children, node);
 	node->parent = parent;
-	node->transform_flags |= DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE;
+	if (node->scene) {
+		de_scene_invalidate_transform_hierarchy(node->scene);
+	}
+	de_node_set_transform_flags(node, DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE);
 }
 
 void de_node_detach(de_node_t* node)
@@ -305,7 +312,10 @@ void de_node_detach(de_node_t* node)
 	if (node->parent) {
 		DE_ARRAY_REMOVE(node->parent->children, node);
 		node->parent = NULL;
-		node->transform_flags |= DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE;
+		if (node->scene) {
+			de_scene_invalidate_transform_hierarchy(node->scene);
+		}
+		de_node_set_transform_flags(node, DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE);
 	}
 }
 
@@ -334,72 +344,107 @@ de_node_t* de_node_get_previous(de_node_t* node)
 	return node->prev;
 }
 
+#define DE_NODE_FBX_TRANSFORM_FLAGS ( \
+	DE_TRANSFORM_FLAGS_ROTATION_PIVOT_NEED_UPDATE | \
+	DE_TRANSFORM_FLAGS_SCALE_PIVOT_NEED_UPDATE | \
+	DE_TRANSFORM_FLAGS_POST_ROTATION_NEED_UPDATE | \
+	DE_TRANSFORM_FLAGS_PRE_ROTATION_NEED_UPDATE | \
+	DE_TRANSFORM_FLAGS_SCALING_OFFSET_NEED_UPDATE)
+
+static bool de_node_is_identity_rotation(const de_quat_t* q)
+{
+	return q->x == 0.0f && q->y == 0.0f && q->z == 0.0f && q->w == 1.0f;
+}
+
+static bool de_node_is_zero_offset(const de_vec3_t* v)
+{
+	return v->x == 0.0f && v->y == 0.0f && v->z == 0.0f;
+}
+
+/**
+ * @brief Folds constant FBX components into pre- and post-rotation matrices. Pivots and offsets are
+ * translations, so no matrix inverse is needed.
+ */
+static void de_node_fold_fbx_transform(de_node_t* node)
+{
+	node->simple_transform =
+		de_node_is_identity_rotation(&node->pre_rotation) &&
+		de_node_is_identity_rotation(&node->post_rotation) &&
+		de_node_is_zero_offset(&node->rotation_pivot) &&
+		de_node_is_zero_offset(&node->scaling_offset) &&
+		de_node_is_zero_offset(&node->scaling_pivot);
+	if (node->simple_transform) {
+		return;
+	}
+
+	/* Rp * Rpre */
+	de_mat4_rotation(&node->m_pre_rotation, &node->pre_rotation);
+	node->m_pre_rotation.f[12] = node->rotation_pivot.x;
+	node->m_pre_rotation.f[13] = node->rotation_pivot.y;
+	node->m_pre_rotation.f[14] = node->rotation_pivot.z;
+
+	/* Rpost^-1 * translation(Soff + Sp - Rp), inverse of rotation is rotation by conjugated quaternion */
+	const de_quat_t inv_post_rotation = { -node->post_rotation.x, -node->post_rotation.y, -node->post_rotation.z, node->post_rotation.w };
+	de_mat4_rotation(&node->m_post_rotation, &inv_post_rotation);
+	de_vec3_t offset;
+	de_vec3_add(&offset, &node->scaling_offset, &node->scaling_pivot);
+	de_vec3_sub(&offset, &offset, &node->rotation_pivot);
+	de_vec3_transform_normal(&offset, &offset, &node->m_post_rotation);
+	node->m_post_rotation.f[12] = offset.x;
+	node->m_post_rotation.f[13] = offset.y;
+	node->m_post_rotation.f[14] = offset.z;
+}
+
 void de_node_calculate_local_transform(de_node_t* node)
 {
 	if (node->body) {
-		de_body_get_position(node->body, &node->position);
+		de_body_get_interpolated_position(node->body, de_physics_get_interpolation_factor(node->scene), &node->position);
 	}
 
 	/**
-	* TODO: Why there is so much matrices? Because of FBX support.
+	* Why there is so much matrices? Because of FBX support.
 	* FBX uses very complex transformations and there is no way (in my opinion)
 	* to convert these to just three parameters:
 	*  - translation
 	*  - rotation quaternion
 	*  - scale
-	* So to exclude weird transformations behaviour when using FBX, I just decided
-	* to use all these matrices. This is not optimized at all, for example 70% of
-	* these multiplications and matrices creation can be done only once on load.
+	* Full chain is T * Roff * Rp * Rpre * R * Rpost^-1 * Rp^-1 * Soff * Sp * S * Sp^-1,
+	* everything except T, R and S is constant during gameplay, so it is folded into
+	* two matrices when changed. Most nodes do not use FBX components at all and
+	* get their matrix directly from translation, rotation and scale.
 	*/
 
-	if (node->transform_flags & DE_TRANSFORM_FLAGS_POST_ROTATION_NEED_UPDATE) {
-		de_mat4_rotation(&node->m_post_rotation, &node->post_rotation);
-		de_mat4_inverse(&node->m_post_rotation, &node->m_post_rotation);
-		node->transform_flags &= ~DE_TRANSFORM_FLAGS_POST_ROTATION_NEED_UPDATE;
-	}
-
-	if (node->transform_flags & DE_TRANSFORM_FLAGS_ROTATION_PIVOT_NEED_UPDATE) {
-		de_mat4_translation(&node->m_rotation_pivot, &node->rotation_pivot);
-		de_mat4_inverse(&node->m_rotation_pivot_inv, &node->m_rotation_pivot);
-		node->transform_flags &= ~DE_TRANSFORM_FLAGS_ROTATION_PIVOT_NEED_UPDATE;
-	}
-
-	if (node->transform_flags & DE_TRANSFORM_FLAGS_SCALE_PIVOT_NEED_UPDATE) {
-		de_mat4_translation(&node->m_scale_pivot, &node->scaling_pivot);
-		de_mat4_inverse(&node->m_scale_pivot_inv, &node->m_scale_pivot);
-		node->transform_flags &= ~DE_TRANSFORM_FLAGS_SCALE_PIVOT_NEED_UPDATE;
+	if (node->transform_flags & DE_NODE_FBX_TRANSFORM_FLAGS) {
+		de_node_fold_fbx_transform(node);
+		node->transform_flags &= ~DE_NODE_FBX_TRANSFORM_FLAGS;
 	}
 
 	if (node->body || (node->transform_flags & DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE)) {
-		de_mat4_t pre_rotation;
-		de_mat4_rotation(&pre_rotation, &node->pre_rotation);
-
-		de_mat4_t rotation;
-		de_mat4_rotation(&rotation, &node->rotation);
-
-		de_mat4_t scale;
-		de_mat4_scale(&scale, &node->scale);
-
-		de_mat4_t translation;
-		de_mat4_translation(&translation, &node->position);
-
-		de_mat4_t rotation_offset;
-		de_mat4_translation(&rotation_offset, &node->rotation_offset);
-
-		de_mat4_t scale_offset;
-		de_mat4_translation(&scale_offset, &node->scaling_offset);
-
-		de_mat4_mul(&node->local_matrix, &translation, &rotation_offset);
-		de_mat4_mul(&node->local_matrix, &node->local_matrix, &node->m_rotation_pivot);
-		de_mat4_mul(&node->local_matrix, &node->local_matrix, &pre_rotation);
-		de_mat4_mul(&node->local_matrix, &node->local_matrix, &rotation);
-		de_mat4_mul(&node->local_matrix, &node->local_matrix, &node->m_post_rotation);
-		de_mat4_mul(&node->local_matrix, &node->local_matrix, &node->m_rotation_pivot_inv);
-		de_mat4_mul(&node->local_matrix, &node->local_matrix, &scale_offset);
-		de_mat4_mul(&node->local_matrix, &node->local_matrix, &node->m_scale_pivot);
-		de_mat4_mul(&node->local_matrix, &node->local_matrix, &scale);
-		de_mat4_mul(&node->local_matrix, &node->local_matrix, &node->m_scale_pivot_inv);
+		de_vec3_t translation;
+		de_vec3_add(&translation, &node->position, &node->rotation_offset);
+		if (node->simple_transform) {
+			de_mat4_trs(&node->local_matrix, &translation, &node->rotation, &node->scale);
+		} else {
+			de_mat4_t rotation;
+			de_mat4_rotation(&rotation, &node->rotation);
+
+			/* scale followed by inverse of scaling pivot */
+			de_mat4_t scale;
+			de_mat4_scale(&scale, &node->scale);
+			scale.f[12] = -node->scale.x * node->scaling_pivot.x;
+			scale.f[13] = -node->scale.y * node->scaling_pivot.y;
+			scale.f[14] = -node->scale.z * node->scaling_pivot.z;
+
+			de_mat4_mul(&node->local_matrix, &node->m_pre_rotation, &rotation);
+			de_mat4_mul(&node->local_matrix, &node->local_matrix, &node->m_post_rotation);
+			de_mat4_mul(&node->local_matrix, &node->local_matrix, &scale);
+			node->local_matrix.f[12] += translation.x;
+			node->local_matrix.f[13] += translation.y;
+			node->local_matrix.f[14] += translation.z;
+		}
 		node->transform_flags &= ~DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE;
+		/* global transform is recalculated by scene update even if this one was called directly */
+		node->transform_flags |= DE_TRANSFORM_FLAGS_GLOBAL_TRANSFORM_NEED_UPDATE;
 	}
 }
 
@@ -483,7 +528,7 @@ void de_node_set_local_position(de_node_t* node, const de_vec3_t* pos)
 	} else {
 		node->position = *pos;
 	}
-	node->transform_flags |= DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE;
+	de_node_set_transform_flags(node, DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE);
 }
 
 void de_node_set_body(de_node_t* node, de_body_t* body)
@@ -497,7 +542,7 @@ void de_node_move(de_node_t* node, de_vec3_t* offset)
 	DE_ASSERT(node);
 	DE_ASSERT(offset);
 	de_vec3_add(&node->position, &node->position, offset);
-	node->transform_flags |= DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE;
+	de_node_set_transform_flags(node, DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE);
 }
 
 void de_node_set_local_rotation(de_node_t* node, de_quat_t* rot)
@@ -505,7 +550,7 @@ void de_node_set_local_rotation(de_node_t* node, de_quat_t* rot)
 	DE_ASSERT(node);
 	DE_ASSERT(rot);
 	node->rotation = *rot;
-	node->transform_flags |= DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE;
+	de_node_set_transform_flags(node, DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE);
 }
 
 void de_node_set_local_scale(de_node_t* node, de_vec3_t* scl)
@@ -513,26 +558,63 @@ void de_node_set_local_scale(de_node_t* node, de_vec3_t* scl)
 	DE_ASSERT(node);
 	DE_ASSERT(scl);
 	node->scale = *scl;
-	node->transform_flags |= DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE;
+	de_node_set_transform_flags(node, DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE);
+}
+
+static de_node_t* de_node_find_recursive(de_node_t* node, const char* name)
+{
+	if (de_str8_eq(&node->name, name)) {
+		return node;
+	}
+	for (size_t i = 0; i < node->children.size; ++i) {
+		de_node_t* result = de_node_find_recursive(node->children.data[i], name);
+		if (result) {
+			return result;
+		}
+	}
+	return NULL;
 }
 
 de_node_t* de_node_find(de_node_t* node, const char* name)
 {
 	DE_ASSERT(node);
-	if (node) {
-		if (de_str8_eq(&node->name, name)) {
-			return node;
-		} else {
-			for (size_t i = 0; i < node->children.size; ++i) {
-				de_node_t* child = node->children.data[i];
-				de_node_t* result = de_node_find(child, name);
-				if (result) {
-					return result;
-				}
-			}
+	if (!node->scene) {
+		return de_node_find_recursive(node, name);
+	}
+	/* Scene may have many nodes with this name (instances of same model) while tree is small, or vice
+	 * versa. So one candidate of index and one node of tree are checked per iteration until either is
+	 * done, both give node that got this name first. */
+	de_node_t* candidate = de_scene_find_node(node->scene, name);
+	de_node_t* first = NULL;
+	de_node_t* result = NULL;
+	DE_ARRAY_DECLARE(de_node_t*, stack);
+	DE_ARRAY_INIT(stack);
+	DE_ARRAY_APPEND(stack, node);
+	while (candidate) {
+		de_node_t* ancestor = candidate;
+		while (ancestor && ancestor != node) {
+			ancestor = ancestor->parent;
+		}
+		if (ancestor) {
+			result = candidate;
+			break;
+		}
+		candidate = de_scene_find_next_node(candidate);
+
+		if (!stack.size) {
+			result = first;
+			break;
+		}
+		de_node_t* n = DE_ARRAY_POP(stack);
+		if (de_str8_eq(&n->name, name) && (!first || n->name_order < first->name_order)) {
+			first = n;
+		}
+		for (size_t i = 0; i < n->children.size; ++i) {
+			DE_ARRAY_APPEND(stack, n->children.data[i]);
 		}
 	}
-	return NULL;
+	DE_ARRAY_FREE(stack);
+	return result;
 }
 
 de_mesh_t* de_node_to_mesh(de_node_t* node)
@@ -603,6 +685,7 @@ bool de_node_visit(de_object_visitor_t* visitor, de_node_t* node)
 	if (visitor->is_reading) {
 		/* restore dispatch table */
 		node->dispatch_table = de_node_get_dispatch_table_by_type(node->type);
+		node->transform_slot = DE_NODE_NO_SLOT;
 	}
 	result &= de_object_visitor_visit_string(visitor, "Name", &node->name);
 	result &= DE_OBJECT_VISITOR_VISIT_POINTER(visitor, "ModelResource", &node->model_resource, de_resource_visit);
@@ -668,7 +751,13 @@ bool de_node_visit(de_object_visitor_t* visitor, de_node_t* node)
 void de_node_set_name(de_node_t* node, const char* name)
 {
 	DE_ASSERT(node);
+	if (node->scene) {
+		de_scene_unindex_node_name(node->scene, node);
+	}
 	de_str8_set(&node->name, name);
+	if (node->scene) {
+		de_scene_index_node_name(node->scene, node);
+	}
 }
 
 const char* de_node_get_name(de_node_t* node)
@@ -751,7 +840,7 @@ void de_node_set_pre_rotation(de_node_t* node, const de_quat_t* q)
 	DE_ASSERT(node);
 	DE_ASSERT(q);
 	node->pre_rotation = *q;
-	node->transform_flags |= DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE;
+	de_node_set_transform_flags(node, DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE | DE_TRANSFORM_FLAGS_PRE_ROTATION_NEED_UPDATE);
 }
 
 void de_node_get_pre_rotation(de_node_t* node, de_quat_t* q)
@@ -766,7 +855,7 @@ void de_node_set_post_rotation(de_node_t* node, const de_quat_t* q)
 	DE_ASSERT(node);
 	DE_ASSERT(q);
 	node->post_rotation = *q;
-	node->transform_flags |= DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE | DE_TRANSFORM_FLAGS_POST_ROTATION_NEED_UPDATE;
+	de_node_set_transform_flags(node, DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE | DE_TRANSFORM_FLAGS_POST_ROTATION_NEED_UPDATE);
 }
 
 void de_node_get_post_rotation(de_node_t* node, de_quat_t* q)
@@ -781,7 +870,7 @@ void de_node_set_rotation_offset(de_node_t* node, const de_vec3_t* v)
 	DE_ASSERT(node);
 	DE_ASSERT(v);
 	node->rotation_offset = *v;
-	node->transform_flags |= DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE;
+	de_node_set_transform_flags(node, DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE);
 }
 
 void de_node_get_rotation_offset(de_node_t* node, de_vec3_t* v)
@@ -796,7 +885,7 @@ void de_node_set_rotation_pivot(de_node_t* node, const de_vec3_t* v)
 	DE_ASSERT(node);
 	DE_ASSERT(v);
 	node->rotation_pivot = *v;
-	node->transform_flags |= DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE | DE_TRANSFORM_FLAGS_ROTATION_PIVOT_NEED_UPDATE;
+	de_node_set_transform_flags(node, DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE | DE_TRANSFORM_FLAGS_ROTATION_PIVOT_NEED_UPDATE);
 }
 
 void de_node_get_rotation_pivot(de_node_t* node, de_vec3_t* v)
@@ -811,7 +900,7 @@ void de_node_set_scaling_offset(de_node_t* node, const de_vec3_t* v)
 	DE_ASSERT(node);
 	DE_ASSERT(v);
 	node->scaling_offset = *v;
-	node->transform_flags |= DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE;
+	de_node_set_transform_flags(node, DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE | DE_TRANSFORM_FLAGS_SCALING_OFFSET_NEED_UPDATE);
 }
 
 void de_node_get_scaling_offset(de_node_t* node, de_vec3_t* v)
@@ -826,7 +915,7 @@ void de_node_set_scaling_pivot(de_node_t* node, const de_vec3_t* v)
 	DE_ASSERT(node);
 	DE_ASSERT(v);
 	node->scaling_pivot = *v;
-	node->transform_flags |= DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE | DE_TRANSFORM_FLAGS_SCALE_PIVOT_NEED_UPDATE;
+	de_node_set_transform_flags(node, DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE | DE_TRANSFORM_FLAGS_SCALE_PIVOT_NEED_UPDATE);
 }
 
 void de_node_get_scaling_pivot(de_node_t* node, de_vec3_t* v)
@@ -839,11 +928,26 @@ void de_node_get_scaling_pivot(de_node_t* node, de_vec3_t* v)
 void de_node_invalidate_transforms(de_node_t* node)
 {
 	DE_ASSERT(node);
-	node->transform_flags |=
+	de_node_set_transform_flags(node,
 		DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE |
 		DE_TRANSFORM_FLAGS_ROTATION_PIVOT_NEED_UPDATE |
 		DE_TRANSFORM_FLAGS_SCALE_PIVOT_NEED_UPDATE |
-		DE_TRANSFORM_FLAGS_POST_ROTATION_NEED_UPDATE;
+		DE_TRANSFORM_FLAGS_POST_ROTATION_NEED_UPDATE |
+		DE_TRANSFORM_FLAGS_PRE_ROTATION_NEED_UPDATE |
+		DE_TRANSFORM_FLAGS_SCALING_OFFSET_NEED_UPDATE);
+}
+
+void de_node_set_transform_flags(de_node_t* node, de_transform_flags_t flags)
+{
+	DE_ASSERT(node);
+	node->transform_flags |= flags | DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE;
+	if (node->scene) {
+		de_transform_hierarchy_t* hierarchy = &node->scene->transform_hierarchy;
+		/* slot can be stale until hierarchy is rebuilt, rebuild takes flags from nodes anyway */
+		if (node->transform_slot < hierarchy->nodes.size && hierarchy->nodes.data[node->transform_slot] == node) {
+			hierarchy->dirty.data[node->transform_slot] = 1;
+		}
+	}
 }
 
 de_scene_t* de_node_get_scene(de_node_t* node)
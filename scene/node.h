@@ -19,6 +19,9 @@
 * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
 * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
 
+/* Node is not in transform hierarchy of scene, see de_transform_hierarchy_t */
+#define DE_NODE_NO_SLOT ((uint32_t)-1)
+
 typedef enum de_node_type_t {
 	DE_NODE_TYPE_BASE,
 	DE_NODE_TYPE_LIGHT,
@@ -42,7 +45,10 @@ typedef enum de_transform_flags_t {
 	DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE = DE_BIT(0),
 	DE_TRANSFORM_FLAGS_ROTATION_PIVOT_NEED_UPDATE = DE_BIT(1),
 	DE_TRANSFORM_FLAGS_SCALE_PIVOT_NEED_UPDATE = DE_BIT(2),
-	DE_TRANSFORM_FLAGS_POST_ROTATION_NEED_UPDATE = DE_BIT(3)
+	DE_TRANSFORM_FLAGS_POST_ROTATION_NEED_UPDATE = DE_BIT(3),
+	DE_TRANSFORM_FLAGS_GLOBAL_TRANSFORM_NEED_UPDATE = DE_BIT(4), /**< Global transform of node and its descendants is outdated. */
+	DE_TRANSFORM_FLAGS_PRE_ROTATION_NEED_UPDATE = DE_BIT(5),
+	DE_TRANSFORM_FLAGS_SCALING_OFFSET_NEED_UPDATE = DE_BIT(6),
 } de_transform_flags_t;
 
 typedef enum de_node_flags_t {
@@ -83,6 +89,10 @@ DE_STATIC_ASSERT(sizeof(de_node_transform_info_t) == sizeof(uint32_t), de_node_t
 struct de_node_t {
 	de_node_type_t type;
 	de_str8_t name;
+	uint32_t name_hash; /**< Hash of name, see de_node_name_index_t. */
+	de_node_t* name_index_next; /**< Next node in bucket of hash index of names of scene. */
+	de_node_t* name_index_prev;
+	uint64_t name_order; /**< When node got its name in scene, nodes with same name are ordered by it. */
 	de_scene_t* scene;
 	de_mat4_t local_matrix; /**< Matrix of local transform of the node. Read-only. */
 	de_mat4_t global_matrix; /**< Matrix of global transform of the node. Read-only. */
@@ -96,14 +106,13 @@ struct de_node_t {
 	de_vec3_t rotation_pivot;
 	de_vec3_t scaling_offset;
 	de_vec3_t scaling_pivot;
-	/* Cached matrices - its too inefficient to compute three inverse matrices every frame for each node. */
-	de_mat4_t m_rotation_pivot;
-	de_mat4_t m_rotation_pivot_inv;
-	de_mat4_t m_post_rotation;
-	de_mat4_t m_scale_pivot;
-	de_mat4_t m_scale_pivot_inv;
+	/* Constant parts of FBX transform chain, folded only when FBX components change. */
+	de_mat4_t m_pre_rotation; /**< rotation_pivot * pre_rotation */
+	de_mat4_t m_post_rotation; /**< inverse(post_rotation) * inverse(rotation_pivot) * scaling_offset * scaling_pivot */
+	bool simple_transform; /**< Node has no FBX components, local transform is plain translation * rotation * scale. */
 	de_aabb_t bounding_box; /**< Local bounding box of a node. */
 	de_transform_flags_t transform_flags;
+	uint32_t transform_slot; /**< Index of slot in flattened transform hierarchy of scene, see de_transform_hierarchy_t. */
 	de_node_transform_info_t transform_info;	
 	de_node_t* parent; /**< Pointer to parent node */
 	DE_ARRAY_DECLARE(de_node_t*, children); /**< Array of pointers to child nodes */
@@ -274,7 +283,10 @@ void de_node_move(de_node_t* node, de_vec3_t* offset);
 void de_node_set_body(de_node_t* node, de_body_t* body);
 
 /**
-* @brief Performs recursive search on tree to find a specified node.
+* @brief Searches tree for a node with specified name. Candidates from hash index of names of scene are
+* checked together with walk over the tree and search stops when either is done, so cost is bounded by
+* the smaller of amount of nodes with this name in scene and size of tree. If tree has several nodes
+* with this name, node that was first added to scene or renamed to that name is returned.
 * @param root Pointer to node from which you want to start searching.
 * @param name Name of node you looking for.
 * @return
@@ -391,6 +403,13 @@ void de_node_get_scaling_pivot(de_node_t* node, de_vec3_t* v);
  */
 void de_node_invalidate_transforms(de_node_t* node);
 
+/**
+ * @brief Marks local transform of node as outdated (plus given DE_TRANSFORM_FLAGS_xxx), slot of node
+ * in transform hierarchy of scene is marked so scene update finds node. Must be called after changing transform fields of node
+ * directly (i.e. by animation), setters do this automatically.
+ */
+void de_node_set_transform_flags(de_node_t* node, de_transform_flags_t flags);
+
 /**
  * @brief Returns pointer to scene specified node belongs to.
  */
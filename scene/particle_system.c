@@ -77,6 +77,7 @@ static bool de_particle_system_emitter_visit(de_object_visitor_t* visitor, de_pa
 	result &= DE_OBJECT_VISITOR_VISIT_POINTER(visitor, "ParticleSystem", &particle_system_node, de_particle_system_visit);
 	if(visitor->is_reading) {
 		emitter->particle_system = de_node_to_particle_system(particle_system_node);
+		emitter->random_state = (uint32_t)rand();
 	}
 	result &= DE_OBJECT_VISITOR_VISIT_ENUM(visitor, "Type", &emitter->type);
 	result &= de_object_visitor_visit_vec3(visitor, "Position", &emitter->position);
@@ -179,25 +180,25 @@ static void de_particle_system_emitter_emit(de_particle_system_emitter_t* emitte
 			for (int i = 0; i < particle_count; ++i) {
 				de_particle_t* particle = de_particle_system_spawn_particle(emitter->particle_system, emitter);
 				particle->lifetime = 0.0f;
-				particle->initial_lifetime = de_frand(emitter->min_lifetime, emitter->max_lifetime);
+				particle->initial_lifetime = de_frand_r(&emitter->random_state, emitter->min_lifetime, emitter->max_lifetime);
 				particle->color = (de_color_t) { 255, 255, 255, 255 };
-				particle->size = de_frand(emitter->min_size, emitter->max_size);
-				particle->size_modifier = de_frand(emitter->min_size_modifier, emitter->max_size_modifier);
+				particle->size = de_frand_r(&emitter->random_state, emitter->min_size, emitter->max_size);
+				particle->size_modifier = de_frand_r(&emitter->random_state, emitter->min_size_modifier, emitter->max_size_modifier);
 				particle->velocity = (de_vec3_t) {
-					.x = de_frand(emitter->min_x_velocity, emitter->max_x_velocity),
-					.y = de_frand(emitter->min_y_velocity, emitter->max_y_velocity),
-					.z = de_frand(emitter->min_z_velocity, emitter->max_z_velocity)
+					.x = de_frand_r(&emitter->random_state, emitter->min_x_velocity, emitter->max_x_velocity),
+					.y = de_frand_r(&emitter->random_state, emitter->min_y_velocity, emitter->max_y_velocity),
+					.z = de_frand_r(&emitter->random_state, emitter->min_z_velocity, emitter->max_z_velocity)
 				};
-				particle->rotation = de_frand(emitter->min_rotation, emitter->max_rotation);
-				particle->rotation_speed = de_frand(emitter->min_rotation_speed, emitter->max_rotation_speed);
+				particle->rotation = de_frand_r(&emitter->random_state, emitter->min_rotation, emitter->max_rotation);
+				particle->rotation_speed = de_frand_r(&emitter->random_state, emitter->min_rotation_speed, emitter->max_rotation_speed);
 				/* position defined by emitter type */
 				switch (emitter->type) {
 					case DE_PARTICLE_SYSTEM_EMITTER_TYPE_BOX: {						
 						de_particle_system_box_emitter_t* box_emitter = &emitter->s.box;
 						particle->position = (de_vec3_t) { 
-							.x = emitter->position.x + de_frand(-box_emitter->half_width, box_emitter->half_width),
-							.y = emitter->position.y + de_frand(-box_emitter->half_height, box_emitter->half_height),
-							.z = emitter->position.z + de_frand(-box_emitter->half_depth, box_emitter->half_depth)
+							.x = emitter->position.x + de_frand_r(&emitter->random_state, -box_emitter->half_width, box_emitter->half_width),
+							.y = emitter->position.y + de_frand_r(&emitter->random_state, -box_emitter->half_height, box_emitter->half_height),
+							.z = emitter->position.z + de_frand_r(&emitter->random_state, -box_emitter->half_depth, box_emitter->half_depth)
 						};								
 						break;
 					}
@@ -208,9 +209,9 @@ static void de_particle_system_emitter_emit(de_particle_system_emitter_t* emitte
 					case DE_PARTICLE_SYSTEM_EMITTER_TYPE_SPHERE: {
 						de_particle_system_sphere_emitter_t* sphere_emitter = &emitter->s.sphere;
 						/* generate random spherical coordinates and convert to cartesian */
-						const float phi = de_frand(0.0f, (float)M_PI);
-						const float theta = de_frand(0.0f, 2.0f * (float)M_PI);
-						const float radius = de_frand(0.0f, sphere_emitter->radius);
+						const float phi = de_frand_r(&emitter->random_state, 0.0f, (float)M_PI);
+						const float theta = de_frand_r(&emitter->random_state, 0.0f, 2.0f * (float)M_PI);
+						const float radius = de_frand_r(&emitter->random_state, 0.0f, sphere_emitter->radius);
 						const float cos_theta = (float)cos(theta);
 						const float sin_theta = (float)sin(theta);
 						const float cos_phi = (float)cos(phi);
@@ -378,6 +379,7 @@ de_particle_system_emitter_t* de_particle_system_emitter_create(de_particle_syst
 	de_particle_system_emitter_t* emitter = DE_NEW(de_particle_system_emitter_t);
 	emitter->type = type;
 	emitter->particle_system = particle_system;
+	emitter->random_state = (uint32_t)rand();
 	DE_ARRAY_APPEND(particle_system->emitters, emitter);
 	/* default values */
 	emitter->min_lifetime = 5.0f;
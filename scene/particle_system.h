@@ -75,6 +75,7 @@ typedef struct de_particle_system_emitter_t {
 	/* Private */
 	int32_t alive_particles; /**< Count of particle already spawned by this emitter. */
 	float time; /**< Time accumulator for update purposes. */
+	uint32_t random_state; /**< Emitters are updated in parallel, so each one has its own random numbers instead of rand(). */
 	union {
 		de_particle_system_box_emitter_t box;
 		de_particle_system_sphere_emitter_t sphere;
@@ -24,6 +24,8 @@ de_scene_t* de_scene_create(de_core_t* core)
 	de_scene_t* s = DE_NEW(de_scene_t);
 	s->core = core;
 	DE_LINKED_LIST_INIT(s->nodes);
+	s->transform_hierarchy.need_rebuild = true;
+	de_broadphase_init(&s->broadphase);
 	DE_LINKED_LIST_APPEND(core->scenes, s);
 	return s;
 }
@@ -50,6 +52,16 @@ void de_scene_free(de_scene_t* s)
 		de_animation_free(s->animations.head);
 	}
 
+	de_broadphase_free(&s->broadphase);
+	DE_ARRAY_FREE(s->physics_bodies);
+	DE_ARRAY_FREE(s->transform_hierarchy.nodes);
+	DE_ARRAY_FREE(s->transform_hierarchy.parents);
+	DE_ARRAY_FREE(s->transform_hierarchy.world_matrices);
+	DE_ARRAY_FREE(s->transform_hierarchy.dirty);
+	DE_ARRAY_FREE(s->transform_hierarchy.levels);
+	DE_ARRAY_FREE(s->particle_systems);
+	DE_ARRAY_FREE(s->node_name_index.buckets);
+
 	if (s->core) {
 		DE_LINKED_LIST_REMOVE(s->core->scenes, s);
 	}
@@ -57,6 +69,16 @@ void de_scene_free(de_scene_t* s)
 	de_free(s);
 }
 
+const de_physics_stats_t* de_scene_get_physics_stats(const de_scene_t* s)
+{
+	return &s->physics_stats;
+}
+
+size_t de_scene_get_transform_update_count(const de_scene_t* s)
+{
+	return s->transform_update_count;
+}
+
 de_static_geometry_t* de_scene_create_static_geometry(de_scene_t* s)
 {
 	de_static_geometry_t* geom;
@@ -70,16 +92,94 @@ de_static_geometry_t* de_scene_create_static_geometry(de_scene_t* s)
 void de_scene_free_static_geometry(de_scene_t* s, de_static_geometry_t* geom)
 {
 	assert(s);
+	de_static_geometry_wake_up_bodies(geom);
 	DE_LINKED_LIST_REMOVE(s->static_geometries, geom);
 	DE_ARRAY_FREE(geom->triangles);
-	de_octree_free(geom->octree);
+	de_bvh_free(&geom->bvh);
 	de_free(geom);
 }
 
+void de_scene_invalidate_transform_hierarchy(de_scene_t* s)
+{
+	DE_ASSERT(s);
+	s->transform_hierarchy.need_rebuild = true;
+}
+
+static uint32_t de_scene_hash_node_name(const char* name)
+{
+	/* same as de_str8_hash */
+	return *name ? de_hash_murmur3((const uint8_t*)name, strlen(name), 0) : 0;
+}
+
+static void de_scene_append_node_name(de_node_name_index_t* index, de_node_t* node)
+{
+	de_node_name_bucket_t* bucket = &index->buckets.data[node->name_hash & (index->buckets.size - 1)];
+	node->name_index_next = NULL;
+	node->name_index_prev = bucket->tail;
+	if (bucket->tail) {
+		bucket->tail->name_index_next = node;
+	} else {
+		bucket->head = node;
+	}
+	bucket->tail = node;
+}
+
+void de_scene_index_node_name(de_scene_t* s, de_node_t* node)
+{
+	DE_ASSERT(s);
+	DE_ASSERT(node);
+	de_node_name_index_t* index = &s->node_name_index;
+	/* keep at most one node per bucket on average */
+	if (index->count >= index->buckets.size) {
+		const size_t old_size = index->buckets.size;
+		de_node_name_bucket_t* old_buckets = index->buckets.data;
+		const size_t new_size = old_size ? old_size * 2 : 64;
+		DE_ARRAY_INIT(index->buckets);
+		DE_ARRAY_GROW(index->buckets, new_size);
+		memset(index->buckets.data, 0, new_size * sizeof(*index->buckets.data));
+		/* chains are walked in order, so nodes with same name stay in order of addition */
+		for (size_t i = 0; i < old_size; ++i) {
+			de_node_t* next;
+			for (de_node_t* n = old_buckets[i].head; n; n = next) {
+				next = n->name_index_next;
+				de_scene_append_node_name(index, n);
+			}
+		}
+		de_free(old_buckets);
+	}
+	node->name_hash = de_str8_hash(&node->name);
+	node->name_order = index->next_order++;
+	de_scene_append_node_name(index, node);
+	++index->count;
+}
+
+void de_scene_unindex_node_name(de_scene_t* s, de_node_t* node)
+{
+	DE_ASSERT(s);
+	DE_ASSERT(node);
+	de_node_name_index_t* index = &s->node_name_index;
+	de_node_name_bucket_t* bucket = &index->buckets.data[node->name_hash & (index->buckets.size - 1)];
+	if (node->name_index_prev) {
+		node->name_index_prev->name_index_next = node->name_index_next;
+	} else {
+		bucket->head = node->name_index_next;
+	}
+	if (node->name_index_next) {
+		node->name_index_next->name_index_prev = node->name_index_prev;
+	} else {
+		bucket->tail = node->name_index_prev;
+	}
+	node->name_index_next = NULL;
+	node->name_index_prev = NULL;
+	--index->count;
+}
+
 void de_scene_add_node(de_scene_t* s, de_node_t* node)
 {
 	DE_LINKED_LIST_APPEND(s->nodes, node);
 	node->scene = s;
+	de_scene_index_node_name(s, node);
+	de_scene_invalidate_transform_hierarchy(s);
 	if (node->type == DE_NODE_TYPE_CAMERA) {
 		s->active_camera = node;
 	}
@@ -91,30 +191,186 @@ void de_scene_remove_node(de_scene_t* s, de_node_t* node)
 		s->active_camera = NULL;
 	}
 
+	de_scene_unindex_node_name(s, node);
 	node->scene = NULL;
+	node->transform_slot = DE_NODE_NO_SLOT;
+	de_scene_invalidate_transform_hierarchy(s);
 
 	DE_LINKED_LIST_REMOVE(s->nodes, node);
 }
 
 de_node_t* de_scene_find_node(const de_scene_t* s, const char* name)
 {
-	DE_LINKED_LIST_FOR_EACH_T(de_node_t*, node, s->nodes)
-	{
-		if (de_str8_eq(&node->name, name)) {
+	DE_ASSERT(s);
+	DE_ASSERT(name);
+	const de_node_name_index_t* index = &s->node_name_index;
+	if (!index->count) {
+		return NULL;
+	}
+	const uint32_t hash = de_scene_hash_node_name(name);
+	for (de_node_t* node = index->buckets.data[hash & (index->buckets.size - 1)].head; node; node = node->name_index_next) {
+		if (node->name_hash == hash && de_str8_eq(&node->name, name)) {
 			return node;
 		}
 	}
 	return NULL;
 }
 
+de_node_t* de_scene_find_next_node(const de_node_t* node)
+{
+	DE_ASSERT(node);
+	for (de_node_t* next = node->name_index_next; next; next = next->name_index_next) {
+		if (next->name_hash == node->name_hash && de_str8_eq_str8(&next->name, &node->name)) {
+			return next;
+		}
+	}
+	return NULL;
+}
+
 de_node_t* de_scene_get_first_node(de_scene_t* s) 
 {
 	DE_ASSERT(s);
 	return s->nodes.head;
 }
 
+static void de_scene_push_transform_slot(de_transform_hierarchy_t* hierarchy, de_node_t* node, uint32_t parent)
+{
+	node->transform_slot = (uint32_t)hierarchy->nodes.size;
+	DE_ARRAY_APPEND(hierarchy->nodes, node);
+	DE_ARRAY_APPEND(hierarchy->parents, parent);
+	/* children of unchanged node read its world matrix */
+	DE_ARRAY_APPEND(hierarchy->world_matrices, node->global_matrix);
+	DE_ARRAY_APPEND(hierarchy->dirty, (node->transform_flags & (DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE | DE_TRANSFORM_FLAGS_GLOBAL_TRANSFORM_NEED_UPDATE)) ? 1 : 0);
+}
+
+/**
+ * @brief Fills transform hierarchy breadth-first: root nodes first, then their children and so on.
+ * Attached or detached node has its local transform marked as outdated, so it is updated together
+ * with its new descendants.
+ */
+static void de_scene_rebuild_transform_hierarchy(de_scene_t* s)
+{
+	de_transform_hierarchy_t* hierarchy = &s->transform_hierarchy;
+	DE_ARRAY_CLEAR(hierarchy->nodes);
+	DE_ARRAY_CLEAR(hierarchy->parents);
+	DE_ARRAY_CLEAR(hierarchy->world_matrices);
+	DE_ARRAY_CLEAR(hierarchy->dirty);
+	DE_ARRAY_CLEAR(hierarchy->levels);
+	DE_ARRAY_APPEND(hierarchy->levels, 0);
+	DE_LINKED_LIST_FOR_EACH_T(de_node_t*, node, s->nodes)
+	{
+		if (!node->parent) {
+			de_scene_push_transform_slot(hierarchy, node, DE_NODE_NO_SLOT);
+		}
+	}
+	/* array of nodes is the queue of breadth-first traversal, children of one level form next level */
+	size_t begin = 0;
+	while (begin < hierarchy->nodes.size) {
+		const size_t end = hierarchy->nodes.size;
+		for (size_t i = begin; i < end; ++i) {
+			de_node_t* node = hierarchy->nodes.data[i];
+			for (size_t k = 0; k < node->children.size; ++k) {
+				de_scene_push_transform_slot(hierarchy, node->children.data[k], (uint32_t)i);
+			}
+		}
+		DE_ARRAY_APPEND(hierarchy->levels, end);
+		begin = end;
+	}
+	hierarchy->need_rebuild = false;
+}
+
+typedef struct de_scene_transform_update_t {
+	de_transform_hierarchy_t* hierarchy;
+	size_t level_begin; /**< First slot of level being updated. */
+	volatile long update_count;
+} de_scene_transform_update_t;
+
+/**
+ * @brief Updates visibility and world matrices of slots of one level. Parents of these slots are
+ * in previous level which is already updated, slots of one level do not depend on each other.
+ */
+static void de_scene_transform_range(void* user_data, size_t begin, size_t end, size_t thread_index)
+{
+	DE_UNUSED(thread_index);
+	de_scene_transform_update_t* update = user_data;
+	de_transform_hierarchy_t* hierarchy = update->hierarchy;
+	de_node_t** nodes = hierarchy->nodes.data;
+	const uint32_t* parents = hierarchy->parents.data;
+	de_mat4_t* world_matrices = hierarchy->world_matrices.data;
+	uint8_t* dirty = hierarchy->dirty.data;
+	long count = 0;
+	for (size_t i = update->level_begin + begin; i < update->level_begin + end; ++i) {
+		const uint32_t parent = parents[i];
+		de_node_t* node = nodes[i];
+		node->global_visibility = node->local_visibility;
+		if (parent != DE_NODE_NO_SLOT) {
+			node->global_visibility &= nodes[parent]->global_visibility;
+			dirty[i] |= dirty[parent];
+		}
+		if (dirty[i]) {
+			de_node_calculate_local_transform(node);
+			if (parent != DE_NODE_NO_SLOT) {
+				de_mat4_mul(&world_matrices[i], &world_matrices[parent], &node->local_matrix);
+			} else {
+				world_matrices[i] = node->local_matrix;
+			}
+			node->global_matrix = world_matrices[i];
+			node->transform_flags &= ~DE_TRANSFORM_FLAGS_GLOBAL_TRANSFORM_NEED_UPDATE;
+			++count;
+		}
+	}
+	if (count) {
+		de_atomic_add(&update->update_count, count);
+	}
+}
+
+/**
+ * @brief Calculates visibility and world matrices level by level, only nodes of dirty slots (and
+ * their descendants) get new transforms. Dirty flag of parent is propagated to its children on the
+ * way. Returns amount of updated slots.
+ */
+static size_t de_scene_update_transform_hierarchy(de_scene_t* s, de_thread_pool_t* pool)
+{
+	/* Levels smaller than this are updated by calling thread, waking up workers costs more */
+	const size_t min_parallel_level = 256;
+
+	de_transform_hierarchy_t* hierarchy = &s->transform_hierarchy;
+	if (hierarchy->need_rebuild) {
+		de_scene_rebuild_transform_hierarchy(s);
+	}
+	de_scene_transform_update_t update = { .hierarchy = hierarchy };
+	for (size_t i = 0; i + 1 < hierarchy->levels.size; ++i) {
+		update.level_begin = hierarchy->levels.data[i];
+		const size_t count = hierarchy->levels.data[i + 1] - update.level_begin;
+		de_thread_pool_parallel_for(count >= min_parallel_level ? pool : NULL, count, 0, de_scene_transform_range, &update);
+	}
+	memset(hierarchy->dirty.data, 0, hierarchy->dirty.size);
+	return (size_t)update.update_count;
+}
+
+static void de_scene_animation_track_range(void* user_data, size_t begin, size_t end, size_t thread_index)
+{
+	DE_UNUSED(thread_index);
+	de_animation_sample_tracks(user_data, begin, end);
+}
+
+static void de_scene_particle_system_range(void* user_data, size_t begin, size_t end, size_t thread_index)
+{
+	DE_UNUSED(thread_index);
+	de_scene_t* s = user_data;
+	for (size_t i = begin; i < end; ++i) {
+		de_particle_system_update(de_node_to_particle_system(s->particle_systems.data[i]), s->update_dt);
+	}
+}
+
 void de_scene_update(de_scene_t* s, double dt)
 {
+	/* Jobs smaller than this are done by calling thread, waking up workers costs more */
+	const size_t min_parallel_tracks = 64;
+	const size_t min_parallel_particle_systems = 4;
+
+	de_thread_pool_t* pool = s->core ? de_core_get_thread_pool(s->core) : NULL;
+
 	/* Animations prepass - reset local transform of associated track nodes for blending */
 	DE_LINKED_LIST_FOR_EACH_T(de_animation_t*, anim, s->animations)
 	{
@@ -131,27 +387,41 @@ void de_scene_update(de_scene_t* s, double dt)
 		}
 	}
 
-	/* Animation pass */
+	/* Animation pass - animations are blended into same nodes so they go one after another,
+	 * tracks of each animation are sampled in parallel */
 	DE_LINKED_LIST_FOR_EACH_T(de_animation_t*, anim, s->animations)
 	{
-		de_animation_update(anim, (float)dt);
+		const size_t count = anim->tracks.size;
+		de_thread_pool_parallel_for(count >= min_parallel_tracks ? pool : NULL, count, 0, de_scene_animation_track_range, anim);
+		de_animation_advance(anim, (float)dt);
 	}
 
+	DE_ARRAY_CLEAR(s->particle_systems);
+	const float interpolation_factor = de_physics_get_interpolation_factor(s);
 	DE_LINKED_LIST_FOR_EACH_T(de_node_t*, node, s->nodes)
 	{
 		if (node->type == DE_NODE_TYPE_PARTICLE_SYSTEM) {
-			de_particle_system_update(de_node_to_particle_system(node), (float)dt);
+			DE_ARRAY_APPEND(s->particle_systems, node);
 		}
-	}
-
-	/* Calculate transforms and visibility of nodes starting from root nodes */
-	DE_LINKED_LIST_FOR_EACH_T(de_node_t*, node, s->nodes)
-	{
-		if (!node->parent) {
-			de_node_calculate_visibility_descending(node);
-			de_node_calculate_transforms_descending(node);
+		/* Position of node is taken from its body, which is moved by physics. Sleeping or resting
+		 * bodies keep their interpolated position, their nodes are not updated. */
+		if (node->body) {
+			de_vec3_t position;
+			de_body_get_interpolated_position(node->body, interpolation_factor, &position);
+			if (position.x != node->position.x || position.y != node->position.y || position.z != node->position.z) {
+				de_node_set_transform_flags(node, DE_TRANSFORM_FLAGS_LOCAL_TRANSFORM_NEED_UPDATE);
+			}
 		}
 	}
+
+	/* Particle systems are independent of each other */
+	s->update_dt = (float)dt;
+	const size_t particle_system_count = s->particle_systems.size;
+	de_thread_pool_parallel_for(particle_system_count >= min_parallel_particle_systems ? pool : NULL,
+		particle_system_count, 1, de_scene_particle_system_range, s);
+
+	/* Calculate visibility and transforms, only changed nodes and their descendants get new transforms */
+	s->transform_update_count = de_scene_update_transform_hierarchy(s, pool);
 }
 
 bool de_scene_visit(de_object_visitor_t* visitor, de_scene_t* scene)
@@ -160,6 +430,12 @@ bool de_scene_visit(de_object_visitor_t* visitor, de_scene_t* scene)
 	result &= DE_OBJECT_VISITOR_VISIT_INTRUSIVE_LINKED_LIST(visitor, "Nodes", scene->nodes, de_node_t, de_node_visit);
 	if (visitor->is_reading) {
 		scene->core = visitor->core;
+		de_scene_invalidate_transform_hierarchy(scene);
+		/* nodes were read directly into list */
+		DE_LINKED_LIST_FOR_EACH_T(de_node_t*, node, scene->nodes)
+		{
+			de_scene_index_node_name(scene, node);
+		}
 		/* resolve pointers to original nodes from model resources using names of nodes
 		 * notes: this is unreliable mechanism, because if name will be changed, resolving
 		 * will fail. at this moment of time I do not know better way of resolving pointers. */
@@ -199,4 +475,353 @@ bool de_scene_visit(de_object_visitor_t* visitor, de_scene_t* scene)
 	}
 	result &= DE_OBJECT_VISITOR_VISIT_POINTER(visitor, "ActiveCamera", &scene->active_camera, de_node_visit);
 	return result;
+}
+
+static size_t de_scene_tests_count_nodes_named(de_scene_t* s, const char* name)
+{
+	size_t count = 0;
+	for (de_node_t* node = de_scene_find_node(s, name); node; node = de_scene_find_next_node(node)) {
+		DE_ASSERT(de_str8_eq(&node->name, name));
+		++count;
+	}
+	return count;
+}
+
+static void de_scene_tests_names(de_core_t* core)
+{
+	de_scene_t* s = de_scene_create(core);
+
+	/* many instances of same small model, nodes with same name are enumerated in order of addition */
+	const size_t instance_count = 300;
+	de_node_t** roots = de_malloc(instance_count * sizeof(*roots));
+	for (size_t i = 0; i < instance_count; ++i) {
+		roots[i] = de_node_create(s, DE_NODE_TYPE_BASE);
+		de_node_set_name(roots[i], "Root");
+		de_node_t* hips = de_node_create(s, DE_NODE_TYPE_BASE);
+		de_node_set_name(hips, "Hips");
+		de_node_attach(hips, roots[i]);
+		de_node_t* hand = de_node_create(s, DE_NODE_TYPE_BASE);
+		de_node_set_name(hand, "Hand");
+		de_node_attach(hand, hips);
+	}
+	DE_ASSERT(de_scene_tests_count_nodes_named(s, "Hand") == instance_count);
+	DE_ASSERT(de_scene_tests_count_nodes_named(s, "Foot") == 0);
+	DE_ASSERT(de_scene_find_node(s, "Root") == roots[0]);
+	size_t n = 0;
+	for (de_node_t* node = de_scene_find_node(s, "Root"); node; node = de_scene_find_next_node(node)) {
+		DE_ASSERT(node == roots[n++]);
+	}
+	for (size_t i = 0; i < instance_count; ++i) {
+		de_node_t* hand = de_node_find(roots[i], "Hand");
+		DE_ASSERT(hand && hand->parent->parent == roots[i]);
+		DE_ASSERT(de_node_find(roots[i], "Foot") == NULL);
+		DE_ASSERT(de_node_find(hand, "Hips") == NULL);
+	}
+
+	/* renamed node leaves chain of old name and goes to the end of chain of new name */
+	de_node_set_name(roots[0], "Renamed");
+	DE_ASSERT(de_scene_find_node(s, "Root") == roots[1]);
+	DE_ASSERT(de_scene_find_node(s, "Renamed") == roots[0]);
+	DE_ASSERT(de_scene_tests_count_nodes_named(s, "Root") == instance_count - 1);
+	de_node_set_name(roots[0], "Root");
+	DE_ASSERT(de_scene_find_node(s, "Root") == roots[1]);
+	DE_ASSERT(de_scene_tests_count_nodes_named(s, "Root") == instance_count);
+	DE_ASSERT(de_scene_tests_count_nodes_named(s, "Renamed") == 0);
+
+	/* several nodes with same name in one tree: the one that got name first is found, no matter
+	 * whether search goes through candidates of index or through the tree */
+	de_node_t* hand = de_node_find(roots[5], "Hand");
+	de_node_t* second_hand = de_node_create(s, DE_NODE_TYPE_BASE);
+	de_node_attach(second_hand, roots[5]);
+	de_node_set_name(second_hand, "Hand");
+	DE_ASSERT(de_node_find(roots[5], "Hand") == hand);
+	DE_ASSERT(de_node_find(roots[instance_count - 1], "Hand") != hand);
+	de_node_set_name(hand, "Hand");
+	DE_ASSERT(de_node_find(roots[5], "Hand") == second_hand);
+	de_node_free(second_hand);
+
+	/* removed nodes are not found anymore */
+	for (size_t i = 0; i < instance_count; i += 2) {
+		de_node_free(roots[i]);
+	}
+	DE_ASSERT(de_scene_tests_count_nodes_named(s, "Root") == instance_count / 2);
+	DE_ASSERT(de_scene_tests_count_nodes_named(s, "Hand") == instance_count / 2);
+	DE_ASSERT(de_scene_find_node(s, "Root") == roots[1]);
+	for (size_t i = 1; i < instance_count; i += 2) {
+		DE_ASSERT(de_node_find(roots[i], "Hand")->parent->parent == roots[i]);
+	}
+
+	de_free(roots);
+	de_scene_free(s);
+}
+
+static de_quat_t de_scene_tests_random_rotation()
+{
+	de_vec3_t axis = { de_frand(-1.0f, 1.0f), de_frand(-1.0f, 1.0f), de_frand(-1.0f, 1.0f) };
+	if (de_vec3_sqr_len(&axis) < 0.01f) {
+		axis = (de_vec3_t) { 0, 1, 0 };
+	}
+	de_vec3_normalize(&axis, &axis);
+	de_quat_t q;
+	de_quat_from_axis_angle(&q, &axis, de_frand(-(float)M_PI, (float)M_PI));
+	return q;
+}
+
+static de_vec3_t de_scene_tests_random_vector(float min, float max)
+{
+	return (de_vec3_t) { de_frand(min, max), de_frand(min, max), de_frand(min, max) };
+}
+
+/* full FBX chain: T * Roff * Rp * Rpre * R * inv(Rpost) * inv(Rp) * Soff * Sp * S * inv(Sp) */
+static void de_scene_tests_fbx_chain(const de_node_t* node, de_mat4_t* out)
+{
+	de_mat4_t translation, rotation_offset, rotation_pivot, inv_rotation_pivot, pre_rotation, rotation,
+		post_rotation, inv_post_rotation, scaling_offset, scaling_pivot, inv_scaling_pivot, scale;
+	de_mat4_translation(&translation, &node->position);
+	de_mat4_translation(&rotation_offset, &node->rotation_offset);
+	de_mat4_translation(&rotation_pivot, &node->rotation_pivot);
+	de_mat4_inverse(&inv_rotation_pivot, &rotation_pivot);
+	de_mat4_rotation(&pre_rotation, &node->pre_rotation);
+	de_mat4_rotation(&rotation, &node->rotation);
+	de_mat4_rotation(&post_rotation, &node->post_rotation);
+	de_mat4_inverse(&inv_post_rotation, &post_rotation);
+	de_mat4_translation(&scaling_offset, &node->scaling_offset);
+	de_mat4_translation(&scaling_pivot, &node->scaling_pivot);
+	de_mat4_inverse(&inv_scaling_pivot, &scaling_pivot);
+	de_mat4_scale(&scale, &node->scale);
+
+	*out = translation;
+	de_mat4_mul(out, out, &rotation_offset);
+	de_mat4_mul(out, out, &rotation_pivot);
+	de_mat4_mul(out, out, &pre_rotation);
+	de_mat4_mul(out, out, &rotation);
+	de_mat4_mul(out, out, &inv_post_rotation);
+	de_mat4_mul(out, out, &inv_rotation_pivot);
+	de_mat4_mul(out, out, &scaling_offset);
+	de_mat4_mul(out, out, &scaling_pivot);
+	de_mat4_mul(out, out, &scale);
+	de_mat4_mul(out, out, &inv_scaling_pivot);
+}
+
+static void de_scene_tests_local_transform(de_core_t* core)
+{
+	de_scene_t* s = de_scene_create(core);
+	for (int i = 0; i < 1000; ++i) {
+		de_node_t* node = de_node_create(s, DE_NODE_TYPE_BASE);
+		de_vec3_t position = de_scene_tests_random_vector(-10.0f, 10.0f);
+		de_vec3_t scale = de_scene_tests_random_vector(0.5f, 2.0f);
+		de_quat_t rotation = de_scene_tests_random_rotation();
+		de_node_set_local_position(node, &position);
+		de_node_set_local_scale(node, &scale);
+		de_node_set_local_rotation(node, &rotation);
+		/* every other node is plain TRS, others have random subset of FBX components */
+		if (i % 2) {
+			de_vec3_t v;
+			de_quat_t q;
+			if (i % 3) {
+				q = de_scene_tests_random_rotation();
+				de_node_set_pre_rotation(node, &q);
+			}
+			if (i % 5) {
+				q = de_scene_tests_random_rotation();
+				de_node_set_post_rotation(node, &q);
+			}
+			if (i % 7) {
+				v = de_scene_tests_random_vector(-2.0f, 2.0f);
+				de_node_set_rotation_offset(node, &v);
+				v = de_scene_tests_random_vector(-2.0f, 2.0f);
+				de_node_set_rotation_pivot(node, &v);
+			}
+			if (i % 11) {
+				v = de_scene_tests_random_vector(-2.0f, 2.0f);
+				de_node_set_scaling_offset(node, &v);
+				v = de_scene_tests_random_vector(-2.0f, 2.0f);
+				de_node_set_scaling_pivot(node, &v);
+			}
+		}
+
+		de_mat4_t folded, chain;
+		de_nod_get_local_transform(node, &folded);
+		de_scene_tests_fbx_chain(node, &chain);
+		for (int k = 0; k < 16; ++k) {
+			DE_ASSERT(fabsf(folded.f[k] - chain.f[k]) < 1e-4f);
+		}
+
+		/* changes after first calculation must be picked up by cached parts of fold, plain
+		 * nodes become FBX ones here */
+		rotation = de_scene_tests_random_rotation();
+		de_node_set_local_rotation(node, &rotation);
+		if (i % 4 < 2) {
+			de_quat_t q = de_scene_tests_random_rotation();
+			de_node_set_pre_rotation(node, &q);
+		} else {
+			de_vec3_t v = de_scene_tests_random_vector(-2.0f, 2.0f);
+			de_node_set_scaling_offset(node, &v);
+		}
+		de_nod_get_local_transform(node, &folded);
+		de_scene_tests_fbx_chain(node, &chain);
+		for (int k = 0; k < 16; ++k) {
+			DE_ASSERT(fabsf(folded.f[k] - chain.f[k]) < 1e-4f);
+		}
+
+		/* de_mat4_trs is T * R * S */
+		de_mat4_t trs, t, r, sc;
+		de_mat4_trs(&trs, &position, &rotation, &scale);
+		de_mat4_translation(&t, &position);
+		de_mat4_rotation(&r, &rotation);
+		de_mat4_scale(&sc, &scale);
+		de_mat4_mul(&chain, &t, &r);
+		de_mat4_mul(&chain, &chain, &sc);
+		for (int k = 0; k < 16; ++k) {
+			DE_ASSERT(fabsf(trs.f[k] - chain.f[k]) < 1e-5f);
+		}
+
+		de_node_free(node);
+	}
+	de_scene_free(s);
+}
+
+static size_t de_scene_tests_count_subtree(const de_node_t* node)
+{
+	size_t count = 1;
+	for (size_t i = 0; i < node->children.size; ++i) {
+		count += de_scene_tests_count_subtree(node->children.data[i]);
+	}
+	return count;
+}
+
+/* world matrix of every node must be product of world matrix of parent and its local matrix */
+static void de_scene_tests_check_world_matrices(de_scene_t* s)
+{
+	DE_LINKED_LIST_FOR_EACH_T(de_node_t*, node, s->nodes)
+	{
+		de_mat4_t expected = node->local_matrix;
+		if (node->parent) {
+			de_mat4_mul(&expected, &node->parent->global_matrix, &node->local_matrix);
+		}
+		for (int k = 0; k < 16; ++k) {
+			DE_ASSERT(fabsf(node->global_matrix.f[k] - expected.f[k]) < 1e-3f);
+		}
+	}
+}
+
+static void de_scene_tests_transform_hierarchy(de_core_t* core)
+{
+	/* same wide tree in two scenes, one is updated by calling thread, other one on thread pool;
+	 * levels are big enough to be split between threads */
+	const size_t node_count = 5000;
+	de_thread_pool_t* pool = de_thread_pool_create(3);
+	de_scene_t* serial = de_scene_create(core);
+	de_scene_t* parallel = de_scene_create(core);
+	de_node_t** serial_nodes = de_malloc(node_count * sizeof(*serial_nodes));
+	de_node_t** parallel_nodes = de_malloc(node_count * sizeof(*parallel_nodes));
+	for (size_t i = 0; i < node_count; ++i) {
+		de_vec3_t position = de_scene_tests_random_vector(-1.0f, 1.0f);
+		de_quat_t rotation = de_scene_tests_random_rotation();
+		serial_nodes[i] = de_node_create(serial, DE_NODE_TYPE_BASE);
+		parallel_nodes[i] = de_node_create(parallel, DE_NODE_TYPE_BASE);
+		de_node_set_local_position(serial_nodes[i], &position);
+		de_node_set_local_position(parallel_nodes[i], &position);
+		de_node_set_local_rotation(serial_nodes[i], &rotation);
+		de_node_set_local_rotation(parallel_nodes[i], &rotation);
+		if (i >= 4) {
+			de_node_attach(serial_nodes[i], serial_nodes[i / 4 - 1]);
+			de_node_attach(parallel_nodes[i], parallel_nodes[i / 4 - 1]);
+		}
+	}
+
+	de_node_t* moved = serial_nodes[5];
+	de_node_t* detached = serial_nodes[40];
+	de_node_t* new_parent = serial_nodes[3];
+	for (int step = 0; step < 5; ++step) {
+		size_t expected_count = 0;
+		switch (step) {
+			case 0:
+				/* everything is new */
+				expected_count = node_count;
+				break;
+			case 1:
+				/* idle scene */
+				expected_count = 0;
+				break;
+			case 2:
+				/* moved parent drags its descendants */
+				de_node_set_local_position(moved, &(de_vec3_t) { 1, 2, 3 });
+				de_node_set_local_position(parallel_nodes[5], &(de_vec3_t) { 1, 2, 3 });
+				expected_count = de_scene_tests_count_subtree(moved);
+				break;
+			case 3:
+				de_node_detach(detached);
+				de_node_detach(parallel_nodes[40]);
+				expected_count = de_scene_tests_count_subtree(detached);
+				break;
+			case 4:
+				de_node_attach(detached, new_parent);
+				de_node_attach(parallel_nodes[40], parallel_nodes[3]);
+				expected_count = de_scene_tests_count_subtree(detached);
+				break;
+		}
+		DE_ASSERT(de_scene_update_transform_hierarchy(serial, NULL) == expected_count);
+		DE_ASSERT(de_scene_update_transform_hierarchy(parallel, pool) == expected_count);
+		de_scene_tests_check_world_matrices(serial);
+		/* same math in same order, results must be exactly the same */
+		for (size_t i = 0; i < node_count; ++i) {
+			DE_ASSERT(memcmp(&serial_nodes[i]->global_matrix, &parallel_nodes[i]->global_matrix, sizeof(de_mat4_t)) == 0);
+		}
+	}
+	DE_ASSERT(detached->parent == new_parent);
+
+	de_free(serial_nodes);
+	de_free(parallel_nodes);
+	de_scene_free(serial);
+	de_scene_free(parallel);
+	de_thread_pool_free(pool);
+}
+
+static void de_scene_tests_bodies(de_core_t* core)
+{
+	/* nodes of bodies that do not move must not be updated, nodes of moving ones are updated together
+	 * with their children */
+	const size_t body_count = 100;
+	const double dt = 1.0 / 60.0;
+	de_scene_t* s = de_scene_create(core);
+	de_body_t** bodies = de_malloc(body_count * sizeof(*bodies));
+	for (size_t i = 0; i < body_count; ++i) {
+		bodies[i] = de_body_create(s, de_convex_shape_create_sphere(0.5f));
+		de_body_set_position(bodies[i], &(de_vec3_t) { 3.0f * i, 10.0f, 0.0f });
+		de_node_t* node = de_node_create(s, DE_NODE_TYPE_BASE);
+		de_node_set_body(node, bodies[i]);
+		de_node_t* child = de_node_create(s, DE_NODE_TYPE_BASE);
+		de_node_attach(child, node);
+	}
+	de_scene_update(s, dt);
+	DE_ASSERT(de_scene_get_transform_update_count(s) == 2 * body_count);
+	de_scene_update(s, dt);
+	DE_ASSERT(de_scene_get_transform_update_count(s) == 0);
+
+	/* sleeping bodies are not stepped */
+	for (size_t i = 0; i < body_count; ++i) {
+		bodies[i]->sleeping = true;
+	}
+	de_physics_step_scene(s, NULL, dt);
+	de_scene_update(s, dt);
+	DE_ASSERT(de_scene_get_transform_update_count(s) == 0);
+
+	/* woken up body falls */
+	de_body_wake_up(bodies[7]);
+	de_physics_step_scene(s, NULL, dt);
+	de_scene_update(s, dt);
+	DE_ASSERT(de_scene_get_transform_update_count(s) == 2);
+	de_scene_tests_check_world_matrices(s);
+
+	de_free(bodies);
+	de_scene_free(s);
+}
+
+void de_scene_tests(de_core_t* core)
+{
+	de_scene_tests_names(core);
+	de_scene_tests_local_transform(core);
+	de_scene_tests_transform_hierarchy(core);
+	de_scene_tests_bodies(core);
 }
\ No newline at end of file
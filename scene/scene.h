@@ -19,6 +19,38 @@
 * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
 * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
 
+/**
+ * @brief Flattened node hierarchy of scene used to update transforms in one linear pass instead of
+ * recursion over children of every node. Arrays are parallel, i-th element of each belongs to i-th slot.
+ * Slots are sorted breadth-first, so parent slot always precedes slots of its children. Rebuilt
+ * only when hierarchy changes (nodes are added, removed, attached or detached), each node stores
+ * index of its slot in transform_slot.
+ */
+typedef struct de_transform_hierarchy_t {
+	DE_ARRAY_DECLARE(de_node_t*, nodes);
+	DE_ARRAY_DECLARE(uint32_t, parents); /**< Slot of parent node, DE_NODE_NO_SLOT for root nodes. */
+	DE_ARRAY_DECLARE(de_mat4_t, world_matrices);
+	DE_ARRAY_DECLARE(uint8_t, dirty); /**< Non-zero if local transform of node changed since last update. */
+	DE_ARRAY_DECLARE(size_t, levels); /**< First slot of every depth level plus total amount of slots. Slots of one level are independent. */
+	bool need_rebuild;
+} de_transform_hierarchy_t;
+
+typedef struct de_node_name_bucket_t {
+	de_node_t* head;
+	de_node_t* tail; /**< Nodes are appended when added or renamed, so nodes with same name keep that order. */
+} de_node_name_bucket_t;
+
+/**
+ * @brief Hash index of names of scene nodes. Chained hash table, chains are intrusive (see
+ * name_index_next of de_node_t), so nodes with same name form multi-map entry. Maintained by
+ * de_scene_add_node, de_scene_remove_node and de_node_set_name.
+ */
+typedef struct de_node_name_index_t {
+	DE_ARRAY_DECLARE(de_node_name_bucket_t, buckets); /**< Amount of buckets is power of two. */
+	size_t count;
+	uint64_t next_order; /**< Source of name_order of nodes. */
+} de_node_name_index_t;
+
 struct de_scene_t {
 	de_resource_t* res; /**< Resource which contains this scene. When not NULL, scene will be ignored in all calculations. */
 	de_core_t* core;
@@ -27,6 +59,16 @@ struct de_scene_t {
 	DE_LINKED_LIST_DECLARE(de_static_geometry_t, static_geometries);
 	DE_LINKED_LIST_DECLARE(de_animation_t, animations);
 	de_node_t* active_camera;
+	de_broadphase_t broadphase;
+	DE_ARRAY_DECLARE(de_body_t*, physics_bodies); /**< Scratch array of bodies used by physics step. */
+	de_physics_stats_t physics_stats; /**< Statistics of last physics step. */
+	de_physics_clock_t physics_clock;
+	uint32_t physics_step_index; /**< Incremented each physics step, used to find stale contact cache entries. */
+	de_transform_hierarchy_t transform_hierarchy;
+	de_node_name_index_t node_name_index;
+	size_t transform_update_count; /**< Amount of nodes whose transforms were recalculated by last update. */
+	DE_ARRAY_DECLARE(de_node_t*, particle_systems); /**< Scratch array of particle system nodes used by update. */
+	float update_dt; /**< Time step of current update, read by update jobs. */
 	DE_LINKED_LIST_ITEM(de_scene_t);
 };
 
@@ -51,6 +93,23 @@ de_static_geometry_t* de_scene_create_static_geometry(de_scene_t* s);
  */
 void de_scene_free_static_geometry(de_scene_t* s, de_static_geometry_t* geom);
 
+/**
+ * @brief Returns statistics of last physics step of scene.
+ */
+const de_physics_stats_t* de_scene_get_physics_stats(const de_scene_t* s);
+
+/**
+ * @brief Returns amount of nodes whose transforms were recalculated by last @ref de_scene_update.
+ * Nodes which did not move (and whose ancestors did not move) are not recalculated.
+ */
+size_t de_scene_get_transform_update_count(const de_scene_t* s);
+
+/**
+ * @brief Internal. Marks flattened transform hierarchy of scene as outdated, it will be rebuilt
+ * on next update. Called when node is added, removed, attached or detached.
+ */
+void de_scene_invalidate_transform_hierarchy(de_scene_t* s);
+
 /**
  * @brief Adds node to scene. Only attached nodes can interact and be renderered.
  */
@@ -63,10 +122,28 @@ void de_scene_add_node(de_scene_t* s, de_node_t* handle);
 void de_scene_remove_node(de_scene_t* s, de_node_t* handle);
 
 /**
- * @brief Tries to find a node with specified name. Performs linear search O(n).
+ * @brief Tries to find a node with specified name using hash index of names, O(1) on average. If
+ * there are several nodes with such name, node that was first added to scene or renamed to that name
+ * is returned, others can be enumerated with @ref de_scene_find_next_node.
  */
 de_node_t* de_scene_find_node(const de_scene_t* s, const char* name);
 
+/**
+ * @brief Returns next node of scene with the same name as specified node (in order of addition to
+ * scene or renaming) or NULL if there is no more such nodes.
+ */
+de_node_t* de_scene_find_next_node(const de_node_t* node);
+
+/**
+ * @brief Internal. Adds node to hash index of names of scene.
+ */
+void de_scene_index_node_name(de_scene_t* s, de_node_t* node);
+
+/**
+ * @brief Internal. Removes node from hash index of names of scene.
+ */
+void de_scene_unindex_node_name(de_scene_t* s, de_node_t* node);
+
 /**
  * @brief Returns head node in the linked list of scene nodes. Typical usage is 
  * to iterate over all nodes like this:
@@ -76,8 +153,16 @@ de_node_t* de_scene_find_node(const de_scene_t* s, const char* name);
 de_node_t* de_scene_get_first_node(de_scene_t* s);
 
 /**
- * @brief Update scene components (i.e. animations)
+ * @brief Update scene components (i.e. animations). Work is split between threads of core thread
+ * pool: tracks of every animation, particle systems and nodes of every level of transform hierarchy
+ * are processed in parallel. Small jobs are done by calling thread.
  */
 void de_scene_update(de_scene_t* s, double dt);
 
-bool de_scene_visit(de_object_visitor_t* visitor, de_scene_t* scene);
\ No newline at end of file
+bool de_scene_visit(de_object_visitor_t* visitor, de_scene_t* scene);
+
+/**
+ * @brief Runs tests of scene: hash index of names, search of nodes, local transforms of nodes and
+ * update of transform hierarchy.
+ */
+void de_scene_tests(de_core_t* core);
\ No newline at end of file